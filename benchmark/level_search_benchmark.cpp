@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "level_search.hpp"
+
+namespace
+{
+
+// Bid side with `depth` levels, one tick apart, best at the end. Lookups are skewed towards the top of the book like real traffic.
+struct LevelSearchFixture {
+    std::vector<std::int32_t> prices;
+    std::vector<std::int32_t> lookups;
+
+    explicit LevelSearchFixture(std::size_t depth)
+    {
+        prices.resize(depth);
+        for (std::size_t i = 0; i < depth; ++i) {
+            prices[i] = 10'000 + static_cast<std::int32_t>(i);
+        }
+
+        std::mt19937 rng(42);
+        std::geometric_distribution<std::size_t> distance_from_top(8.0 / static_cast<double>(depth));
+        lookups.resize(4096);
+        for (auto& lookup : lookups) {
+            lookup = prices[depth - 1 - std::min(distance_from_top(rng), depth - 1)];
+        }
+    }
+};
+
+void runLevelSearch(benchmark::State& state, algocor::LevelSearchFn search)
+{
+    const LevelSearchFixture fixture(static_cast<std::size_t>(state.range(0)));
+
+    std::size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(search(fixture.prices.data(), fixture.prices.size(), fixture.lookups[i++ & 4095]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LevelSearchScalar(benchmark::State& state)
+{
+    runLevelSearch(state, &algocor::findPriceLevelScalar);
+}
+
+void BM_LevelSearchAvx2(benchmark::State& state)
+{
+    if (algocor::detectSimdLevel() == algocor::SimdLevel::Scalar) {
+        state.SkipWithError("AVX2 not supported on this CPU");
+        return;
+    }
+    runLevelSearch(state, &algocor::findPriceLevelAvx2);
+}
+
+void BM_LevelSearchAvx512(benchmark::State& state)
+{
+    if (algocor::detectSimdLevel() != algocor::SimdLevel::Avx512) {
+        state.SkipWithError("AVX-512 not supported on this CPU");
+        return;
+    }
+    runLevelSearch(state, &algocor::findPriceLevelAvx512);
+}
+
+void BM_LevelSearchDispatched(benchmark::State& state)
+{
+    runLevelSearch(state, &algocor::findPriceLevel);
+}
+
+}  // namespace
+
+BENCHMARK(BM_LevelSearchScalar)->Arg(5)->Arg(50)->Arg(500);
+BENCHMARK(BM_LevelSearchAvx2)->Arg(5)->Arg(50)->Arg(500);
+BENCHMARK(BM_LevelSearchAvx512)->Arg(5)->Arg(50)->Arg(500);
+BENCHMARK(BM_LevelSearchDispatched)->Arg(5)->Arg(50)->Arg(500);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,130 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "level_stores.hpp"
+#include "tick_ladder.hpp"
+
+namespace
+{
+
+// Level updates as the book builder issues them, recorded once per profile and replayed into every policy.
+struct LevelOp {
+    enum class Kind : std::uint8_t
+    {
+        Add,
+        Execute,
+        Delete,
+    } kind;
+    bool is_bid;
+    std::int32_t price;
+    std::uint64_t qty;
+};
+
+enum Profile : std::int64_t
+{
+    ThinEquity = 0,  // ~10 levels per side, most traffic on the touch.
+    DeepFuture = 1,  // a few hundred levels per side.
+};
+
+// Simulates resting orders so that every execute / delete refers to a live order, like a real ITCH stream.
+std::vector<LevelOp> recordSequence(Profile profile)
+{
+    struct LiveOrder {
+        bool is_bid;
+        std::int32_t price;
+        std::uint64_t qty;
+    };
+
+    const double mean_distance = profile == ThinEquity ? 3.0 : 120.0;
+    const std::int32_t mid = 100'000;
+
+    std::mt19937 rng(profile == ThinEquity ? 7 : 11);
+    std::geometric_distribution<std::int32_t> distance(1.0 / mean_distance);
+    std::vector<LiveOrder> live;
+    std::vector<LevelOp> ops;
+    ops.reserve(200'000);
+
+    while (ops.size() < 200'000) {
+        const auto dice = rng() % 100;
+        if (dice < 50 || live.size() < 64) {
+            const bool is_bid = (rng() & 1) != 0;
+            const auto offset = 1 + distance(rng);
+            const LiveOrder order { is_bid, is_bid ? mid - offset : mid + offset, 1 + rng() % 500 };
+            live.push_back(order);
+            ops.push_back({ LevelOp::Kind::Add, order.is_bid, order.price, order.qty });
+            continue;
+        }
+
+        const auto index = rng() % live.size();
+        auto& order = live[index];
+        if (dice < 75) {
+            const auto qty = 1 + rng() % order.qty;
+            ops.push_back({ LevelOp::Kind::Execute, order.is_bid, order.price, qty });
+            order.qty -= qty;
+        } else {
+            ops.push_back({ LevelOp::Kind::Delete, order.is_bid, order.price, order.qty });
+            order.qty = 0;
+        }
+
+        if (order.qty == 0) {
+            order = live.back();
+            live.pop_back();
+        }
+    }
+
+    return ops;
+}
+
+const std::vector<LevelOp>& recordedSequence(Profile profile)
+{
+    static const std::vector<LevelOp> thin = recordSequence(ThinEquity);
+    static const std::vector<LevelOp> deep = recordSequence(DeepFuture);
+    return profile == ThinEquity ? thin : deep;
+}
+
+template<typename Policy>
+void BM_LevelStoreReplay(benchmark::State& state)
+{
+    using Bids = typename Policy::template Side<true>;
+    using Asks = typename Policy::template Side<false>;
+
+    const auto& ops = recordedSequence(static_cast<Profile>(state.range(0)));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto bids = std::make_unique<Bids>();
+        auto asks = std::make_unique<Asks>();
+        state.ResumeTiming();
+
+        for (const auto& op : ops) {
+            if (op.kind == LevelOp::Kind::Add) {
+                op.is_bid ? bids->add(op.price, op.qty) : asks->add(op.price, op.qty);
+            } else {
+                benchmark::DoNotOptimize(op.is_bid ? bids->remove(op.price, op.qty) : asks->remove(op.price, op.qty));
+            }
+        }
+        benchmark::DoNotOptimize(bids->size() + asks->size());
+
+        state.PauseTiming();
+        bids.reset();
+        asks.reset();
+        state.ResumeTiming();
+    }
+
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(ops.size()));
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_LevelStoreReplay, algocor::SortedVectorPolicy)->Arg(ThinEquity)->Arg(DeepFuture);
+BENCHMARK_TEMPLATE(BM_LevelStoreReplay, algocor::BranchlessBinaryPolicy)->Arg(ThinEquity)->Arg(DeepFuture);
+BENCHMARK_TEMPLATE(BM_LevelStoreReplay, algocor::BPlusTreePolicy)->Arg(ThinEquity)->Arg(DeepFuture);
+BENCHMARK_TEMPLATE(BM_LevelStoreReplay, algocor::FixedArrayPolicy<1024>)->Arg(ThinEquity)->Arg(DeepFuture);
+BENCHMARK_TEMPLATE(BM_LevelStoreReplay, algocor::TickLadderPolicy)->Arg(ThinEquity)->Arg(DeepFuture);
+BENCHMARK_TEMPLATE(BM_LevelStoreReplay, algocor::TopNPolicy<>)->Arg(ThinEquity)->Arg(DeepFuture);
+
+BENCHMARK_MAIN();
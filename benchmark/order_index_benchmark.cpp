@@ -0,0 +1,116 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "order_index.hpp"
+
+namespace
+{
+
+// Payload of ItchOrder without the key, what the builder looks up on an execution or a delete.
+struct RestingOrder {
+    std::int32_t price;
+    std::uint64_t left_qty;
+};
+
+// The index OrderbookBuilder used before FlatOrderIndex.
+class MapIndex {
+    std::map<std::tuple<std::uint32_t, std::uint64_t, char>, RestingOrder> m_orders;
+
+public:
+    void insert(const algocor::OrderKey& key, const RestingOrder& order)
+    {
+        m_orders[{ key.orderbook_id, key.order_id, key.side }] = order;
+    }
+
+    std::uint64_t executeAndDelete(const algocor::OrderKey& key)
+    {
+        auto it = m_orders.find({ key.orderbook_id, key.order_id, key.side });
+        const auto qty = it->second.left_qty;
+        m_orders.erase(it);
+        return qty;
+    }
+
+    void prefetch(const algocor::OrderKey&) const
+    {
+    }
+};
+
+class FlatIndex {
+    algocor::FlatOrderIndex<RestingOrder> m_orders;
+
+public:
+    void insert(const algocor::OrderKey& key, const RestingOrder& order)
+    {
+        m_orders.insert(key, order);
+    }
+
+    std::uint64_t executeAndDelete(const algocor::OrderKey& key)
+    {
+        auto* entry = m_orders.find(key);
+        const auto qty = entry->value.left_qty;
+        m_orders.erase(entry);
+        return qty;
+    }
+
+    void prefetch(const algocor::OrderKey& key) const
+    {
+        m_orders.prefetch(key);
+    }
+};
+
+// Keeps range(0) orders live across 200 books: every step removes a random live order and adds a fresh one, the steady state of a
+// session. With Prefetch the key of the next step is prefetched first, like the parser does for the next message of a packet.
+template<typename Index, bool Prefetch>
+void BM_OrderIndexChurn(benchmark::State& state)
+{
+    const auto live_count = static_cast<std::size_t>(state.range(0));
+
+    std::mt19937_64 rng(5);
+    std::vector<algocor::OrderKey> live;
+    live.reserve(live_count);
+    auto index = std::make_unique<Index>();
+
+    std::uint64_t next_id = 1;
+    const auto new_key = [&]() {
+        return algocor::OrderKey { next_id++, static_cast<std::uint32_t>(rng() % 200), (rng() & 1) != 0 ? 'B' : 'S' };
+    };
+
+    for (std::size_t i = 0; i < live_count; ++i) {
+        live.push_back(new_key());
+        index->insert(live.back(), { 1'000, 100 });
+    }
+
+    // Victims drawn ahead of time so the timed loop measures the index, not the generator.
+    std::vector<std::size_t> victims(1 << 16);
+    for (auto& victim : victims) {
+        victim = rng() % live_count;
+    }
+
+    std::size_t step = 0;
+    for (auto _ : state) {
+        const auto slot = victims[step++ & (victims.size() - 1)];
+        if constexpr (Prefetch) {
+            index->prefetch(live[victims[step & (victims.size() - 1)]]);
+        }
+
+        benchmark::DoNotOptimize(index->executeAndDelete(live[slot]));
+        live[slot] = new_key();
+        index->insert(live[slot], { 1'000, 100 });
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_OrderIndexChurn, MapIndex, false)->Arg(100'000)->Arg(1'000'000)->Arg(10'000'000);
+BENCHMARK_TEMPLATE(BM_OrderIndexChurn, FlatIndex, false)->Arg(100'000)->Arg(1'000'000)->Arg(10'000'000);
+BENCHMARK_TEMPLATE(BM_OrderIndexChurn, FlatIndex, true)->Arg(100'000)->Arg(1'000'000)->Arg(10'000'000);
+
+BENCHMARK_MAIN();
@@ -68,6 +68,54 @@ MarketDataClient::MarketDataClient(const MarketDataPartitionConfig& config)
         config.unicast_request_port,
         config.unicast_destination_ip,
         config.unicast_destination_port);
+
+    if (config.book_shard_cpus.empty()) {
+        m_builder.reserveOrders(protocol::itch::ConcreteOrderbookBuilder::EXPECTED_LIVE_ORDERS);
+        m_builder.setBookOrderReserve(config.book_order_reserve);
+        m_itchParser.setBatchDecode(config.batch_decode);
+        attachVerifier(m_builder);
+    } else {
+        if (config.batch_decode) {
+            LOG_WARNING("Partition {} builds its books on shards, batch decode ignored", config.name);
+        }
+        const auto shard_count = config.book_shard_cpus.size();
+        m_shardRouter = std::make_unique<protocol::itch::ItchShardRouter<protocol::itch::ConcreteOrderbookBuilder>>(shard_count);
+        for (std::size_t shard = 0; shard < shard_count; ++shard) {
+            m_shardRouter->builder(shard)->reserveOrders(protocol::itch::ConcreteOrderbookBuilder::EXPECTED_LIVE_ORDERS / shard_count);
+            m_shardRouter->builder(shard)->setBookOrderReserve(config.book_order_reserve);
+            attachVerifier(*m_shardRouter->builder(shard));
+        }
+        m_shardRouter->start(config.book_shard_cpus);
+        LOG_INFO("Partition {} builds its books on {} shards", config.name, shard_count);
+    }
+
+    if (config.subscriptions_enabled) {
+        for (const auto& symbol : config.subscribed_symbols) {
+            m_subscriptions.subscribeSymbol(symbol);
+        }
+        for (const auto orderbook_id : config.subscribed_orderbook_ids) {
+            if (!m_subscriptions.subscribe(orderbook_id)) {
+                LOG_ERROR("Cannot subscribe to orderbook {} on partition {}", orderbook_id, config.name);
+            }
+        }
+        m_itchParser.setSubscriptions(&m_subscriptions);
+        if (m_shardRouter) {
+            m_shardRouter->setSubscriptions(&m_subscriptions);
+        }
+    }
+}
+
+// Each builder records into a verifier of its own, the verifier's ring has one producer. Called before the builder sees a message.
+void MarketDataClient::attachVerifier(protocol::itch::ConcreteOrderbookBuilder& builder)
+{
+    if (!m_config.verifier_enabled) {
+        return;
+    }
+
+    const auto& verifier = m_verifiers.emplace_back(std::make_unique<BookVerifier>());
+    verifier->start(m_config.verifier_cpu);
+    builder.setVerifier(verifier.get());
+    LOG_INFO("Book verifier {} of partition {} runs on cpu {}", m_verifiers.size(), m_config.name, m_config.verifier_cpu);
 }
 
 void MarketDataClient::run()
@@ -95,6 +143,25 @@ void MarketDataClient::run()
     return m_config;
 }
 
+SubscriptionFilter& MarketDataClient::subscriptions()
+{
+    return m_subscriptions;
+}
+
+uint64_t MarketDataClient::filteredMessages() const
+{
+    return m_shardRouter ? m_shardRouter->filteredMessages() : m_itchParser.filteredMessages();
+}
+
+void MarketDataClient::setOwnOrders(OwnOrderMap* own_orders)
+{
+    if (m_shardRouter) {
+        LOG_WARNING("Queue positions are not tracked on sharded partition {}", m_config.name);
+        return;
+    }
+    m_builder.setOwnOrders(own_orders);
+}
+
 void MarketDataClient::setState(State state)
 {
     if (m_state == state) {
@@ -123,7 +190,7 @@ void MarketDataClient::setSessionName(const std::array<char, 10>& session_name)
 void MarketDataClient::parse(const char* buffer, size_t size)
 {
     // Will be processing incoming packets here no matter what the our state is.
-    const auto& [sequence_number, message_count] = m_itchParser.parse(buffer, size);
+    const auto& [sequence_number, message_count] = m_shardRouter ? m_shardRouter->parse(buffer, size) : m_itchParser.parse(buffer, size);
 
     // Rewinding.
     if (m_state == State::Rewinding) [[unlikely]] {
@@ -250,6 +317,11 @@ void MarketDataClient::rewind(const RewindRequest& rewind_request)
 void MarketDataClient::processRewoundPackets(const protocol::moldudp64::DownstreamHeader& header)
 {
     LOG_TRACE_L3("Processing rewound packets...");
+    if (m_shardRouter) {
+        m_shardRouter->routePayload(
+            reinterpret_cast<const char*>(&header), be16toh(header.message_count), be64toh(header.sequence_number));
+        return;
+    }
     m_itchParser.parsePayload(reinterpret_cast<const char*>(&header), be16toh(header.message_count), be64toh(header.sequence_number));
 }
 
@@ -11,8 +11,14 @@
 #include "../utility/config_parser.hpp"
 #include "../utility/overwrite_macros.hpp"
 
+#include "../core/book_verifier.hpp"
 #include "../core/orderbook_builder.hpp"
+#include "../core/subscription_filter.hpp"
 #include "../protocol/itch/itch_parser.hpp"
+#include "../protocol/itch/itch_shard_router.hpp"
+
+#include <memory>
+#include <vector>
 
 // TODO: ADD A CODE TO SANITY CHECK THAT ALL SEQUENCE NUMBERS UP TO THIS POINT ARE RECEIVED. ENABLE THIS ONLY FOR DEBUG BUILDS.
 namespace algocor
@@ -41,9 +47,22 @@ public:
     [[nodiscard]] SequenceGapParseResult calculateNextSequenceNumber(uint64_t received_sequence_number, uint16_t message_count);
     [[nodiscard]] MarketDataPartitionConfig getPartitionConfig() const;
 
+    // Books of this partition that are built, can be changed while the client runs. A book subscribed mid-session only sees orders
+    // added from then on.
+    [[nodiscard]] SubscriptionFilter& subscriptions();
+    [[nodiscard]] uint64_t filteredMessages() const;
+
+    // Tracks the queue position of the orders in `own_orders`, call before run(). Not supported on sharded partitions.
+    void setOwnOrders(OwnOrderMap* own_orders);
+
 private:
+    // One per builder when the partition verifies its books, declared first so the builders are gone before them.
+    std::vector<std::unique_ptr<BookVerifier>> m_verifiers;
     protocol::itch::ConcreteOrderbookBuilder m_builder;
+    SubscriptionFilter m_subscriptions;
     protocol::itch::ItchParser<protocol::itch::ConcreteOrderbookBuilder> m_itchParser;
+    // Set in sharded mode, the books are then built by its workers and m_builder stays empty.
+    std::unique_ptr<protocol::itch::ItchShardRouter<protocol::itch::ConcreteOrderbookBuilder>> m_shardRouter;
     MarketDataPartitionConfig m_config;
     UdpMulticastSocket m_multicastSocket;
     // UdpUnicastSocket m_rewinderSocket;
@@ -68,6 +87,7 @@ private:
     } m_state
         = State::Initial;
 
+    void attachVerifier(protocol::itch::ConcreteOrderbookBuilder& builder);
     void setState(State state);
     void setSessionName(const std::array<char, 10>& session_name);
     void parse(const char* buffer, size_t size);
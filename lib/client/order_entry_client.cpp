@@ -219,6 +219,11 @@ void BistMarketAccessor::sendCancelOrder(const std::array<char, 14>& original_or
     LOG_TRACE_L3("<= Sent cancel order: {}. Partititon: {}", *cancel_order, m_partitionDefinition);
 }
 
+OwnOrderMap& BistMarketAccessor::ownOrders()
+{
+    return m_orderManager.ownOrders();
+}
+
 void BistMarketAccessor::onLoginAccepted(protocol::soupbintcp::LoginAccepted& login_accepted)
 {
     const auto prev_state = m_state;
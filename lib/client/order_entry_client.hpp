@@ -44,6 +44,9 @@ public:
     void sendReplaceOrder(const std::array<char, 14>& original_order_token, int32_t price);
     void sendCancelOrder(const std::array<char, 14>& original_order_token);
 
+    // Accepted orders of this session, see MarketDataClient::setOwnOrders().
+    [[nodiscard]] OwnOrderMap& ownOrders();
+
 private:
     OrderEntryPartitionConfig m_partition;
     std::string m_clientAccount;
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../utility/spsc_ring.hpp"
+
+namespace algocor
+{
+
+// A visible level of a book changed. `level` 0 is the top of the book; a level that is no longer populated (the side got thinner) is
+// reported with price 0 and qty 0.
+struct BookEvent {
+    enum class Kind : uint8_t
+    {
+        Bbo,    // level 0 changed
+        Depth,  // a deeper visible level changed
+    };
+
+    uint32_t orderbook_id;
+    int32_t price;
+    uint64_t qty;
+    Kind kind;
+    char side;
+    uint8_t level;
+};
+
+static_assert(sizeof(BookEvent) == 24);
+
+// Single producer (the book builder), single consumer (a strategy, possibly on another thread).
+template<std::size_t Capacity = 4096>
+using BookEventRing = SpscRing<BookEvent, Capacity>;
+
+}  // namespace algocor
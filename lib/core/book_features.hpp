@@ -0,0 +1,165 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+#include "level_stores.hpp"
+
+namespace algocor
+{
+
+// Microstructure features a BasicL2Orderbook can maintain as it is updated. Combine with |, books pay only for what they select.
+enum BookFeature : unsigned
+{
+    NO_BOOK_FEATURES = 0,
+    FEATURE_MICRO_PRICE = 1U << 0,           // size weighted mid of the best levels.
+    FEATURE_TOP_IMBALANCE = 1U << 1,         // (bid - ask) / (bid + ask) quantity over the top levels.
+    FEATURE_ORDER_FLOW_IMBALANCE = 1U << 2,  // Cont, Kukanov, Stoikov - The Price Impact of Order Book Events.
+    FEATURE_DEPTH_TO_PRICE = 1U << 3,        // cumulative quantity from the top of the book down to a price.
+};
+
+// Feature state of one book. Each side keeps a copy of its top levels that is adjusted in place when an update only changes the
+// quantity of one of them, and re-read from the level store (TopDepth levels) only when a level enters or leaves the top. Updates below
+// the top levels do not touch it at all.
+template<unsigned Features, std::size_t TopDepth = 5>
+class BookFeatureState {
+    static constexpr bool NEEDS_DEPTH = (Features & (FEATURE_TOP_IMBALANCE | FEATURE_DEPTH_TO_PRICE)) != 0;
+    static constexpr std::size_t DEPTH = NEEDS_DEPTH ? TopDepth : 1;
+
+    struct TopLevels {
+        std::array<int32_t, DEPTH> prices {};
+        std::array<uint64_t, DEPTH> qtys {};
+        std::size_t count { 0 };
+        uint64_t total { 0 };  // sum of qtys.
+
+        [[nodiscard]] int32_t bestPrice(int32_t empty) const
+        {
+            return count != 0 ? prices[0] : empty;
+        }
+
+        [[nodiscard]] uint64_t bestQty() const
+        {
+            return count != 0 ? qtys[0] : 0;
+        }
+    };
+
+    TopLevels m_bids;
+    TopLevels m_asks;
+    int64_t m_orderFlowImbalance { 0 };
+
+    template<bool IsBid>
+    void addOrderFlow(int32_t old_price, uint64_t old_qty, const TopLevels& top)
+    {
+        const auto price = top.bestPrice(IsBid ? INT32_MIN : INT32_MAX);
+        const auto qty = static_cast<int64_t>(top.bestQty());
+        if constexpr (IsBid) {
+            m_orderFlowImbalance += (price >= old_price ? qty : 0) - (price <= old_price ? static_cast<int64_t>(old_qty) : 0);
+        } else {
+            m_orderFlowImbalance += (price >= old_price ? static_cast<int64_t>(old_qty) : 0) - (price <= old_price ? qty : 0);
+        }
+    }
+
+public:
+    // Call after an update that changed the quantity at `price` by `delta`. `level_set_changed` is true when the update created or
+    // removed a level.
+    template<bool IsBid, typename Levels>
+    void onLevelUpdate(const Levels& levels, int32_t price, int64_t delta, bool level_set_changed)
+    {
+        auto& top = IsBid ? m_bids : m_asks;
+
+        // Checked against the top as it was before the update, see BasicL2Orderbook::PublishVisibleChanges().
+        if (top.count == DEPTH && isBetterPrice<IsBid>(top.prices[DEPTH - 1], price)) [[likely]] {
+            return;
+        }
+
+        const auto old_price = top.bestPrice(IsBid ? INT32_MIN : INT32_MAX);
+        const auto old_qty = top.bestQty();
+
+        if (!level_set_changed) {
+            for (std::size_t level = 0; level < top.count; ++level) {
+                if (top.prices[level] == price) {
+                    top.qtys[level] += static_cast<uint64_t>(delta);
+                    top.total += static_cast<uint64_t>(delta);
+                    break;
+                }
+            }
+        } else {
+            top.count = levels.top(DEPTH, top.prices.data(), top.qtys.data());
+            top.total = 0;
+            for (std::size_t level = 0; level < top.count; ++level) {
+                top.total += top.qtys[level];
+            }
+        }
+
+        if constexpr ((Features & FEATURE_ORDER_FLOW_IMBALANCE) != 0) {
+            addOrderFlow<IsBid>(old_price, old_qty, top);
+        }
+    }
+
+    // Size weighted mid, 0 when a side is empty.
+    [[nodiscard]] double microPrice() const
+        requires((Features & FEATURE_MICRO_PRICE) != 0)
+    {
+        if (m_bids.count == 0 || m_asks.count == 0) {
+            return 0.0;
+        }
+
+        const auto bid_qty = static_cast<double>(m_bids.qtys[0]);
+        const auto ask_qty = static_cast<double>(m_asks.qtys[0]);
+        return (m_bids.prices[0] * ask_qty + m_asks.prices[0] * bid_qty) / (bid_qty + ask_qty);
+    }
+
+    // In [-1, 1] over the top TopDepth levels of each side, positive when bids dominate.
+    [[nodiscard]] double topImbalance() const
+        requires((Features & FEATURE_TOP_IMBALANCE) != 0)
+    {
+        const auto total = m_bids.total + m_asks.total;
+        if (total == 0) {
+            return 0.0;
+        }
+        return (static_cast<double>(m_bids.total) - static_cast<double>(m_asks.total)) / static_cast<double>(total);
+    }
+
+    // Accumulated since construction or the last reset, positive when flow is buying pressure.
+    [[nodiscard]] int64_t orderFlowImbalance() const
+        requires((Features & FEATURE_ORDER_FLOW_IMBALANCE) != 0)
+    {
+        return m_orderFlowImbalance;
+    }
+
+    void resetOrderFlowImbalance()
+        requires((Features & FEATURE_ORDER_FLOW_IMBALANCE) != 0)
+    {
+        m_orderFlowImbalance = 0;
+    }
+
+    // Quantity available on `side` at `price` or better, within the top TopDepth levels.
+    [[nodiscard]] uint64_t depthToPrice(char side, int32_t price) const
+        requires((Features & FEATURE_DEPTH_TO_PRICE) != 0)
+    {
+        const bool is_bid = side == 'B';
+        const auto& top = is_bid ? m_bids : m_asks;
+        uint64_t depth = 0;
+        for (std::size_t level = 0; level < top.count; ++level) {
+            if (is_bid ? top.prices[level] < price : top.prices[level] > price) {
+                break;
+            }
+            depth += top.qtys[level];
+        }
+        return depth;
+    }
+};
+
+// Selected when a book has no features, takes no space inside the book.
+template<std::size_t TopDepth>
+class BookFeatureState<NO_BOOK_FEATURES, TopDepth> {
+public:
+    template<bool IsBid, typename Levels>
+    void onLevelUpdate(const Levels&, int32_t, int64_t, bool)
+    {
+    }
+};
+
+}  // namespace algocor
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "../utility/seqlock.hpp"
+
+namespace algocor
+{
+
+// Top of one book as published for readers on other cores. Levels are best first, an empty level has price 0 and qty 0. With the
+// default depth of one level per side the snapshot and its seqlock version share a single cache line.
+template<std::size_t Depth = 1>
+struct BookSnapshot {
+    uint64_t sequence;   // MoldUDP64 sequence number of the message that produced this snapshot.
+    uint64_t timestamp;  // exchange time, nanoseconds since midnight.
+    std::array<int32_t, Depth> bid_prices;
+    std::array<int32_t, Depth> ask_prices;
+    std::array<uint64_t, Depth> bid_qtys;
+    std::array<uint64_t, Depth> ask_qtys;
+};
+
+template<std::size_t Depth = 1>
+using PublishedBookSnapshot = Seqlock<BookSnapshot<Depth>>;
+
+static_assert(sizeof(PublishedBookSnapshot<>) == 64);
+
+}  // namespace algocor
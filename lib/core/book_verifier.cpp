@@ -0,0 +1,205 @@
+#include "book_verifier.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <magic_enum.hpp>
+#include <sched.h>
+
+#include "../utility/overwrite_macros.hpp"
+#include "../utility/thread.hpp"
+
+namespace algocor
+{
+
+namespace
+{
+
+template<typename Levels>
+bool removeQty(Levels& levels, int32_t price, uint64_t qty)
+{
+    auto iter = levels.find(price);
+    if (iter == levels.end() || iter->second < qty) {
+        return false;
+    }
+
+    iter->second -= qty;
+    if (iter->second == 0) {
+        levels.erase(iter);
+    }
+    return true;
+}
+
+template<typename Levels>
+std::pair<int32_t, uint64_t> bestOf(const Levels& levels)
+{
+    if (levels.empty()) {
+        return { 0, 0 };
+    }
+    return *levels.begin();
+}
+
+}  // namespace
+
+BookVerifier::BookVerifier()
+    : m_ring(std::make_unique<SpscRing<BookMutation, RING_CAPACITY>>())
+{
+}
+
+BookVerifier::~BookVerifier()
+{
+    stop();
+}
+
+void BookVerifier::start(int core)
+{
+    if (m_running.exchange(true)) {
+        LOG_WARNING("Book verifier already running");
+        return;
+    }
+
+    m_thread = std::thread([this, core]() { verifierLoop(core); });
+}
+
+void BookVerifier::stop()
+{
+    if (!m_running.exchange(false)) {
+        return;
+    }
+
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    LOG_INFO("Book verifier stopped. Verified: {}, divergences: {}", verified(), divergences());
+}
+
+void BookVerifier::verifierLoop(int core)
+{
+    setThreadName("book_verifier");
+    if (core >= 0 && !pinThreadToCore(core)) {
+        LOG_WARNING("Book verifier runs unpinned");
+    }
+    if (!setSchedulerPolicy(SCHED_IDLE, 0)) {
+        LOG_WARNING("Book verifier runs with the default scheduler policy");
+    }
+
+    while (m_running.load(std::memory_order_relaxed)) {
+        if (verifyPending() == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    verifyPending();
+}
+
+std::size_t BookVerifier::verifyPending()
+{
+    return m_ring->drain([this](const BookMutation& mutation) { verify(mutation); });
+}
+
+void BookVerifier::verify(const BookMutation& mutation)
+{
+    auto& book = m_books[mutation.orderbook_id];
+    const bool is_bid = mutation.side == 'B';
+
+    if (mutation.kind == BookMutation::Kind::Reset) [[unlikely]] {
+        LOG_WARNING("Book verifier lost mutations of orderbook {}, reference book re-seeded from the hot book", mutation.orderbook_id);
+        m_resyncs.fetch_add(1, std::memory_order_relaxed);
+        book = ReferenceBook {};
+        book.in_auction = mutation.qty != 0;
+        return;
+    }
+    if (mutation.kind == BookMutation::Kind::Seed) [[unlikely]] {
+        (is_bid ? book.bids[mutation.price] : book.asks[mutation.price]) = mutation.qty;
+        return;
+    }
+
+    book.history[book.history_count++ % HISTORY] = mutation;
+    m_verified.fetch_add(1, std::memory_order_relaxed);
+
+    const auto add = [&](int32_t price, uint64_t qty) {
+        if (is_bid) {
+            book.bids[price] += qty;
+        } else {
+            book.asks[price] += qty;
+        }
+    };
+    const auto remove = [&](int32_t price, uint64_t qty) {
+        return is_bid ? removeQty(book.bids, price, qty) : removeQty(book.asks, price, qty);
+    };
+
+    switch (mutation.kind) {
+        case BookMutation::Kind::Add:
+            add(mutation.price, mutation.qty);
+            break;
+        case BookMutation::Kind::Execute:
+        case BookMutation::Kind::Delete:
+            if (!remove(mutation.price, mutation.qty)) {
+                report(mutation, book, "update for a missing level or more than its quantity");
+                return;
+            }
+            break;
+        case BookMutation::Kind::Replace:
+            if (!remove(mutation.price, mutation.qty)) {
+                report(mutation, book, "replace of a missing level or more than its quantity");
+                return;
+            }
+            add(mutation.new_price, mutation.new_qty);
+            break;
+        case BookMutation::Kind::Auction:
+            book.in_auction = mutation.qty != 0;
+            return;
+        case BookMutation::Kind::Reset:
+        case BookMutation::Kind::Seed:
+            return;
+    }
+
+    const auto [best_price, best_qty] = is_bid ? bestOf(book.bids) : bestOf(book.asks);
+    if (best_price != mutation.best_price || best_qty != mutation.best_qty) {
+        report(mutation, book, "hot book best level differs from the reference");
+        return;
+    }
+
+    if (!book.in_auction && !book.bids.empty() && !book.asks.empty() && book.bids.begin()->first >= book.asks.begin()->first) {
+        report(mutation, book, "crossed book outside of an auction");
+    }
+}
+
+__attribute__((noinline, cold)) void BookVerifier::report(const BookMutation& mutation, const ReferenceBook& book, const char* reason)
+{
+    m_divergences.fetch_add(1, std::memory_order_relaxed);
+
+    const auto [bid_price, bid_qty] = bestOf(book.bids);
+    const auto [ask_price, ask_qty] = bestOf(book.asks);
+    LOG_ERROR("BOOK DIVERGENCE on orderbook {}: {}. Mutation kind: {}, side: {}, price: {}, qty: {}, new price: {}, new qty: {}, "
+              "hot best: {} x {}. Reference bid: {} x {} ({} levels), ask: {} x {} ({} levels)",
+        mutation.orderbook_id,
+        reason,
+        magic_enum::enum_name(mutation.kind),
+        mutation.side,
+        mutation.price,
+        mutation.qty,
+        mutation.new_price,
+        mutation.new_qty,
+        mutation.best_price,
+        mutation.best_qty,
+        bid_price,
+        bid_qty,
+        book.bids.size(),
+        ask_price,
+        ask_qty,
+        book.asks.size());
+
+    const auto count = std::min(book.history_count, HISTORY);
+    for (std::size_t i = count; i > 0; --i) {
+        const auto& past = book.history[(book.history_count - i) % HISTORY];
+        LOG_ERROR("  recent: kind: {}, side: {}, price: {}, qty: {}, new price: {}, new qty: {}",
+            magic_enum::enum_name(past.kind),
+            past.side,
+            past.price,
+            past.qty,
+            past.new_price,
+            past.new_qty);
+    }
+}
+
+}  // namespace algocor
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "../utility/spsc_ring.hpp"
+
+namespace algocor
+{
+
+// One book update as the builder applied it, plus the top of the updated side of the hot book afterwards.
+struct BookMutation {
+    enum class Kind : uint8_t
+    {
+        Add,
+        Execute,
+        Delete,
+        Replace,
+        Auction,  // qty is 1 when the book enters an auction, 0 when it leaves it.
+        Reset,    // the reference book is re-seeded from the hot book, qty is 1 when the book is in an auction.
+        Seed,     // one level of the hot book, after a Reset.
+    };
+
+    uint32_t orderbook_id;
+    int32_t price;
+    uint64_t qty;
+    int32_t new_price;  // Replace only.
+    int32_t best_price;
+    uint64_t new_qty;   // Replace only.
+    uint64_t best_qty;  // 0 when the side is empty.
+    Kind kind;
+    char side;
+};
+
+// Shadow verification of the hot books. The builder appends a BookMutation per update, a low priority thread replays them into simple
+// std::map reference books and checks what Dump() used to check on every message: the update hits an existing level, quantities never
+// go negative, the hot best level matches the reference and the book is not crossed outside an auction. Divergences are logged with the
+// reference top of book and the last mutations of that book.
+//
+// A record the ring has no room for puts its book out of sync: the book's updates are not recorded until the producer re-seeds its
+// reference book from the hot book with resync(). Other books are verified throughout.
+class BookVerifier {
+public:
+    static constexpr std::size_t RING_CAPACITY = 1 << 16;
+    static constexpr std::size_t HISTORY = 16;
+
+    BookVerifier();
+    ~BookVerifier();
+
+    BookVerifier(const BookVerifier&) = delete;
+    BookVerifier& operator=(const BookVerifier&) = delete;
+
+    // Producer side, called on the market data thread. Records of a book that is out of sync are dropped.
+    void record(const BookMutation& mutation)
+    {
+        if (outOfSync(mutation.orderbook_id)) [[unlikely]] {
+            return;
+        }
+        if (!m_ring->push(mutation)) [[unlikely]] {
+            m_outOfSync.push_back(mutation.orderbook_id);
+        }
+    }
+
+    // Producer side. Whether records of the book were dropped since it was last re-seeded.
+    [[nodiscard]] bool outOfSync(uint32_t orderbook_id) const
+    {
+        return !m_outOfSync.empty() && std::find(m_outOfSync.begin(), m_outOfSync.end(), orderbook_id) != m_outOfSync.end();
+    }
+
+    // Producer side. Replaces the reference book with the `level_count` levels of the hot book: for_each_level(seed) calls
+    // seed(char side, int32_t price, uint64_t qty) for each of them. Fails, and the book stays out of sync, while the ring has no room
+    // for all of them.
+    template<typename ForEachLevel>
+    bool resync(uint32_t orderbook_id, std::size_t level_count, bool in_auction, ForEachLevel&& for_each_level)
+    {
+        if (m_ring->freeSlots() <= level_count) {
+            return false;
+        }
+
+        m_ring->push({ orderbook_id, 0, in_auction ? 1U : 0U, 0, 0, 0, 0, BookMutation::Kind::Reset, 0 });
+        for_each_level([&](char side, int32_t price, uint64_t qty) {
+            m_ring->push({ orderbook_id, price, qty, 0, 0, 0, 0, BookMutation::Kind::Seed, side });
+        });
+        std::erase(m_outOfSync, orderbook_id);
+        return true;
+    }
+
+    // Starts the verifier thread with SCHED_IDLE, optionally pinned to `core`.
+    void start(int core = -1);
+    void stop();
+
+    // Verifies everything recorded so far on the calling thread, returns the number of mutations checked.
+    std::size_t verifyPending();
+
+    [[nodiscard]] uint64_t verified() const
+    {
+        return m_verified.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t divergences() const
+    {
+        return m_divergences.load(std::memory_order_relaxed);
+    }
+
+    // Reference books re-seeded after an overrun.
+    [[nodiscard]] uint64_t resyncs() const
+    {
+        return m_resyncs.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct ReferenceBook {
+        std::map<int32_t, uint64_t, std::greater<>> bids;
+        std::map<int32_t, uint64_t> asks;
+        bool in_auction { false };
+        std::array<BookMutation, HISTORY> history {};
+        std::size_t history_count { 0 };
+    };
+
+    std::unique_ptr<SpscRing<BookMutation, RING_CAPACITY>> m_ring;
+    std::unordered_map<uint32_t, ReferenceBook> m_books;
+
+    std::vector<uint32_t> m_outOfSync;  // producer side, few books at a time.
+
+    std::atomic<bool> m_running { false };
+    std::thread m_thread;
+
+    std::atomic<uint64_t> m_verified { 0 };
+    std::atomic<uint64_t> m_divergences { 0 };
+    std::atomic<uint64_t> m_resyncs { 0 };
+
+    void verifierLoop(int core);
+    void verify(const BookMutation& mutation);
+    void report(const BookMutation& mutation, const ReferenceBook& book, const char* reason);
+};
+
+}  // namespace algocor
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace algocor
+{
+
+// Combination orderbooks (VIOP spreads and strategies) and the outright legs they are built from, as announced by
+// CombinationOrderbookLeg ('M') messages. Buying one combination buys `ratio` of each leg on the leg's side (sells it when the leg side
+// is opposite).
+//
+// Implied prices follow the top of the books incrementally. Every leg book knows the combinations that depend on it, and each
+// combination keeps the leg sums of its implied-out bid and ask along with the number of legs whose quote is missing. A top of book
+// change therefore adjusts only the combinations of that book, by the price delta, in O(1) each. Implied-in prices of a leg come from the
+// combination's own top and those sums, in O(1) when asked for.
+//
+// Prices are in ITCH price units and not rounded to ticks; implied-in bids round down and asks up. Legs and their combinations have to
+// be built by the same book builder, which is why ItchShardRouter drops the leg messages.
+class CombinationRegistry {
+public:
+    static constexpr int64_t NO_PRICE = INT64_MIN;
+
+    struct Leg {
+        uint32_t orderbook_id;
+        uint32_t ratio;
+        bool opposite;  // bought when the combination is sold.
+    };
+
+private:
+    struct Quote {
+        int32_t bid { 0 };
+        int32_t ask { 0 };
+        bool has_bid { false };
+        bool has_ask { false };
+    };
+
+    struct Dependency {
+        uint32_t combination;  // index into m_combinations.
+        uint32_t leg;
+    };
+
+    struct Book {
+        Quote quote;
+        std::vector<Dependency> dependents;  // combinations this book is a leg of.
+    };
+
+    struct Combination {
+        const Quote* quote { nullptr };  // of the combination book itself.
+        std::vector<Leg> legs;
+        std::vector<const Quote*> leg_quotes;
+        int64_t bid_sum { 0 };  // implied-out bid over the legs with a quote.
+        int64_t ask_sum { 0 };
+        uint32_t bids_missing { 0 };  // legs missing the quote the implied-out bid needs.
+        uint32_t asks_missing { 0 };
+    };
+
+    // Node based, so the quote pointers above stay valid as books are added.
+    std::unordered_map<uint32_t, Book> m_books;
+    std::unordered_map<uint32_t, uint32_t> m_combinationIndex;
+    std::vector<Combination> m_combinations;
+
+    const Combination* findCombination(uint32_t combination_id) const
+    {
+        const auto found = m_combinationIndex.find(combination_id);
+        return found == m_combinationIndex.end() ? nullptr : &m_combinations[found->second];
+    }
+
+    static int64_t floorDiv(int64_t numerator, int64_t denominator)
+    {
+        return numerator / denominator - (numerator % denominator < 0);
+    }
+
+    static int64_t ceilDiv(int64_t numerator, int64_t denominator)
+    {
+        return numerator / denominator + (numerator % denominator > 0);
+    }
+
+    // Adds (`sign` 1) or removes (-1) the contribution of one side of a leg quote.
+    static void apply(Combination& combination, const Leg& leg, char side, int32_t price, bool present, int64_t sign)
+    {
+        // The leg's bid feeds the implied bid of an as-defined leg and the implied ask of an opposite one, the ask the other way round.
+        const auto to_bid = (side == 'B') != leg.opposite;
+        auto& sum = to_bid ? combination.bid_sum : combination.ask_sum;
+        auto& missing = to_bid ? combination.bids_missing : combination.asks_missing;
+        if (present) {
+            sum += sign * (leg.opposite ? -1 : 1) * static_cast<int64_t>(leg.ratio) * price;
+        } else {
+            missing += static_cast<uint32_t>(sign);
+        }
+    }
+
+public:
+    // False when the leg is already part of the combination or the ratio is 0.
+    bool addLeg(uint32_t combination_id, const Leg& leg)
+    {
+        if (leg.ratio == 0) {
+            return false;
+        }
+
+        const auto [found, inserted] = m_combinationIndex.try_emplace(combination_id, static_cast<uint32_t>(m_combinations.size()));
+        if (inserted) {
+            m_combinations.emplace_back().quote = &m_books[combination_id].quote;
+        }
+        auto& combination = m_combinations[found->second];
+        for (const auto& existing : combination.legs) {
+            if (existing.orderbook_id == leg.orderbook_id) {
+                return false;
+            }
+        }
+
+        auto& book = m_books[leg.orderbook_id];
+        book.dependents.push_back({ found->second, static_cast<uint32_t>(combination.legs.size()) });
+        combination.legs.push_back(leg);
+        combination.leg_quotes.push_back(&book.quote);
+        apply(combination, leg, 'B', book.quote.bid, book.quote.has_bid, 1);
+        apply(combination, leg, 'S', book.quote.ask, book.quote.has_ask, 1);
+        return true;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_books.empty();
+    }
+
+    // The best price of one side of a book changed, `present` is false once the side is empty. Books that are neither a leg nor a
+    // combination are ignored.
+    void onTopOfBook(uint32_t orderbook_id, char side, int32_t price, bool present)
+    {
+        const auto found = m_books.find(orderbook_id);
+        if (found == m_books.end()) {
+            return;
+        }
+        auto& [quote, dependents] = found->second;
+        auto& quote_price = side == 'B' ? quote.bid : quote.ask;
+        auto& quote_present = side == 'B' ? quote.has_bid : quote.has_ask;
+
+        for (const auto& dependency : dependents) {
+            auto& combination = m_combinations[dependency.combination];
+            const auto& leg = combination.legs[dependency.leg];
+            apply(combination, leg, side, quote_price, quote_present, -1);
+            apply(combination, leg, side, price, present, 1);
+        }
+        quote_price = price;
+        quote_present = present;
+    }
+
+    // Best combination bid made of the legs' outright quotes, NO_PRICE while a leg lacks the side it needs.
+    [[nodiscard]] int64_t impliedBid(uint32_t combination_id) const
+    {
+        const auto* combination = findCombination(combination_id);
+        return combination == nullptr || combination->bids_missing != 0 ? NO_PRICE : combination->bid_sum;
+    }
+
+    [[nodiscard]] int64_t impliedAsk(uint32_t combination_id) const
+    {
+        const auto* combination = findCombination(combination_id);
+        return combination == nullptr || combination->asks_missing != 0 ? NO_PRICE : combination->ask_sum;
+    }
+
+    // Bid for one leg implied by the combination's own book and the other legs' outright quotes, NO_PRICE when one is missing.
+    [[nodiscard]] int64_t impliedLegBid(uint32_t combination_id, uint32_t leg_orderbook_id) const
+    {
+        return impliedLeg(combination_id, leg_orderbook_id, 'B');
+    }
+
+    [[nodiscard]] int64_t impliedLegAsk(uint32_t combination_id, uint32_t leg_orderbook_id) const
+    {
+        return impliedLeg(combination_id, leg_orderbook_id, 'S');
+    }
+
+    [[nodiscard]] const std::vector<Leg>* legs(uint32_t combination_id) const
+    {
+        const auto* combination = findCombination(combination_id);
+        return combination == nullptr ? nullptr : &combination->legs;
+    }
+
+private:
+    int64_t impliedLeg(uint32_t combination_id, uint32_t leg_orderbook_id, char side) const
+    {
+        const auto* combination = findCombination(combination_id);
+        if (combination == nullptr) {
+            return NO_PRICE;
+        }
+        std::size_t index = 0;
+        while (index < combination->legs.size() && combination->legs[index].orderbook_id != leg_orderbook_id) {
+            ++index;
+        }
+        if (index == combination->legs.size()) {
+            return NO_PRICE;
+        }
+        const auto& leg = combination->legs[index];
+        const auto& leg_quote = *combination->leg_quotes[index];
+
+        // A leg bid trades against a combination bid when the leg is bought with the combination, against its ask otherwise. The other
+        // legs are then filled on the opposite side of that combination order, so their sum is the other implied-out sum without this leg.
+        const auto against_bid = (side == 'B') != leg.opposite;
+        const auto& combination_quote = *combination->quote;
+        if (against_bid ? !combination_quote.has_bid : !combination_quote.has_ask) {
+            return NO_PRICE;
+        }
+        const int64_t combination_price = against_bid ? combination_quote.bid : combination_quote.ask;
+
+        // This leg's term in that sum: its ask in the implied ask when bought with the combination, its bid in the implied bid otherwise.
+        const auto own_side_present = against_bid != leg.opposite ? leg_quote.has_ask : leg_quote.has_bid;
+        const int64_t own_price = against_bid != leg.opposite ? leg_quote.ask : leg_quote.bid;
+        const auto missing = (against_bid ? combination->asks_missing : combination->bids_missing) - (own_side_present ? 0 : 1);
+        if (missing != 0) {
+            return NO_PRICE;
+        }
+        const int64_t sign = leg.opposite ? -1 : 1;
+        const int64_t ratio = leg.ratio;
+        const auto others = (against_bid ? combination->ask_sum : combination->bid_sum) - (own_side_present ? sign * ratio * own_price : 0);
+
+        // combination price = others + sign * ratio * leg price.
+        const auto numerator = sign * (combination_price - others);
+        return side == 'B' ? floorDiv(numerator, ratio) : ceilDiv(numerator, ratio);
+    }
+};
+
+}  // namespace algocor
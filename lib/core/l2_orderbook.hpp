@@ -1,12 +1,21 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
 #include <cstdint>
 #include <iostream>
 #include <ranges>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "book_features.hpp"
+#include "book_snapshot.hpp"
+#include "level_stores.hpp"
+#include "tick_ladder.hpp"
+
 #include "../utility/overwrite_macros.hpp"
 #include "../utility/quill_wrapper.hpp"
 
@@ -33,179 +42,143 @@ inline void HandleError()
 
 // Reference: When Nanoseconds Matter: Ultrafast Trading Systems in C++ - David Gross - CppCon 2024
 // https://www.youtube.com/watch?v=sX2nF1fW7kI
-class L2Orderbook {
-private:
-    std::vector<std::pair<std::int32_t, std::uint64_t>> m_bids;
-    std::vector<std::pair<std::int32_t, std::uint64_t>> m_asks;
+//
+// Level storage is a compile-time policy (see level_stores.hpp), so every instrument class can use the store that is fastest for its depth
+// profile without a virtual call on the hot path. Features is a mask of algocor::BookFeature, maintained on every update.
+template<typename LevelPolicy, unsigned Features = algocor::NO_BOOK_FEATURES>
+class BasicL2Orderbook {
+public:
+    // Levels per side that consumers see through PublishVisibleChanges(), strategies read the top 10.
+    static constexpr std::size_t VISIBLE_DEPTH = 10;
 
-    template<typename Comparator>
-    void AddOrder(std::vector<std::pair<std::int32_t, std::uint64_t>>& levels, std::int32_t price, std::uint64_t qty, Comparator comp)
-    {
-        if (levels.empty()) [[unlikely]] {
-            levels.emplace_back(price, qty);
-            LOG_DEBUG("ADDED ORDER TO EMPTY BOOK SIDE");
-            return;
-        }
+    // Levels per side in the seqlock snapshot read by other threads, one level keeps it in a single cache line.
+    static constexpr std::size_t SNAPSHOT_DEPTH = 1;
+    static_assert(SNAPSHOT_DEPTH <= VISIBLE_DEPTH);
 
-        auto iter = GetLevel(levels, price);
-        Dump();
-        LOG_DEBUG("NOW ADDING ORDER");
+    // GetBestPrices() on an empty side.
+    static constexpr std::int32_t NO_BID = INT32_MIN;
+    static constexpr std::int32_t NO_ASK = INT32_MAX;
 
-        if (iter != levels.rend() && iter->first == price) [[likely]] {
-            iter->second += qty;
+private:
+    using BidLevels = typename LevelPolicy::template Side<true>;
+    using AskLevels = typename LevelPolicy::template Side<false>;
+
+    // Visible levels as last published, best first.
+    struct VisibleLevels {
+        std::array<std::int32_t, VISIBLE_DEPTH> prices {};
+        std::array<std::uint64_t, VISIBLE_DEPTH> qtys {};
+        std::size_t count { 0 };
+    };
+
+    BidLevels m_bids;
+    AskLevels m_asks;
+    VisibleLevels m_visibleBids;
+    VisibleLevels m_visibleAsks;
+    algocor::PublishedBookSnapshot<SNAPSHOT_DEPTH> m_snapshot;
+    [[no_unique_address]] algocor::BookFeatureState<Features> m_features;
+
+    // Runs `update` on `levels` and feeds the quantity change at `price` to the enabled features.
+    template<typename Levels, typename Update>
+    void UpdateLevels(Levels& levels, std::int32_t price, std::int64_t delta, Update&& update)
+    {
+        if constexpr (Features == algocor::NO_BOOK_FEATURES) {
+            update();
         } else {
-            std::vector<std::pair<std::int32_t, std::uint64_t>>::reverse_iterator level_iter;
-            for (level_iter = levels.rbegin(); level_iter != levels.rend(); ++level_iter) {
-                LOG_DEBUG("X: {}, Y: {}", price, level_iter->first);
-                if (comp(level_iter->first, price)) {
-                    LOG_DEBUG("COMP TRUE");
-                    levels.insert(level_iter.base(), { price, qty });
-                    break;
-                } else {
-                    LOG_DEBUG("COMP FALSE");
-                }
-            }
-
-            if (level_iter == levels.rend()) {
-                LOG_DEBUG("INSERTED TO THE WORST LEVEL!");
-                levels.insert(levels.begin(), { price, qty });
-            }
-
-            // if (!levels.empty() && comp(price, levels.back().first)) {
-            //     // best level.
-            //     levels.emplace_back(price, qty);
-            //     LOG_DEBUG("adding qty to the brand-new best level");
-            // } else {
-            //     // worst level.
-            //     // this should occur very rarely!
-            //     // TODO: this segfaults when reallocation happens, to remedy this, I reserved space beforehand.
-            //     levels.insert(levels.begin(), { price, qty });
-            //     LOG_DEBUG("adding qty to the brand-new worst level");
-            // }
+            const auto size_before = levels.size();
+            update();
+            m_features.template onLevelUpdate<std::is_same_v<Levels, BidLevels>>(levels, price, delta, levels.size() != size_before);
         }
-
-        LOG_DEBUG("ADDED ORDER");
     }
 
-    void DeleteOrder(std::vector<std::pair<std::int32_t, std::uint64_t>>& levels, std::int32_t price, std::uint64_t qty)
+    // Book integrity is checked off the hot path by BookVerifier, use Dump() when debugging.
+    template<typename Levels>
+    void AddOrder(Levels& levels, std::int32_t price, std::uint64_t qty)
     {
-        auto iter = GetLevel(levels, price);
-
-        if (!(iter != levels.rend() && iter->first == price)) {
-            LOG_ERROR("TO BE DELETED ORDER NOT FOUND. DUMPING ORDERBOOK. PRICE: {}", price);
-            Dump();
-            std::exit(42);
-
-            return;
-        }
-
-        EXPECT(iter != levels.rend() && iter->first == price);
-
-        iter->second -= qty;
-        if (iter->second <= 0) [[unlikely]] {
-            LOG_DEBUG("level erased for price: {}", price);
-            auto it = iter.base();
-            --it;
-            levels.erase(it);
-        }
+        UpdateLevels(levels, price, static_cast<std::int64_t>(qty), [&]() { levels.add(price, qty); });
     }
 
-    template<typename Comparator>
-    void ReplaceOrder(std::vector<std::pair<std::int32_t, std::uint64_t>>& levels,
-        std::int32_t oldPrice,
-        std::uint64_t oldQty,
-        std::int32_t newPrice,
-        std::uint64_t newQty,
-        Comparator comp)
+    template<typename Levels>
+    void DeleteOrder(Levels& levels, std::int32_t price, std::uint64_t qty)
     {
-        auto iter = GetLevel(levels, oldPrice);
-
-        EXPECT(iter != levels.rend() && iter->first == oldPrice);
+        UpdateLevels(levels, price, -static_cast<std::int64_t>(qty), [&]() { EXPECT(levels.remove(price, qty)); });
+    }
 
+    template<typename Levels>
+    void ReplaceOrder(Levels& levels, std::int32_t oldPrice, std::uint64_t oldQty, std::int32_t newPrice, std::uint64_t newQty)
+    {
         // Case 1: oldPrice == newPrice, only adjust quantities
         if (oldPrice == newPrice) {
-            EXPECT(iter->second >= oldQty);  // Ensure sufficient quantity to replace
-            iter->second = iter->second - oldQty + newQty;
+            const auto delta = static_cast<std::int64_t>(newQty) - static_cast<std::int64_t>(oldQty);
+            UpdateLevels(levels, oldPrice, delta, [&]() { EXPECT(levels.modify(oldPrice, oldQty, newQty)); });
             return;
         }
 
         // Case 2: oldPrice != newPrice
-        // Adjust or remove the old order
-        if (iter->second > oldQty) [[likely]] {
-            iter->second -= oldQty;
-        } else {
-            auto it = iter.base();
-            --it;
-            levels.erase(it);
-        }
-
-        // Insert or update the new order
-        AddOrder(levels, newPrice, newQty, comp);
+        UpdateLevels(levels, oldPrice, -static_cast<std::int64_t>(oldQty), [&]() { EXPECT(levels.remove(oldPrice, oldQty)); });
+        UpdateLevels(levels, newPrice, static_cast<std::int64_t>(newQty), [&]() { levels.add(newPrice, newQty); });
     }
 
-    void ExecuteOrderImpl(std::vector<std::pair<std::int32_t, std::uint64_t>>& levels, std::int32_t price, std::uint64_t qty)
+    template<bool IsBid, typename Levels, typename Func>
+    std::size_t PublishVisibleChanges(const Levels& levels, VisibleLevels& visible, std::int32_t price, Func&& func)
     {
-        // Find the price level using branchless lower bound
-        auto iter = GetLevel(levels, price);
-        LOG_DEBUG("EXECUTE PRICE: {}, QTY: {}", price, qty);
-        Dump();
-
-        // Ensure the price level exists and matches the input price
-        EXPECT(iter != levels.rend() && iter->first == price);
-
-        // Decrement the quantity
-        if (iter->second > qty) [[likely]] {
-            iter->second -= qty;
-        } else {
-            // If the quantity is fully consumed, remove the price level
-            auto it = iter.base();
-            --it;
-            levels.erase(it);
+        // An update worse than the last visible level cannot change what consumers see. Checked against the levels as they were before
+        // the update: a new level has to beat the old last one to enter, a removed level must have been at or above it.
+        if (visible.count == VISIBLE_DEPTH && algocor::isBetterPrice<IsBid>(visible.prices[VISIBLE_DEPTH - 1], price)) [[likely]] {
+            return VISIBLE_DEPTH;
         }
-    }
 
-public:
-    L2Orderbook()
-    {
-        m_bids.reserve(1'000'000);
-        m_asks.reserve(1'000'000);
+        VisibleLevels current;
+        current.count = levels.top(VISIBLE_DEPTH, current.prices.data(), current.qtys.data());
+
+        std::size_t first_changed = VISIBLE_DEPTH;
+        const auto count = std::max(current.count, visible.count);
+        for (std::size_t level = 0; level < count; ++level) {
+            if (level >= current.count) {
+                func(level, 0, 0);
+            } else if (level >= visible.count || current.prices[level] != visible.prices[level]
+                || current.qtys[level] != visible.qtys[level]) {
+                func(level, current.prices[level], current.qtys[level]);
+            } else {
+                continue;
+            }
+            first_changed = std::min(first_changed, level);
+        }
+        visible = current;
+        return first_changed;
     }
 
-    const std::vector<std::pair<std::int32_t, std::uint64_t>>::reverse_iterator
-    GetLevel(std::vector<std::pair<std::int32_t, std::uint64_t>>& levels, int32_t price) const
+    template<typename Levels>
+    void ExecuteOrderImpl(Levels& levels, std::int32_t price, std::uint64_t qty)
     {
-        auto iter = levels.rbegin();
-        while (iter != levels.rend() && iter->first != price) {
-            ++iter;
-        }
-
-        return iter;
+        // Ensure the price level exists, it is removed once fully consumed.
+        UpdateLevels(levels, price, -static_cast<std::int64_t>(qty), [&]() { EXPECT(levels.remove(price, qty)); });
     }
 
+public:
     void AddOrder(char side, std::int32_t price, std::uint64_t qty)
     {
         if (side == 'B') {
-            AddOrder(m_bids, price, qty, std::less<>());  // top of the book is at the end.
+            AddOrder(m_bids, price, qty);
         } else {
-            AddOrder(m_asks, price, qty, std::greater<>());  // top of the book is at the end.
+            AddOrder(m_asks, price, qty);
         }
     }
 
     void DeleteOrder(char side, std::int32_t price, std::uint64_t qty)
     {
         if (side == 'B') {
-            DeleteOrder(m_bids, price, qty);  // top of the book is at the end.
+            DeleteOrder(m_bids, price, qty);
         } else {
-            DeleteOrder(m_asks, price, qty);  // top of the book is at the end.
+            DeleteOrder(m_asks, price, qty);
         }
     }
 
     void ReplaceOrder(char side, std::int32_t oldPrice, std::uint64_t oldQty, std::int32_t newPrice, std::uint64_t newQty)
     {
         if (side == 'B') {
-            ReplaceOrder(m_bids, oldPrice, oldQty, newPrice, newQty, std::less<>());  // top of the book is at the end.
+            ReplaceOrder(m_bids, oldPrice, oldQty, newPrice, newQty);
         } else {
-            ReplaceOrder(m_asks, oldPrice, oldQty, newPrice, newQty, std::greater<>());  // top of the book is at the end.
+            ReplaceOrder(m_asks, oldPrice, oldQty, newPrice, newQty);
         }
     }
 
@@ -218,43 +191,128 @@ public:
         }
     }
 
+    // Call after every update of `side` with the price it touched (both prices for a replace). Calls
+    // func(std::size_t level, std::int32_t price, std::uint64_t qty) for every visible level that differs from what was last published,
+    // level 0 being the top of the book. A level that is no longer populated is reported with price 0 and qty 0. Returns the first
+    // level that changed, VISIBLE_DEPTH if none did.
+    template<typename Func>
+    std::size_t PublishVisibleChanges(char side, std::int32_t price, Func&& func)
+    {
+        if (side == 'B') {
+            return PublishVisibleChanges<true>(m_bids, m_visibleBids, price, func);
+        }
+        return PublishVisibleChanges<false>(m_asks, m_visibleAsks, price, func);
+    }
+
+    // Copies the top SNAPSHOT_DEPTH levels of both sides, as last published by PublishVisibleChanges(), to the seqlock snapshot.
+    void PublishSnapshot(std::uint64_t sequence, std::uint64_t timestamp)
+    {
+        algocor::BookSnapshot<SNAPSHOT_DEPTH> snapshot {};
+        snapshot.sequence = sequence;
+        snapshot.timestamp = timestamp;
+        for (std::size_t level = 0; level < SNAPSHOT_DEPTH; ++level) {
+            if (level < m_visibleBids.count) {
+                snapshot.bid_prices[level] = m_visibleBids.prices[level];
+                snapshot.bid_qtys[level] = m_visibleBids.qtys[level];
+            }
+            if (level < m_visibleAsks.count) {
+                snapshot.ask_prices[level] = m_visibleAsks.prices[level];
+                snapshot.ask_qtys[level] = m_visibleAsks.qtys[level];
+            }
+        }
+        m_snapshot.store(snapshot);
+    }
+
+    // Safe to read from any thread.
+    [[nodiscard]] const algocor::PublishedBookSnapshot<SNAPSHOT_DEPTH>& Snapshot() const
+    {
+        return m_snapshot;
+    }
+
+    // Best level of one side, {0, 0} when it is empty.
+    [[nodiscard]] std::pair<std::int32_t, std::uint64_t> BestLevel(char side) const
+    {
+        if (side == 'B') {
+            return m_bids.empty() ? std::pair<std::int32_t, std::uint64_t> { 0, 0 } : m_bids.best();
+        }
+        return m_asks.empty() ? std::pair<std::int32_t, std::uint64_t> { 0, 0 } : m_asks.best();
+    }
+
+    // NO_BID / NO_ASK for an empty side.
     [[nodiscard]] std::pair<std::int32_t, std::int32_t> GetBestPrices() const
     {
-        return { m_bids.rbegin()->first, m_asks.rbegin()->first };
+        return { m_bids.empty() ? NO_BID : m_bids.best().first, m_asks.empty() ? NO_ASK : m_asks.best().first };
     }
 
-    void Dump()
+    // Quantity resting at one price, 0 when the level is empty. Walks the side, not for the hot path.
+    [[nodiscard]] std::uint64_t LevelQty(char side, std::int32_t price) const
     {
-        int32_t prev_price = INT_MAX;
+        std::uint64_t qty = 0;
+        const auto match = [&](std::int32_t level_price, std::uint64_t level_qty) {
+            if (level_price == price) {
+                qty = level_qty;
+            }
+        };
+        if (side == 'B') {
+            m_bids.forEach(match);
+        } else {
+            m_asks.forEach(match);
+        }
+        return qty;
+    }
 
-        LOG_TRACE_L3("ASKS");
+    [[nodiscard]] const BidLevels& Bids() const
+    {
+        return m_bids;
+    }
+
+    [[nodiscard]] const AskLevels& Asks() const
+    {
+        return m_asks;
+    }
+
+    // Feature values, see algocor::BookFeatureState for the accessors enabled by Features.
+    [[nodiscard]] const algocor::BookFeatureState<Features>& GetFeatures() const
+    {
+        return m_features;
+    }
+
+    // Bytes this book occupies, including its share of the level arena.
+    [[nodiscard]] std::size_t MemoryUsage() const
+    {
+        return sizeof(*this) + m_bids.memoryBytes() + m_asks.memoryBytes();
+    }
+
+    void Dump() const
+    {
         bool bad = false;
-        for (const auto& [ask_px, ask_qty] : m_asks) {
-            if (prev_price <= ask_px) {
-                bad = true;
-            }
-            if (ask_qty == 0) {
+
+        LOG_TRACE_L3("ASKS");
+        int32_t prev_price = INT_MIN;
+        m_asks.forEach([&](int32_t ask_px, uint64_t ask_qty) {
+            if (prev_price >= ask_px || ask_qty == 0) {
                 bad = true;
             }
-
             prev_price = ask_px;
             LOG_TRACE_L3("{} - {}", ask_px, ask_qty);
-        }
+        });
+
         LOG_TRACE_L3("\n------------------------------------------BIDS");
-        for (auto iter = m_bids.rbegin(); iter != m_bids.rend(); ++iter) {
-            if (prev_price <= iter->first) {
-                bad = true;
-            }
-            if (iter->second == 0) {
+        prev_price = m_asks.empty() ? INT_MAX : m_asks.best().first;  // a crossed book is bad as well.
+        m_bids.forEach([&](int32_t bid_px, uint64_t bid_qty) {
+            if (prev_price <= bid_px || bid_qty == 0) {
                 bad = true;
             }
-
-            prev_price = iter->first;
-            LOG_TRACE_L3("{} - {}", iter->first, iter->second);
-        }
+            prev_price = bid_px;
+            LOG_TRACE_L3("{} - {}", bid_px, bid_qty);
+        });
 
         if (bad) {
             LOG_ERROR("BAD ORDERBOOK");
         }
     }
 };
+
+using L2Orderbook = BasicL2Orderbook<algocor::SortedVectorPolicy>;
+using TickLadderOrderbook = BasicL2Orderbook<algocor::TickLadderPolicy>;
+using TopNOrderbook = BasicL2Orderbook<algocor::TopNPolicy<>>;
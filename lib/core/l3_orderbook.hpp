@@ -0,0 +1,299 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "l2_orderbook.hpp"
+#include "order_index.hpp"
+#include "slab_pool.hpp"
+
+// Resting order of an L3 book, linked into the FIFO of its price level. The first five fields mirror ItchOrder, so the book builder
+// keeps these in place of its plain records when it builds L3 books.
+struct alignas(32) L3Order {
+    std::int32_t price;
+    std::uint32_t left_qty;
+    std::uint32_t orderbook_id;
+    char side;
+    std::uint16_t own_epoch;
+    std::uint32_t level;  // handle of the L3Level it is queued at.
+    std::uint32_t prev;   // towards the front of the queue.
+    std::uint32_t next;
+};
+
+static_assert(sizeof(L3Order) == 32);
+
+// One price level: order count and quantity are kept as orders join and leave, levels of a side are linked best to worst.
+struct L3Level {
+    std::int32_t price;
+    std::uint32_t count;
+    std::uint64_t qty;
+    std::uint32_t head;    // first order in time priority.
+    std::uint32_t tail;
+    std::uint32_t better;  // neighbouring levels of the same side.
+    std::uint32_t worse;
+};
+
+static_assert(sizeof(L3Level) == 32);
+
+// Order by order book. Every order sits in a doubly linked FIFO of its level and points back to the level, so executions and deletes
+// are O(1) from the order handle alone, and an add finds its level by price in a flat index of the book's levels. The aggregated levels,
+// visible level events, snapshots and features come from the underlying BasicL2Orderbook, which is updated alongside.
+//
+// Orders live in a SlabPool owned by the caller (the book builder keeps one for all books) and are addressed by pool handle. Levels
+// live in a pool shared by all books of the thread.
+template<typename LevelPolicy, unsigned Features = algocor::NO_BOOK_FEATURES>
+class BasicL3Orderbook : private BasicL2Orderbook<LevelPolicy, Features> {
+    using Base = BasicL2Orderbook<LevelPolicy, Features>;
+
+public:
+    using Order = L3Order;
+    using OrderPool = algocor::SlabPool<L3Order>;
+    using Handle = OrderPool::Handle;
+    static constexpr Handle NULL_HANDLE = OrderPool::NULL_HANDLE;
+
+    using Base::NO_ASK;
+    using Base::NO_BID;
+    using Base::SNAPSHOT_DEPTH;
+    using Base::VISIBLE_DEPTH;
+
+    using Base::Asks;
+    using Base::BestLevel;
+    using Base::Bids;
+    using Base::Dump;
+    using Base::GetBestPrices;
+    using Base::GetFeatures;
+    using Base::LevelQty;
+    using Base::PublishSnapshot;
+    using Base::Snapshot;
+
+    [[nodiscard]] static algocor::SlabPool<L3Level>& levelPool()
+    {
+        thread_local algocor::SlabPool<L3Level> pool;
+        return pool;
+    }
+
+    BasicL3Orderbook() = default;
+    BasicL3Orderbook(const BasicL3Orderbook&) = delete;
+    BasicL3Orderbook& operator=(const BasicL3Orderbook&) = delete;
+
+    ~BasicL3Orderbook()
+    {
+        releaseLevels(m_bestBid);
+        releaseLevels(m_bestAsk);
+    }
+
+    // Queues the order, whose price, left_qty and side are set. `rank` is the rank the exchange reported on the side, 1 for the first
+    // order of the best level: the order is placed there when that falls inside its level and at the back of the level otherwise. The
+    // return value differs from `rank` when the books disagree. Checking a rank counts the orders of the better levels, up to `rank`
+    // only, so a disagreement may return less than the order's actual rank; 0 (no rank reported) queues at the back and returns 0.
+    std::uint32_t AddOrder(OrderPool& orders, Handle handle, std::uint32_t rank = 0)
+    {
+        auto& order = orders.get(handle);
+        Base::AddOrder(order.side, order.price, order.left_qty);
+        return order.side == 'B' ? Enqueue<true>(orders, handle, rank) : Enqueue<false>(orders, handle, rank);
+    }
+
+    // Changes price and quantity of a queued order. A smaller quantity at the same price keeps its place in the queue and returns 0,
+    // anything else requeues it like AddOrder() and returns what that does.
+    std::uint32_t ReplaceOrder(OrderPool& orders, Handle handle, std::int32_t price, std::uint32_t qty, std::uint32_t rank = 0)
+    {
+        auto& order = orders.get(handle);
+        Base::ReplaceOrder(order.side, order.price, order.left_qty, price, qty);
+
+        auto& level = levelPool().get(order.level);
+        if (price == order.price && qty <= order.left_qty) {
+            level.qty -= order.left_qty - qty;
+            order.left_qty = qty;
+            return 0;
+        }
+
+        level.qty -= order.left_qty;
+        Unlink(orders, handle);
+        order.price = price;
+        order.left_qty = qty;
+        return order.side == 'B' ? Enqueue<true>(orders, handle, rank) : Enqueue<false>(orders, handle, rank);
+    }
+
+    // Removes `qty` from the order and its level, and the order from its queue once it is filled.
+    void ExecuteOrder(OrderPool& orders, Handle handle, std::uint64_t qty)
+    {
+        auto& order = orders.get(handle);
+        EXPECT(qty <= order.left_qty);
+        Base::ExecuteOrder(order.side, order.price, qty);
+
+        order.left_qty -= static_cast<std::uint32_t>(qty);
+        levelPool().get(order.level).qty -= qty;
+        if (order.left_qty == 0) {
+            Unlink(orders, handle);
+        }
+    }
+
+    // Removes the order from its queue, left_qty is left as it was.
+    void DeleteOrder(OrderPool& orders, Handle handle)
+    {
+        auto& order = orders.get(handle);
+        Base::DeleteOrder(order.side, order.price, order.left_qty);
+
+        levelPool().get(order.level).qty -= order.left_qty;
+        Unlink(orders, handle);
+    }
+
+    // See BasicL2Orderbook::PublishVisibleChanges().
+    template<typename Func>
+    std::size_t PublishVisibleChanges(char side, std::int32_t price, Func&& func)
+    {
+        return Base::PublishVisibleChanges(side, price, std::forward<Func>(func));
+    }
+
+    // 1 for the order at the front of its level. Walks the queue, not for the hot path.
+    [[nodiscard]] std::uint32_t QueuePosition(const OrderPool& orders, Handle handle) const
+    {
+        std::uint32_t position = 1;
+        for (auto ahead = orders.get(handle).prev; ahead != NULL_HANDLE; ahead = orders.get(ahead).prev) {
+            ++position;
+        }
+        return position;
+    }
+
+    // nullptr when `side` has no level at `price`.
+    [[nodiscard]] const L3Level* Level(char side, std::int32_t price) const
+    {
+        const auto* entry = m_levelIndex.find(LevelKey(side, price));
+        return entry == nullptr ? nullptr : &levelPool().get(entry->value);
+    }
+
+    // func(const L3Order&) for the orders at `price`, in time priority.
+    template<typename Func>
+    void ForEachOrder(const OrderPool& orders, char side, std::int32_t price, Func&& func) const
+    {
+        if (const auto* level = Level(side, price)) {
+            for (auto handle = level->head; handle != NULL_HANDLE; handle = orders.get(handle).next) {
+                func(orders.get(handle));
+            }
+        }
+    }
+
+    // Bytes this book occupies, with its levels but without the orders, which belong to the caller's pool.
+    [[nodiscard]] std::size_t MemoryUsage() const
+    {
+        return Base::MemoryUsage() + sizeof(*this) - sizeof(Base) + m_levelCount * sizeof(L3Level) + m_levelIndex.memoryBytes();
+    }
+
+private:
+    Handle m_bestBid { NULL_HANDLE };
+    Handle m_bestAsk { NULL_HANDLE };
+    std::size_t m_levelCount { 0 };
+    algocor::FlatOrderIndex<Handle> m_levelIndex;  // levels of both sides, see LevelKey().
+
+    // Levels take the order id field of the key for their price, the orderbook id is the same for every level of the book.
+    static algocor::OrderKey LevelKey(char side, std::int32_t price)
+    {
+        return { static_cast<std::uint32_t>(price), 0, side };
+    }
+
+    Handle& Best(char side)
+    {
+        return side == 'B' ? m_bestBid : m_bestAsk;
+    }
+
+    template<bool IsBid>
+    std::uint32_t Enqueue(OrderPool& orders, Handle handle, std::uint32_t rank)
+    {
+        auto& levels = levelPool();
+        auto& order = orders.get(handle);
+
+        const auto* entry = m_levelIndex.find(LevelKey(order.side, order.price));
+        const auto current = entry != nullptr ? entry->value : OpenLevel<IsBid>(order.side, order.price);
+        auto& level = levels.get(current);
+        order.level = current;
+        level.qty += order.left_qty;
+
+        // Orders of the better levels rank ahead. Once they reach `rank` the order cannot go where the exchange put it, and the count
+        // stops there.
+        std::uint32_t ahead = 0;
+        for (auto better = level.better; rank != 0 && better != NULL_HANDLE && ahead < rank; better = levels.get(better).better) {
+            ahead += levels.get(better).count;
+        }
+
+        // Orders of the level the new one goes behind, its whole queue unless the exchange ranked it further ahead.
+        auto behind = level.count;
+        if (rank > ahead && rank - ahead - 1 < level.count) {
+            behind = rank - ahead - 1;
+        }
+
+        auto next = NULL_HANDLE;
+        if (behind < level.count) [[unlikely]] {
+            next = level.head;
+            for (std::uint32_t skipped = 0; skipped < behind; ++skipped) {
+                next = orders.get(next).next;
+            }
+        }
+
+        order.next = next;
+        order.prev = next == NULL_HANDLE ? level.tail : orders.get(next).prev;
+        (order.prev == NULL_HANDLE ? level.head : orders.get(order.prev).next) = handle;
+        (next == NULL_HANDLE ? level.tail : orders.get(next).prev) = handle;
+        ++level.count;
+
+        return rank != 0 ? ahead + behind + 1 : 0;
+    }
+
+    // New levels mostly open close to the top of the book, so their neighbours are found walking from the best level.
+    template<bool IsBid>
+    Handle OpenLevel(char side, std::int32_t price)
+    {
+        auto& levels = levelPool();
+        auto better = NULL_HANDLE;
+        auto worse = Best(side);
+        while (worse != NULL_HANDLE && algocor::isBetterPrice<IsBid>(levels.get(worse).price, price)) {
+            better = worse;
+            worse = levels.get(worse).worse;
+        }
+
+        const auto handle = levels.allocate();
+        levels.get(handle) = { price, 0, 0, NULL_HANDLE, NULL_HANDLE, better, worse };
+
+        (better == NULL_HANDLE ? Best(side) : levels.get(better).worse) = handle;
+        if (worse != NULL_HANDLE) {
+            levels.get(worse).better = handle;
+        }
+        m_levelIndex.insert(LevelKey(side, price), handle);
+        ++m_levelCount;
+        return handle;
+    }
+
+    void Unlink(OrderPool& orders, Handle handle)
+    {
+        auto& levels = levelPool();
+        const auto& order = orders.get(handle);
+        auto& level = levels.get(order.level);
+
+        (order.prev == NULL_HANDLE ? level.head : orders.get(order.prev).next) = order.next;
+        (order.next == NULL_HANDLE ? level.tail : orders.get(order.next).prev) = order.prev;
+
+        if (--level.count != 0) {
+            return;
+        }
+
+        (level.better == NULL_HANDLE ? Best(order.side) : levels.get(level.better).worse) = level.worse;
+        if (level.worse != NULL_HANDLE) {
+            levels.get(level.worse).better = level.better;
+        }
+        m_levelIndex.erase(LevelKey(order.side, level.price));
+        levels.release(order.level);
+        --m_levelCount;
+    }
+
+    static void releaseLevels(Handle handle)
+    {
+        auto& levels = levelPool();
+        while (handle != NULL_HANDLE) {
+            const auto worse = levels.get(handle).worse;
+            levels.release(handle);
+            handle = worse;
+        }
+    }
+};
+
+using L3Orderbook = BasicL3Orderbook<algocor::SortedVectorPolicy>;
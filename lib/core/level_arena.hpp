@@ -0,0 +1,268 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "../utility/overwrite_macros.hpp"
+#include "../utility/quill_wrapper.hpp"
+
+namespace algocor
+{
+
+// Shared storage for the level arrays of every book. Blocks come in power-of-two size classes (8, 16, 32, ... levels) carved out of
+// large chunks, and freed blocks go to a per-class free list, so thousands of mostly thin books cost a few cache lines each instead of
+// a worst-case reservation per side. Memory is never handed back to the OS: steady state is allocation free.
+//
+// Not thread safe. Each thread uses its own arena (see local()), and a book must only be touched by the thread that created it.
+class LevelArena {
+public:
+    static constexpr std::size_t BYTES_PER_LEVEL = sizeof(std::int32_t) + sizeof(std::uint64_t);
+    static constexpr std::size_t MIN_LEVELS = 8;
+    static constexpr std::size_t CLASS_COUNT = 24;  // up to 64M levels per side.
+    static constexpr std::size_t CHUNK_BYTES = 2 * 1024 * 1024;
+    static constexpr std::size_t BLOCK_ALIGNMENT = 64;
+
+    LevelArena() = default;
+    LevelArena(const LevelArena&) = delete;
+    LevelArena& operator=(const LevelArena&) = delete;
+
+    ~LevelArena()
+    {
+        for (void* chunk : m_chunks) {
+            std::free(chunk);
+        }
+    }
+
+    [[nodiscard]] static LevelArena& local()
+    {
+        thread_local LevelArena arena;
+        return arena;
+    }
+
+    [[nodiscard]] static constexpr std::size_t levelsIn(std::size_t size_class)
+    {
+        return MIN_LEVELS << size_class;
+    }
+
+    [[nodiscard]] static constexpr std::size_t blockBytes(std::size_t size_class)
+    {
+        return (levelsIn(size_class) * BYTES_PER_LEVEL + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+    }
+
+    [[nodiscard]] void* allocate(std::size_t size_class)
+    {
+        const auto bytes = blockBytes(size_class);
+        m_usedBytes += bytes;
+
+        if (void* block = m_freeLists[size_class]) [[likely]] {
+            m_freeLists[size_class] = *static_cast<void**>(block);
+            return block;
+        }
+
+        return carve(bytes);
+    }
+
+    void deallocate(void* block, std::size_t size_class)
+    {
+        m_usedBytes -= blockBytes(size_class);
+        *static_cast<void**>(block) = m_freeLists[size_class];
+        m_freeLists[size_class] = block;
+    }
+
+    // Bytes requested from the OS.
+    [[nodiscard]] std::size_t reservedBytes() const
+    {
+        return m_reservedBytes;
+    }
+
+    // Bytes held by live level arrays.
+    [[nodiscard]] std::size_t usedBytes() const
+    {
+        return m_usedBytes;
+    }
+
+private:
+    std::array<void*, CLASS_COUNT> m_freeLists {};
+    std::vector<void*> m_chunks;
+    std::byte* m_cursor { nullptr };
+    std::size_t m_remaining { 0 };
+    std::size_t m_reservedBytes { 0 };
+    std::size_t m_usedBytes { 0 };
+
+    __attribute__((noinline, cold)) void* newChunk(std::size_t bytes)
+    {
+        void* chunk = std::aligned_alloc(BLOCK_ALIGNMENT, bytes);
+        if (chunk == nullptr) {
+            LOG_ERROR("Level arena could not allocate {} bytes", bytes);
+            throw std::bad_alloc();
+        }
+        m_chunks.push_back(chunk);
+        m_reservedBytes += bytes;
+        return chunk;
+    }
+
+    void* carve(std::size_t bytes)
+    {
+        if (bytes > CHUNK_BYTES / 4) [[unlikely]] {
+            // Deep books get a dedicated allocation, it still goes back to the free list when the book shrinks.
+            return newChunk(bytes);
+        }
+
+        if (m_remaining < bytes) [[unlikely]] {
+            m_cursor = static_cast<std::byte*>(newChunk(CHUNK_BYTES));
+            m_remaining = CHUNK_BYTES;
+        }
+
+        void* block = m_cursor;
+        m_cursor += bytes;
+        m_remaining -= bytes;
+        return block;
+    }
+};
+
+// SoA level array (quantities, then prices) in one arena block. The block moves to the next size class when full and back to a smaller
+// one once the side has thinned out to a quarter of its capacity, so memory follows the actual depth of the book.
+class LevelBuffer {
+    LevelArena* m_arena { &LevelArena::local() };
+    void* m_block { nullptr };
+    std::size_t m_sizeClass { 0 };
+    std::size_t m_size { 0 };
+
+    [[nodiscard]] static std::uint64_t* qtysIn(void* block)
+    {
+        return static_cast<std::uint64_t*>(block);
+    }
+
+    [[nodiscard]] static std::int32_t* pricesIn(void* block, std::size_t size_class)
+    {
+        return reinterpret_cast<std::int32_t*>(static_cast<std::uint64_t*>(block) + LevelArena::levelsIn(size_class));
+    }
+
+    __attribute__((noinline)) void resize(std::size_t size_class)
+    {
+        void* block = m_arena->allocate(size_class);
+        if (m_block != nullptr) {
+            std::memcpy(qtysIn(block), qtysIn(m_block), m_size * sizeof(std::uint64_t));
+            std::memcpy(pricesIn(block, size_class), pricesIn(m_block, m_sizeClass), m_size * sizeof(std::int32_t));
+            m_arena->deallocate(m_block, m_sizeClass);
+        }
+        m_block = block;
+        m_sizeClass = size_class;
+    }
+
+    void release()
+    {
+        if (m_block != nullptr) {
+            m_arena->deallocate(m_block, m_sizeClass);
+            m_block = nullptr;
+        }
+    }
+
+public:
+    LevelBuffer() = default;
+    LevelBuffer(const LevelBuffer&) = delete;
+    LevelBuffer& operator=(const LevelBuffer&) = delete;
+
+    LevelBuffer(LevelBuffer&& other) noexcept
+        : m_arena(other.m_arena)
+        , m_block(std::exchange(other.m_block, nullptr))
+        , m_sizeClass(other.m_sizeClass)
+        , m_size(std::exchange(other.m_size, 0))
+    {
+    }
+
+    LevelBuffer& operator=(LevelBuffer&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            m_arena = other.m_arena;
+            m_block = std::exchange(other.m_block, nullptr);
+            m_sizeClass = other.m_sizeClass;
+            m_size = std::exchange(other.m_size, 0);
+        }
+        return *this;
+    }
+
+    ~LevelBuffer()
+    {
+        release();
+    }
+
+    [[nodiscard]] std::int32_t* prices()
+    {
+        return m_block != nullptr ? pricesIn(m_block, m_sizeClass) : nullptr;
+    }
+
+    [[nodiscard]] const std::int32_t* prices() const
+    {
+        return m_block != nullptr ? pricesIn(m_block, m_sizeClass) : nullptr;
+    }
+
+    [[nodiscard]] std::uint64_t* qtys()
+    {
+        return qtysIn(m_block);
+    }
+
+    [[nodiscard]] const std::uint64_t* qtys() const
+    {
+        return static_cast<const std::uint64_t*>(m_block);
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    [[nodiscard]] std::size_t capacity() const
+    {
+        return m_block != nullptr ? LevelArena::levelsIn(m_sizeClass) : 0;
+    }
+
+    [[nodiscard]] std::size_t memoryBytes() const
+    {
+        return m_block != nullptr ? LevelArena::blockBytes(m_sizeClass) : 0;
+    }
+
+    void insert(std::size_t index, std::int32_t price, std::uint64_t qty)
+    {
+        if (m_size == capacity()) [[unlikely]] {
+            resize(m_block != nullptr ? m_sizeClass + 1 : 0);
+        }
+
+        auto* price_data = prices();
+        auto* qty_data = qtys();
+        const auto tail = m_size - index;
+        std::memmove(price_data + index + 1, price_data + index, tail * sizeof(std::int32_t));
+        std::memmove(qty_data + index + 1, qty_data + index, tail * sizeof(std::uint64_t));
+        price_data[index] = price;
+        qty_data[index] = qty;
+        ++m_size;
+    }
+
+    void erase(std::size_t index)
+    {
+        auto* price_data = prices();
+        auto* qty_data = qtys();
+        const auto tail = m_size - index - 1;
+        std::memmove(price_data + index, price_data + index + 1, tail * sizeof(std::int32_t));
+        std::memmove(qty_data + index, qty_data + index + 1, tail * sizeof(std::uint64_t));
+        --m_size;
+
+        if (m_sizeClass != 0 && m_size < LevelArena::levelsIn(m_sizeClass) / 4) [[unlikely]] {
+            resize(m_sizeClass - 1);
+        }
+    }
+};
+
+}  // namespace algocor
@@ -0,0 +1,80 @@
+#include "level_search.hpp"
+
+#include <bit>
+#include <immintrin.h>
+
+namespace algocor
+{
+
+__attribute__((target("avx2"))) std::ptrdiff_t findPriceLevelAvx2(const std::int32_t* prices, std::size_t count, std::int32_t price)
+{
+    const __m256i needle = _mm256_set1_epi32(price);
+
+    auto i = static_cast<std::ptrdiff_t>(count);
+    while (i >= 8) {
+        i -= 8;
+        const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prices + i));
+        const auto mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(block, needle))));
+        if (mask != 0) {
+            return i + 31 - std::countl_zero(mask);
+        }
+    }
+
+    return findPriceLevelScalar(prices, static_cast<std::size_t>(i), price);
+}
+
+__attribute__((target("avx512f"))) std::ptrdiff_t findPriceLevelAvx512(const std::int32_t* prices, std::size_t count, std::int32_t price)
+{
+    const __m512i needle = _mm512_set1_epi32(price);
+
+    auto i = static_cast<std::ptrdiff_t>(count);
+    while (i >= 16) {
+        i -= 16;
+        const __m512i block = _mm512_loadu_si512(prices + i);
+        const auto mask = static_cast<unsigned>(_mm512_cmpeq_epi32_mask(block, needle));
+        if (mask != 0) {
+            return i + 31 - std::countl_zero(mask);
+        }
+    }
+
+    if (i > 0) {
+        // Masked load for the tail, lanes past `i` are never read.
+        const auto tail = static_cast<__mmask16>((1U << i) - 1);
+        const __m512i block = _mm512_maskz_loadu_epi32(tail, prices);
+        const auto mask = static_cast<unsigned>(_mm512_mask_cmpeq_epi32_mask(tail, block, needle));
+        if (mask != 0) {
+            return 31 - std::countl_zero(mask);
+        }
+    }
+
+    return -1;
+}
+
+SimdLevel detectSimdLevel()
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::Avx512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::Avx2;
+    }
+    return SimdLevel::Scalar;
+}
+
+LevelSearchFn levelSearchFor(SimdLevel level)
+{
+    switch (level) {
+        case SimdLevel::Avx512:
+            return &findPriceLevelAvx512;
+        case SimdLevel::Avx2:
+            return &findPriceLevelAvx2;
+        case SimdLevel::Scalar:
+        default:
+            return &findPriceLevelScalar;
+    }
+}
+
+const LevelSearchFn findPriceLevelDispatched = levelSearchFor(detectSimdLevel());
+
+}  // namespace algocor
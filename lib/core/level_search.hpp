@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace algocor
+{
+
+// Price level search over a contiguous int32 price array (the SoA side of a book). All kernels return the index of `price` in
+// prices[0, count) or -1, and scan from the end, where the top of the book lives. Prices on one side are unique, so the first hit wins.
+using LevelSearchFn = std::ptrdiff_t (*)(const std::int32_t* prices, std::size_t count, std::int32_t price);
+
+enum class SimdLevel : std::uint8_t
+{
+    Scalar,
+    Avx2,
+    Avx512,
+};
+
+inline std::ptrdiff_t findPriceLevelScalar(const std::int32_t* prices, std::size_t count, std::int32_t price)
+{
+    for (auto i = static_cast<std::ptrdiff_t>(count) - 1; i >= 0; --i) {
+        if (prices[i] == price) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 8 prices per compare.
+std::ptrdiff_t findPriceLevelAvx2(const std::int32_t* prices, std::size_t count, std::int32_t price);
+// 16 prices per compare.
+std::ptrdiff_t findPriceLevelAvx512(const std::int32_t* prices, std::size_t count, std::int32_t price);
+
+[[nodiscard]] SimdLevel detectSimdLevel();
+[[nodiscard]] LevelSearchFn levelSearchFor(SimdLevel level);
+
+// Resolved once at startup from cpuid, so the hot path pays an indirect call and no feature checks.
+extern const LevelSearchFn findPriceLevelDispatched;
+
+// Books are usually shallow; below one vector width the indirect call costs more than the scan itself.
+inline std::ptrdiff_t findPriceLevel(const std::int32_t* prices, std::size_t count, std::int32_t price)
+{
+    if (count <= 8) {
+        return findPriceLevelScalar(prices, count, price);
+    }
+    return findPriceLevelDispatched(prices, count, price);
+}
+
+}  // namespace algocor
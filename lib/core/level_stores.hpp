@@ -0,0 +1,861 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "level_arena.hpp"
+#include "level_search.hpp"
+
+#include "../utility/overwrite_macros.hpp"
+#include "../utility/quill_wrapper.hpp"
+
+// Level store policies for BasicL2Orderbook. A store holds one side of a book and provides:
+//
+//   void add(int32_t price, uint64_t qty);                              adds to the level, creating it if needed; 0 is ignored
+//   bool remove(int32_t price, uint64_t qty);                           false if there is no level at price, erases it once consumed
+//   bool modify(int32_t price, uint64_t old_qty, uint64_t new_qty);     same-price replace, one lookup
+//   std::pair<int32_t, uint64_t> best() const;                          undefined on an empty side
+//   bool empty() const; std::size_t size() const;
+//   std::size_t memoryBytes() const;                                    heap bytes owned by the store, on top of sizeof(store)
+//   std::size_t top(std::size_t count, int32_t* prices, uint64_t* qtys) const;   copies up to `count` best levels, best first
+//   void forEach(func) const;                                           best to worst, not for the hot path
+//
+// A policy maps the side to its store: `template<bool IsBid> using Side = ...;`. Pick one per instrument class, see
+// benchmark/level_store_benchmark.cpp.
+
+namespace algocor
+{
+
+template<bool IsBid>
+[[nodiscard]] constexpr bool isBetterPrice(std::int32_t lhs, std::int32_t rhs)
+{
+    if constexpr (IsBid) {
+        return lhs > rhs;
+    } else {
+        return lhs < rhs;
+    }
+}
+
+// Approximate heap footprint of a std::map with `count` entries: the value plus parent/left/right pointers and the colour.
+template<typename Key, typename Value>
+[[nodiscard]] constexpr std::size_t mapMemoryBytes(std::size_t count)
+{
+    return count * (sizeof(std::pair<const Key, Value>) + 4 * sizeof(void*));
+}
+
+// First index in the ascending keys[0, count) whose key is >= `key`, without a data-dependent branch per probe.
+// Reference: Khuong, Morin - Array Layouts for Comparison-Based Searching.
+[[nodiscard]] inline std::size_t branchlessLowerBound(const std::int32_t* keys, std::size_t count, std::int32_t key)
+{
+    if (count == 0) {
+        return 0;
+    }
+
+    const std::int32_t* base = keys;
+    while (count > 1) {
+        const std::size_t half = count / 2;
+        base = (base[half] < key) ? base + half : base;
+        count -= half;
+    }
+    return static_cast<std::size_t>(base - keys) + (*base < key);
+}
+
+// Sorted SoA arrays, worst level first and top of the book at the end, searched with the SIMD kernels from level_search.hpp. Storage
+// comes from the shared LevelArena and grows with the book.
+template<bool IsBid>
+class SortedVectorLevels {
+    LevelBuffer m_levels;
+
+public:
+    [[nodiscard]] std::ptrdiff_t find(std::int32_t price) const
+    {
+        return findPriceLevel(m_levels.prices(), m_levels.size(), price);
+    }
+
+    void add(std::int32_t price, std::uint64_t qty)
+    {
+        if (qty == 0) [[unlikely]] {
+            return;
+        }
+        const auto index = find(price);
+        if (index >= 0) [[likely]] {
+            m_levels.qtys()[index] += qty;
+            return;
+        }
+
+        // New level. Walk down from the top of the book, new levels mostly appear close to it.
+        const auto* prices = m_levels.prices();
+        auto insert_at = m_levels.size();
+        while (insert_at > 0 && isBetterPrice<IsBid>(prices[insert_at - 1], price)) {
+            --insert_at;
+        }
+        m_levels.insert(insert_at, price, qty);
+    }
+
+    bool remove(std::int32_t price, std::uint64_t qty)
+    {
+        const auto index = find(price);
+        if (index < 0) [[unlikely]] {
+            return false;
+        }
+
+        auto* qtys = m_levels.qtys();
+        if (qtys[index] > qty) [[likely]] {
+            qtys[index] -= qty;
+        } else {
+            m_levels.erase(static_cast<std::size_t>(index));
+        }
+        return true;
+    }
+
+    bool modify(std::int32_t price, std::uint64_t old_qty, std::uint64_t new_qty)
+    {
+        const auto index = find(price);
+        if (index < 0) [[unlikely]] {
+            return false;
+        }
+
+        auto* qtys = m_levels.qtys();
+        qtys[index] = qtys[index] - old_qty + new_qty;
+        if (qtys[index] == 0) [[unlikely]] {
+            m_levels.erase(static_cast<std::size_t>(index));
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::pair<std::int32_t, std::uint64_t> best() const
+    {
+        const auto top = m_levels.size() - 1;
+        return { m_levels.prices()[top], m_levels.qtys()[top] };
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_levels.empty();
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_levels.size();
+    }
+
+    [[nodiscard]] std::size_t memoryBytes() const
+    {
+        return m_levels.memoryBytes();
+    }
+
+    std::size_t top(std::size_t count, std::int32_t* prices, std::uint64_t* qtys) const
+    {
+        const auto levels = std::min(count, m_levels.size());
+        for (std::size_t i = 0; i < levels; ++i) {
+            prices[i] = m_levels.prices()[m_levels.size() - 1 - i];
+            qtys[i] = m_levels.qtys()[m_levels.size() - 1 - i];
+        }
+        return levels;
+    }
+
+    template<typename Func>
+    void forEach(Func&& func) const
+    {
+        for (auto i = static_cast<std::ptrdiff_t>(m_levels.size()) - 1; i >= 0; --i) {
+            func(m_levels.prices()[i], m_levels.qtys()[i]);
+        }
+    }
+};
+
+// Sorted SoA arrays searched with a branchless binary search (cmov instead of a mispredicted branch per probe). Prices are stored as
+// keys that ascend towards the top of the book on both sides: the price itself for bids, its bitwise complement for asks.
+template<bool IsBid>
+class BranchlessBinaryLevels {
+    LevelBuffer m_levels;  // prices() holds the keys.
+
+    [[nodiscard]] static constexpr std::int32_t toKey(std::int32_t price)
+    {
+        return IsBid ? price : ~price;
+    }
+
+    [[nodiscard]] std::size_t lowerBound(std::int32_t key) const
+    {
+        return branchlessLowerBound(m_levels.prices(), m_levels.size(), key);
+    }
+
+    // Index of the level with `key`, or size() if there is none.
+    [[nodiscard]] std::size_t find(std::int32_t key) const
+    {
+        const auto index = lowerBound(key);
+        return (index < m_levels.size() && m_levels.prices()[index] == key) ? index : m_levels.size();
+    }
+
+public:
+    void add(std::int32_t price, std::uint64_t qty)
+    {
+        if (qty == 0) [[unlikely]] {
+            return;
+        }
+        const auto key = toKey(price);
+        const auto index = lowerBound(key);
+        if (index < m_levels.size() && m_levels.prices()[index] == key) [[likely]] {
+            m_levels.qtys()[index] += qty;
+            return;
+        }
+
+        m_levels.insert(index, key, qty);
+    }
+
+    bool remove(std::int32_t price, std::uint64_t qty)
+    {
+        const auto index = find(toKey(price));
+        if (index == m_levels.size()) [[unlikely]] {
+            return false;
+        }
+
+        auto* qtys = m_levels.qtys();
+        if (qtys[index] > qty) [[likely]] {
+            qtys[index] -= qty;
+        } else {
+            m_levels.erase(index);
+        }
+        return true;
+    }
+
+    bool modify(std::int32_t price, std::uint64_t old_qty, std::uint64_t new_qty)
+    {
+        const auto index = find(toKey(price));
+        if (index == m_levels.size()) [[unlikely]] {
+            return false;
+        }
+
+        auto* qtys = m_levels.qtys();
+        qtys[index] = qtys[index] - old_qty + new_qty;
+        if (qtys[index] == 0) [[unlikely]] {
+            m_levels.erase(index);
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::pair<std::int32_t, std::uint64_t> best() const
+    {
+        const auto top = m_levels.size() - 1;
+        return { toKey(m_levels.prices()[top]), m_levels.qtys()[top] };
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_levels.empty();
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_levels.size();
+    }
+
+    [[nodiscard]] std::size_t memoryBytes() const
+    {
+        return m_levels.memoryBytes();
+    }
+
+    std::size_t top(std::size_t count, std::int32_t* prices, std::uint64_t* qtys) const
+    {
+        const auto levels = std::min(count, m_levels.size());
+        for (std::size_t i = 0; i < levels; ++i) {
+            prices[i] = toKey(m_levels.prices()[m_levels.size() - 1 - i]);
+            qtys[i] = m_levels.qtys()[m_levels.size() - 1 - i];
+        }
+        return levels;
+    }
+
+    template<typename Func>
+    void forEach(Func&& func) const
+    {
+        for (auto i = static_cast<std::ptrdiff_t>(m_levels.size()) - 1; i >= 0; --i) {
+            func(toKey(m_levels.prices()[i]), m_levels.qtys()[i]);
+        }
+    }
+};
+
+// Two-level B+tree: fixed-size sorted leaves plus one inner array holding the largest key of every leaf. A new level memmoves at most
+// one leaf and the (short) inner array instead of the whole side, which pays off on books with hundreds of levels. Keys ascend towards
+// the top of the book like in BranchlessBinaryLevels, so the best level is the last entry of the last leaf.
+template<bool IsBid, std::size_t LeafCapacity = 32>
+class BPlusTreeLevels {
+    static_assert(LeafCapacity >= 4);
+
+    struct Leaf {
+        std::uint32_t count { 0 };
+        std::array<std::int32_t, LeafCapacity> keys {};
+        std::array<std::uint64_t, LeafCapacity> qtys {};
+    };
+
+    std::vector<std::int32_t> m_maxKeys;  // inner node: largest key of each leaf, ascending.
+    std::vector<std::uint32_t> m_leafIds;  // inner node: leaf storage index, parallel to m_maxKeys.
+    std::vector<Leaf> m_leaves;
+    std::vector<std::uint32_t> m_freeLeaves;
+    std::size_t m_size { 0 };
+
+    [[nodiscard]] static constexpr std::int32_t toKey(std::int32_t price)
+    {
+        return IsBid ? price : ~price;
+    }
+
+    // First leaf whose max key is >= key, clamped to the last leaf.
+    [[nodiscard]] std::size_t findLeaf(std::int32_t key) const
+    {
+        const auto index = branchlessLowerBound(m_maxKeys.data(), m_maxKeys.size(), key);
+        return index < m_maxKeys.size() ? index : m_maxKeys.size() - 1;
+    }
+
+    [[nodiscard]] static std::uint32_t lowerBoundInLeaf(const Leaf& leaf, std::int32_t key)
+    {
+        return static_cast<std::uint32_t>(branchlessLowerBound(leaf.keys.data(), leaf.count, key));
+    }
+
+    std::uint32_t allocateLeaf()
+    {
+        if (!m_freeLeaves.empty()) {
+            const auto id = m_freeLeaves.back();
+            m_freeLeaves.pop_back();
+            m_leaves[id].count = 0;
+            return id;
+        }
+        m_leaves.emplace_back();
+        return static_cast<std::uint32_t>(m_leaves.size() - 1);
+    }
+
+    void insertIntoLeaf(Leaf& leaf, std::uint32_t pos, std::int32_t key, std::uint64_t qty)
+    {
+        const auto tail = leaf.count - pos;
+        std::memmove(leaf.keys.data() + pos + 1, leaf.keys.data() + pos, tail * sizeof(std::int32_t));
+        std::memmove(leaf.qtys.data() + pos + 1, leaf.qtys.data() + pos, tail * sizeof(std::uint64_t));
+        leaf.keys[pos] = key;
+        leaf.qtys[pos] = qty;
+        ++leaf.count;
+    }
+
+    void eraseFromLeaf(std::size_t inner, std::uint32_t pos)
+    {
+        auto& leaf = m_leaves[m_leafIds[inner]];
+        const auto tail = leaf.count - pos - 1;
+        std::memmove(leaf.keys.data() + pos, leaf.keys.data() + pos + 1, tail * sizeof(std::int32_t));
+        std::memmove(leaf.qtys.data() + pos, leaf.qtys.data() + pos + 1, tail * sizeof(std::uint64_t));
+        --leaf.count;
+        --m_size;
+
+        if (leaf.count == 0) {
+            m_freeLeaves.push_back(m_leafIds[inner]);
+            m_maxKeys.erase(m_maxKeys.begin() + static_cast<std::ptrdiff_t>(inner));
+            m_leafIds.erase(m_leafIds.begin() + static_cast<std::ptrdiff_t>(inner));
+        } else {
+            m_maxKeys[inner] = leaf.keys[leaf.count - 1];
+        }
+    }
+
+    // Returns {inner index, position in leaf} of `key`, inner index is npos if not found.
+    [[nodiscard]] std::pair<std::size_t, std::uint32_t> locate(std::int32_t key) const
+    {
+        if (m_maxKeys.empty()) [[unlikely]] {
+            return { npos, 0 };
+        }
+
+        const auto inner = findLeaf(key);
+        const auto& leaf = m_leaves[m_leafIds[inner]];
+        const auto pos = lowerBoundInLeaf(leaf, key);
+        if (pos < leaf.count && leaf.keys[pos] == key) [[likely]] {
+            return { inner, pos };
+        }
+        return { npos, 0 };
+    }
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+public:
+    void add(std::int32_t price, std::uint64_t qty)
+    {
+        if (qty == 0) [[unlikely]] {
+            return;
+        }
+        const auto key = toKey(price);
+
+        if (m_maxKeys.empty()) [[unlikely]] {
+            const auto id = allocateLeaf();
+            insertIntoLeaf(m_leaves[id], 0, key, qty);
+            m_maxKeys.push_back(key);
+            m_leafIds.push_back(id);
+            ++m_size;
+            return;
+        }
+
+        auto inner = findLeaf(key);
+        auto* leaf = &m_leaves[m_leafIds[inner]];
+        auto pos = lowerBoundInLeaf(*leaf, key);
+        if (pos < leaf->count && leaf->keys[pos] == key) [[likely]] {
+            leaf->qtys[pos] += qty;
+            return;
+        }
+
+        if (leaf->count == LeafCapacity) [[unlikely]] {
+            // Split: the upper half moves to a new leaf right after this one.
+            const auto new_id = allocateLeaf();
+            leaf = &m_leaves[m_leafIds[inner]];  // allocation may have moved the leaves.
+            auto& right = m_leaves[new_id];
+            const auto half = static_cast<std::uint32_t>(LeafCapacity / 2);
+            right.count = static_cast<std::uint32_t>(LeafCapacity) - half;
+            std::memcpy(right.keys.data(), leaf->keys.data() + half, right.count * sizeof(std::int32_t));
+            std::memcpy(right.qtys.data(), leaf->qtys.data() + half, right.count * sizeof(std::uint64_t));
+            leaf->count = half;
+
+            m_maxKeys[inner] = leaf->keys[half - 1];
+            m_maxKeys.insert(m_maxKeys.begin() + static_cast<std::ptrdiff_t>(inner) + 1, right.keys[right.count - 1]);
+            m_leafIds.insert(m_leafIds.begin() + static_cast<std::ptrdiff_t>(inner) + 1, new_id);
+
+            if (pos > half) {
+                ++inner;
+                leaf = &right;
+                pos -= half;
+            }
+        }
+
+        insertIntoLeaf(*leaf, pos, key, qty);
+        if (key > m_maxKeys[inner]) {
+            m_maxKeys[inner] = key;
+        }
+        ++m_size;
+    }
+
+    bool remove(std::int32_t price, std::uint64_t qty)
+    {
+        const auto [inner, pos] = locate(toKey(price));
+        if (inner == npos) [[unlikely]] {
+            return false;
+        }
+
+        auto& level_qty = m_leaves[m_leafIds[inner]].qtys[pos];
+        if (level_qty > qty) [[likely]] {
+            level_qty -= qty;
+        } else {
+            eraseFromLeaf(inner, pos);
+        }
+        return true;
+    }
+
+    bool modify(std::int32_t price, std::uint64_t old_qty, std::uint64_t new_qty)
+    {
+        const auto [inner, pos] = locate(toKey(price));
+        if (inner == npos) [[unlikely]] {
+            return false;
+        }
+
+        auto& level_qty = m_leaves[m_leafIds[inner]].qtys[pos];
+        level_qty = level_qty - old_qty + new_qty;
+        if (level_qty == 0) [[unlikely]] {
+            eraseFromLeaf(inner, pos);
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::pair<std::int32_t, std::uint64_t> best() const
+    {
+        const auto& leaf = m_leaves[m_leafIds.back()];
+        return { toKey(leaf.keys[leaf.count - 1]), leaf.qtys[leaf.count - 1] };
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] std::size_t memoryBytes() const
+    {
+        return m_leaves.capacity() * sizeof(Leaf) + m_maxKeys.capacity() * sizeof(std::int32_t)
+            + m_leafIds.capacity() * sizeof(std::uint32_t) + m_freeLeaves.capacity() * sizeof(std::uint32_t);
+    }
+
+    std::size_t top(std::size_t count, std::int32_t* prices, std::uint64_t* qtys) const
+    {
+        std::size_t levels = 0;
+        for (auto inner = static_cast<std::ptrdiff_t>(m_leafIds.size()) - 1; inner >= 0 && levels < count; --inner) {
+            const auto& leaf = m_leaves[m_leafIds[inner]];
+            for (auto pos = static_cast<std::ptrdiff_t>(leaf.count) - 1; pos >= 0 && levels < count; --pos, ++levels) {
+                prices[levels] = toKey(leaf.keys[pos]);
+                qtys[levels] = leaf.qtys[pos];
+            }
+        }
+        return levels;
+    }
+
+    template<typename Func>
+    void forEach(Func&& func) const
+    {
+        for (auto inner = static_cast<std::ptrdiff_t>(m_leafIds.size()) - 1; inner >= 0; --inner) {
+            const auto& leaf = m_leaves[m_leafIds[inner]];
+            for (auto pos = static_cast<std::ptrdiff_t>(leaf.count) - 1; pos >= 0; --pos) {
+                func(toKey(leaf.keys[pos]), leaf.qtys[pos]);
+            }
+        }
+    }
+};
+
+// Sorted SoA arrays of fixed capacity inside the book itself: no allocation, no pointer chase. Only for instruments whose depth is known
+// to stay below Capacity (e.g. thin equities inside their daily price limits). When full, the worst level is dropped and reported.
+template<bool IsBid, std::size_t Capacity = 128>
+class FixedArrayLevels {
+    std::array<std::int32_t, Capacity> m_prices {};
+    std::array<std::uint64_t, Capacity> m_qtys {};
+    std::size_t m_count { 0 };
+
+    void erase(std::ptrdiff_t index)
+    {
+        const auto tail = m_count - static_cast<std::size_t>(index) - 1;
+        std::memmove(m_prices.data() + index, m_prices.data() + index + 1, tail * sizeof(std::int32_t));
+        std::memmove(m_qtys.data() + index, m_qtys.data() + index + 1, tail * sizeof(std::uint64_t));
+        --m_count;
+    }
+
+public:
+    [[nodiscard]] std::ptrdiff_t find(std::int32_t price) const
+    {
+        return findPriceLevel(m_prices.data(), m_count, price);
+    }
+
+    void add(std::int32_t price, std::uint64_t qty)
+    {
+        if (qty == 0) [[unlikely]] {
+            return;
+        }
+        const auto index = find(price);
+        if (index >= 0) [[likely]] {
+            m_qtys[index] += qty;
+            return;
+        }
+
+        if (m_count == Capacity) [[unlikely]] {
+            if (!isBetterPrice<IsBid>(price, m_prices[0])) {
+                LOG_ERROR("Fixed level store is full, dropping new worst level. Price: {}, Qty: {}", price, qty);
+                return;
+            }
+            LOG_ERROR("Fixed level store is full, dropping worst level. Price: {}, Qty: {}", m_prices[0], m_qtys[0]);
+            erase(0);
+        }
+
+        auto insert_at = static_cast<std::ptrdiff_t>(m_count);
+        while (insert_at > 0 && isBetterPrice<IsBid>(m_prices[insert_at - 1], price)) {
+            --insert_at;
+        }
+        const auto tail = m_count - static_cast<std::size_t>(insert_at);
+        std::memmove(m_prices.data() + insert_at + 1, m_prices.data() + insert_at, tail * sizeof(std::int32_t));
+        std::memmove(m_qtys.data() + insert_at + 1, m_qtys.data() + insert_at, tail * sizeof(std::uint64_t));
+        m_prices[insert_at] = price;
+        m_qtys[insert_at] = qty;
+        ++m_count;
+    }
+
+    bool remove(std::int32_t price, std::uint64_t qty)
+    {
+        const auto index = find(price);
+        if (index < 0) [[unlikely]] {
+            return false;
+        }
+
+        if (m_qtys[index] > qty) [[likely]] {
+            m_qtys[index] -= qty;
+        } else {
+            erase(index);
+        }
+        return true;
+    }
+
+    bool modify(std::int32_t price, std::uint64_t old_qty, std::uint64_t new_qty)
+    {
+        const auto index = find(price);
+        if (index < 0) [[unlikely]] {
+            return false;
+        }
+
+        m_qtys[index] = m_qtys[index] - old_qty + new_qty;
+        if (m_qtys[index] == 0) [[unlikely]] {
+            erase(index);
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::pair<std::int32_t, std::uint64_t> best() const
+    {
+        return { m_prices[m_count - 1], m_qtys[m_count - 1] };
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_count == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_count;
+    }
+
+    [[nodiscard]] std::size_t memoryBytes() const
+    {
+        return 0;
+    }
+
+    std::size_t top(std::size_t count, std::int32_t* prices, std::uint64_t* qtys) const
+    {
+        const auto levels = std::min(count, m_count);
+        for (std::size_t i = 0; i < levels; ++i) {
+            prices[i] = m_prices[m_count - 1 - i];
+            qtys[i] = m_qtys[m_count - 1 - i];
+        }
+        return levels;
+    }
+
+    template<typename Func>
+    void forEach(Func&& func) const
+    {
+        for (auto i = static_cast<std::ptrdiff_t>(m_count) - 1; i >= 0; --i) {
+            func(m_prices[i], m_qtys[i]);
+        }
+    }
+};
+
+// Bounded-depth store: the best N levels live in fixed SoA arrays inside the book (best at the end, like FixedArrayLevels), so the working
+// set strategies actually read stays in a few cache lines. Deeper levels go to a cold std::map. The hot arrays are refilled from it only
+// after they drain below N / 2, which keeps the promotion cost off most deletes.
+//
+// Invariant: every overflow level is worse than every hot level.
+template<bool IsBid, std::size_t N = 16>
+class TopNLevels {
+    static_assert(N >= 2, "need room for hysteresis");
+
+    std::array<std::int32_t, N> m_prices {};
+    std::array<std::uint64_t, N> m_qtys {};
+    std::size_t m_count { 0 };
+
+    std::map<std::int32_t, std::uint64_t> m_overflow;
+
+    void erase(std::ptrdiff_t index)
+    {
+        const auto tail = m_count - static_cast<std::size_t>(index) - 1;
+        std::memmove(m_prices.data() + index, m_prices.data() + index + 1, tail * sizeof(std::int32_t));
+        std::memmove(m_qtys.data() + index, m_qtys.data() + index + 1, tail * sizeof(std::uint64_t));
+        --m_count;
+
+        if (m_count < N / 2 && !m_overflow.empty()) [[unlikely]] {
+            promote();
+        }
+    }
+
+    // Moves the best overflow levels below the hot ones until the hot arrays are full again.
+    __attribute__((noinline, cold)) void promote()
+    {
+        const auto moved = std::min(N - m_count, m_overflow.size());
+        std::memmove(m_prices.data() + moved, m_prices.data(), m_count * sizeof(std::int32_t));
+        std::memmove(m_qtys.data() + moved, m_qtys.data(), m_count * sizeof(std::uint64_t));
+
+        for (auto i = static_cast<std::ptrdiff_t>(moved) - 1; i >= 0; --i) {
+            auto iter = IsBid ? std::prev(m_overflow.end()) : m_overflow.begin();
+            m_prices[i] = iter->first;
+            m_qtys[i] = iter->second;
+            m_overflow.erase(iter);
+        }
+        m_count += moved;
+    }
+
+public:
+    [[nodiscard]] std::ptrdiff_t find(std::int32_t price) const
+    {
+        return findPriceLevel(m_prices.data(), m_count, price);
+    }
+
+    void add(std::int32_t price, std::uint64_t qty)
+    {
+        if (qty == 0) [[unlikely]] {
+            return;
+        }
+        const auto index = find(price);
+        if (index >= 0) [[likely]] {
+            m_qtys[index] += qty;
+            return;
+        }
+
+        if (m_count != 0 && !isBetterPrice<IsBid>(price, m_prices[0]) && (m_count == N || !m_overflow.empty())) {
+            m_overflow[price] += qty;
+            return;
+        }
+
+        if (m_count == N) {
+            // Demote the worst hot level, it is still better than everything already in the overflow.
+            m_overflow.emplace(m_prices[0], m_qtys[0]);
+            std::memmove(m_prices.data(), m_prices.data() + 1, (N - 1) * sizeof(std::int32_t));
+            std::memmove(m_qtys.data(), m_qtys.data() + 1, (N - 1) * sizeof(std::uint64_t));
+            --m_count;
+        }
+
+        auto insert_at = static_cast<std::ptrdiff_t>(m_count);
+        while (insert_at > 0 && isBetterPrice<IsBid>(m_prices[insert_at - 1], price)) {
+            --insert_at;
+        }
+        const auto tail = m_count - static_cast<std::size_t>(insert_at);
+        std::memmove(m_prices.data() + insert_at + 1, m_prices.data() + insert_at, tail * sizeof(std::int32_t));
+        std::memmove(m_qtys.data() + insert_at + 1, m_qtys.data() + insert_at, tail * sizeof(std::uint64_t));
+        m_prices[insert_at] = price;
+        m_qtys[insert_at] = qty;
+        ++m_count;
+    }
+
+    bool remove(std::int32_t price, std::uint64_t qty)
+    {
+        const auto index = find(price);
+        if (index >= 0) [[likely]] {
+            if (m_qtys[index] > qty) [[likely]] {
+                m_qtys[index] -= qty;
+            } else {
+                erase(index);
+            }
+            return true;
+        }
+
+        auto iter = m_overflow.find(price);
+        if (iter == m_overflow.end()) [[unlikely]] {
+            return false;
+        }
+
+        if (iter->second > qty) {
+            iter->second -= qty;
+        } else {
+            m_overflow.erase(iter);
+        }
+        return true;
+    }
+
+    bool modify(std::int32_t price, std::uint64_t old_qty, std::uint64_t new_qty)
+    {
+        const auto index = find(price);
+        if (index >= 0) [[likely]] {
+            m_qtys[index] = m_qtys[index] - old_qty + new_qty;
+            if (m_qtys[index] == 0) [[unlikely]] {
+                erase(index);
+            }
+            return true;
+        }
+
+        auto iter = m_overflow.find(price);
+        if (iter == m_overflow.end()) [[unlikely]] {
+            return false;
+        }
+
+        iter->second = iter->second - old_qty + new_qty;
+        if (iter->second == 0) {
+            m_overflow.erase(iter);
+        }
+        return true;
+    }
+
+    [[nodiscard]] std::pair<std::int32_t, std::uint64_t> best() const
+    {
+        return { m_prices[m_count - 1], m_qtys[m_count - 1] };
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_count == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_count + m_overflow.size();
+    }
+
+    [[nodiscard]] std::size_t memoryBytes() const
+    {
+        return mapMemoryBytes<std::int32_t, std::uint64_t>(m_overflow.size());
+    }
+
+    // Number of levels currently in the hot arrays.
+    [[nodiscard]] std::size_t hotSize() const
+    {
+        return m_count;
+    }
+
+    std::size_t top(std::size_t count, std::int32_t* prices, std::uint64_t* qtys) const
+    {
+        auto levels = std::min(count, m_count);
+        for (std::size_t i = 0; i < levels; ++i) {
+            prices[i] = m_prices[m_count - 1 - i];
+            qtys[i] = m_qtys[m_count - 1 - i];
+        }
+
+        // Cold path: only when asked for more than the hot levels.
+        const auto copy = [&](const auto& level) {
+            prices[levels] = level.first;
+            qtys[levels] = level.second;
+            ++levels;
+        };
+        if constexpr (IsBid) {
+            for (auto iter = m_overflow.rbegin(); iter != m_overflow.rend() && levels < count; ++iter) {
+                copy(*iter);
+            }
+        } else {
+            for (auto iter = m_overflow.begin(); iter != m_overflow.end() && levels < count; ++iter) {
+                copy(*iter);
+            }
+        }
+        return levels;
+    }
+
+    template<typename Func>
+    void forEach(Func&& func) const
+    {
+        for (auto i = static_cast<std::ptrdiff_t>(m_count) - 1; i >= 0; --i) {
+            func(m_prices[i], m_qtys[i]);
+        }
+        if constexpr (IsBid) {
+            for (auto iter = m_overflow.rbegin(); iter != m_overflow.rend(); ++iter) {
+                func(iter->first, iter->second);
+            }
+        } else {
+            for (const auto& [price, qty] : m_overflow) {
+                func(price, qty);
+            }
+        }
+    }
+};
+
+struct SortedVectorPolicy {
+    template<bool IsBid>
+    using Side = SortedVectorLevels<IsBid>;
+};
+
+struct BranchlessBinaryPolicy {
+    template<bool IsBid>
+    using Side = BranchlessBinaryLevels<IsBid>;
+};
+
+struct BPlusTreePolicy {
+    template<bool IsBid>
+    using Side = BPlusTreeLevels<IsBid>;
+};
+
+template<std::size_t Capacity = 128>
+struct FixedArrayPolicy {
+    template<bool IsBid>
+    using Side = FixedArrayLevels<IsBid, Capacity>;
+};
+
+template<std::size_t N = 16>
+struct TopNPolicy {
+    template<bool IsBid>
+    using Side = TopNLevels<IsBid, N>;
+};
+
+}  // namespace algocor
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace algocor
+{
+
+// ITCH order ids are unique per orderbook and side only, so all three make up the key of a resting order.
+struct OrderKey {
+    uint64_t order_id;
+    uint32_t orderbook_id;
+    char side;
+
+    friend bool operator==(const OrderKey&, const OrderKey&) = default;
+};
+
+// Packs the key into one 64-bit word: side in the low bit, orderbook id folded into the high bits. Collisions of the packed word only
+// cost a probe, entries compare the full key.
+inline uint64_t packOrderKey(const OrderKey& key)
+{
+    return ((key.order_id << 1) | static_cast<uint64_t>(key.side == 'S')) ^ (static_cast<uint64_t>(key.orderbook_id) << 40);
+}
+
+// murmur3 finalizer over the packed key. Order ids are mostly sequential, the mix spreads them over the whole table.
+inline uint64_t hashOrderKey(const OrderKey& key)
+{
+    auto hash = packOrderKey(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Open addressing order index: one flat power of two array of entries, linear probing, backward shift deletion. No tombstones, so probe
+// sequences stay as short after millions of deletes as after the first adds, and no node allocation per order. Growing rehashes every
+// entry; call reserve() with the expected number of live orders at startup to keep that off the trading session.
+template<typename Value>
+class FlatOrderIndex {
+public:
+    struct Entry {
+        OrderKey key;  // side 0 marks an empty entry.
+        Value value;
+    };
+
+    static constexpr std::size_t MIN_CAPACITY = 64;
+
+    FlatOrderIndex()
+    {
+        rehash(MIN_CAPACITY);
+    }
+
+    [[nodiscard]] Entry* find(const OrderKey& key)
+    {
+        for (auto index = hashOrderKey(key) & m_mask;; index = (index + 1) & m_mask) {
+            auto& entry = m_entries[index];
+            if (entry.key == key) {
+                return &entry;
+            }
+            if (entry.key.side == 0) {
+                return nullptr;
+            }
+        }
+    }
+
+    [[nodiscard]] const Entry* find(const OrderKey& key) const
+    {
+        return const_cast<FlatOrderIndex*>(this)->find(key);
+    }
+
+    [[nodiscard]] bool contains(const OrderKey& key) const
+    {
+        return find(key) != nullptr;
+    }
+
+    // Inserts `value` unless `key` is present. Returns the entry of `key` and whether it was inserted.
+    std::pair<Entry*, bool> tryEmplace(const OrderKey& key, const Value& value)
+    {
+        if (full()) [[unlikely]] {
+            rehash(capacity() * 2);
+        }
+
+        auto index = hashOrderKey(key) & m_mask;
+        while (m_entries[index].key.side != 0) {
+            if (m_entries[index].key == key) {
+                return { &m_entries[index], false };
+            }
+            index = (index + 1) & m_mask;
+        }
+
+        m_entries[index] = { key, value };
+        ++m_size;
+        return { &m_entries[index], true };
+    }
+
+    // Inserts or overwrites the value of `key`.
+    Entry& insert(const OrderKey& key, const Value& value)
+    {
+        auto [entry, inserted] = tryEmplace(key, value);
+        if (!inserted) {
+            entry->value = value;
+        }
+        return *entry;
+    }
+
+    // Removes an entry returned by find(). Entries after it in the same cluster that would no longer be reachable from their home slot
+    // are shifted back into the gap.
+    void erase(Entry* entry)
+    {
+        auto hole = static_cast<std::size_t>(entry - m_entries.get());
+        for (auto index = (hole + 1) & m_mask;; index = (index + 1) & m_mask) {
+            auto& next = m_entries[index];
+            if (next.key.side == 0) {
+                break;
+            }
+
+            // The entry may move into the hole unless its home slot lies cyclically in (hole, index].
+            const auto home = hashOrderKey(next.key) & m_mask;
+            if (((index - home) & m_mask) >= ((index - hole) & m_mask)) {
+                m_entries[hole] = next;
+                hole = index;
+            }
+        }
+
+        m_entries[hole].key.side = 0;
+        --m_size;
+    }
+
+    bool erase(const OrderKey& key)
+    {
+        auto* entry = find(key);
+        if (entry == nullptr) {
+            return false;
+        }
+        erase(entry);
+        return true;
+    }
+
+    // Pulls the home slot of `key` into the cache, e.g. while the previous message of a packet is still being applied.
+    void prefetch(const OrderKey& key) const
+    {
+        __builtin_prefetch(&m_entries[hashOrderKey(key) & m_mask]);
+    }
+
+    void reserve(std::size_t count)
+    {
+        const auto wanted = std::bit_ceil(count + count / 3 + 1);
+        if (wanted > capacity()) {
+            rehash(wanted);
+        }
+    }
+
+    void clear()
+    {
+        for (std::size_t index = 0; index < capacity(); ++index) {
+            m_entries[index].key.side = 0;
+        }
+        m_size = 0;
+    }
+
+    template<typename Func>
+    void forEach(Func&& func) const
+    {
+        for (std::size_t index = 0; index < capacity(); ++index) {
+            if (m_entries[index].key.side != 0) {
+                func(m_entries[index]);
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    [[nodiscard]] std::size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    // The next insert rehashes.
+    [[nodiscard]] bool full() const
+    {
+        return (m_size + 1) * 4 > capacity() * 3;
+    }
+
+    [[nodiscard]] std::size_t memoryBytes() const
+    {
+        return capacity() * sizeof(Entry);
+    }
+
+private:
+    std::unique_ptr<Entry[]> m_entries;
+    std::size_t m_mask { 0 };
+    std::size_t m_size { 0 };
+
+    void rehash(std::size_t new_capacity)
+    {
+        const auto old_capacity = m_entries ? capacity() : 0;
+        auto old_entries = std::exchange(m_entries, std::make_unique<Entry[]>(new_capacity));
+        m_mask = new_capacity - 1;
+
+        for (std::size_t index = 0; index < old_capacity; ++index) {
+            const auto& entry = old_entries[index];
+            if (entry.key.side == 0) {
+                continue;
+            }
+            auto slot = hashOrderKey(entry.key) & m_mask;
+            while (m_entries[slot].key.side != 0) {
+                slot = (slot + 1) & m_mask;
+            }
+            m_entries[slot] = entry;
+        }
+    }
+};
+
+}  // namespace algocor
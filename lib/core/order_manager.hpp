@@ -15,6 +15,7 @@
 #include <vector>
 
 #include "../utility/overwrite_macros.hpp"
+#include "own_orders.hpp"
 
 namespace
 {
@@ -44,6 +45,7 @@ static constexpr size_t ORDERS_SIZE = 1 << 10;  // 1'048'576
 
 // TODO: is this the ideal structure. do I need to pack it, do I need to rearrange fields?
 struct Order {
+    uint64_t order_id;  // exchange order id, from OrderAccepted.
     uint64_t quantity;
     uint32_t orderbook_id;
     int32_t price;
@@ -53,7 +55,8 @@ struct Order {
     };  // if fully executed or canceled or rejected, this will be false. -> TODO: I AM NOT SURE ABOUT THE USE CASE OF THIS.
     // 3 bytes of padding added to maintain alignment
 };
-static_assert(sizeof(Order) == 24);
+static_assert(sizeof(Order) == 32);
+static_assert(ORDERS_SIZE <= OwnOrderMap::CAPACITY);
 
 // this is not supposed to thread-safe. each OUCH session will have its own order manager.
 // this class will only be modified upon receiving responses (not requests!)
@@ -88,7 +91,12 @@ public:
         }
     }
 
-    void orderAccepted(const std::array<char, 14>& token, uint64_t quantity, uint32_t orderbook_id, int32_t price, char side)
+    void orderAccepted(const std::array<char, 14>& token,
+        uint64_t order_id,
+        uint64_t quantity,
+        uint32_t orderbook_id,
+        int32_t price,
+        char side)
     {
         const auto index = parse_order_token_decimal(token);
 
@@ -99,6 +107,7 @@ public:
         LOG_TRACE_L3("Index: {}", index);
 
         auto& order = m_orders[index];
+        order.order_id = order_id;
         order.orderbook_id = orderbook_id;
         order.quantity = quantity;
         order.price = price;
@@ -111,6 +120,18 @@ public:
             side,
             quantity,
             price);
+
+        if (!m_ownOrders.insert(order_id, static_cast<uint32_t>(index), be32toh(orderbook_id), side)) [[unlikely]] {
+            LOG_ERROR("Token: {}. Order id {} not added to the own order map, its queue position is not tracked",
+                toString(token),
+                order_id);
+        }
+    }
+
+    // Our live orders by exchange order id, for the book builders to track their queue positions.
+    [[nodiscard]] OwnOrderMap& ownOrders()
+    {
+        return m_ownOrders;
     }
 
     // we will only support price modification.
@@ -167,6 +188,7 @@ public:
         if (order->quantity == 0) {
             LOG_TRACE_L3("Token: {}. Quantity is 0 after execution, the order is no longer active", toString(token));
             order->is_valid = false;
+            m_ownOrders.erase(order->order_id);
         }
     }
 
@@ -179,6 +201,7 @@ public:
         }
 
         order->is_valid = false;
+        m_ownOrders.erase(order->order_id);
     }
 
     [[nodiscard]] std::array<char, 14> nextToken()
@@ -226,6 +249,8 @@ private:
     std::array<char, 14> m_token {};
     // size_t m_index = 0;
 
+    OwnOrderMap m_ownOrders;
+
     // TODO: maybe use std::array here.
     std::vector<std::pair<std::array<char, 14>, std::array<char, 14>>> m_originalToReplacementTokens;
 
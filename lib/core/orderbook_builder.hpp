@@ -1,113 +1,986 @@
 #pragma once
+#include "../core/book_events.hpp"
+#include "../core/book_verifier.hpp"
+#include "../core/combination_registry.hpp"
 #include "../core/l2_orderbook.hpp"
+#include "../core/l3_orderbook.hpp"
+#include "../core/order_index.hpp"
+#include "../core/orderbook_registry.hpp"
+#include "../core/own_orders.hpp"
+#include "../core/slab_pool.hpp"
+#include "../core/tick_table.hpp"
+#include "../core/trading_state.hpp"
+#include "../core/trade_tape.hpp"
 #include "../protocol/itch/itch_add_order.hpp"
+#include "../protocol/itch/itch_add_order_with_mpid.hpp"
+#include "../protocol/itch/itch_combination_orderbook_leg.hpp"
+#include "../protocol/itch/itch_equilibrium_price_update.hpp"
+#include "../protocol/itch/itch_message_view.hpp"
 #include "../protocol/itch/itch_order_delete.hpp"
 #include "../protocol/itch/itch_order_executed.hpp"
+#include "../protocol/itch/itch_order_executed_with_price.hpp"
+#include "../protocol/itch/itch_order_replace.hpp"
+#include "../protocol/itch/itch_orderbook_directory.hpp"
+#include "../protocol/itch/itch_orderbook_flush.hpp"
+#include "../protocol/itch/itch_orderbook_state.hpp"
+#include "../protocol/itch/itch_seconds.hpp"
+#include "../protocol/itch/itch_system_event.hpp"
+#include "../protocol/itch/itch_tick_size_table_entry.hpp"
+#include "../protocol/itch/itch_trade.hpp"
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
-#include <map>
-#include <tuple>
-#include <unordered_map>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace algocor::protocol::itch
 {
 
+// Resting order as the builder keeps it, in a SlabPool. Order id and side are also part of the index key; quantities on BIST fit in
+// 32 bits.
 struct ItchOrder {
-    uint64_t id;
     int32_t price;
-    uint64_t left_qty;
-    char side;
+    uint32_t left_qty;
     uint32_t orderbook_id;
+    char side;
+    uint16_t own_epoch;  // see BasicOrderbookBuilder::QueuePosition.
+};
+
+static_assert(sizeof(ItchOrder) == 16);
+
+using OrderHandle = algocor::SlabPool<ItchOrder>::Handle;
+
+// L3 books queue the builder's order records themselves and name the record type they need as Orderbook::Order.
+template<typename Orderbook>
+struct OrderRecordFor {
+    using type = ItchOrder;
+};
+
+template<typename Orderbook>
+    requires requires { typename Orderbook::Order; }
+struct OrderRecordFor<Orderbook> {
+    using type = typename Orderbook::Order;
 };
 
 // CRTP static-polymorphism builder
-template<typename Derived>
+template<typename Derived, typename Orderbook = L2Orderbook>
 class OrderbookBuilder {
 public:
-    std::unordered_map<uint32_t, L2Orderbook> m_orderbookMap;
-    std::map<std::tuple<uint32_t, uint64_t, char>, ItchOrder> m_orderMap;
+    using OrderRecord = typename OrderRecordFor<Orderbook>::type;
+    static constexpr bool IS_L3_BOOK = !std::is_same_v<OrderRecord, ItchOrder>;
+
+    // A book with the index of its live orders. Keeping the index per book lets one book be flushed in time proportional to its own
+    // orders, and an index that grows only rehashes that book's orders.
+    struct BookState {
+        Orderbook orderbook;
+        algocor::FlatOrderIndex<OrderHandle> orders;
+        uint32_t own_orders { 0 };  // own orders with a tracked queue position, see BasicOrderbookBuilder::setOwnOrders().
+    };
+
+    // Books by registry index, one registry probe per message instead of hashing the exchange id.
+    algocor::OrderbookRegistry m_registry;
+    algocor::DenseBookArray<BookState> m_books;
+    algocor::SlabPool<OrderRecord> m_orders;
+
+    // Live orders expected at the busiest point of a session, see reserveOrders().
+    static constexpr std::size_t EXPECTED_LIVE_ORDERS = 1 << 21;
+
+    // Live orders the index of a new book is sized for, see setBookOrderReserve().
+    std::size_t m_bookOrderReserve { 0 };
 
 public:
-    void addOrder(const AddOrder& order)
+    void addOrder(AddOrderView order)
     {
         static_cast<Derived*>(this)->addOrder(order);
     }
-    void executeOrder(const OrderExecuted& order)
+    void executeOrder(OrderExecutedView order)
     {
         static_cast<Derived*>(this)->executeOrder(order);
     }
-    void deleteOrder(const OrderDelete& order)
+    void deleteOrder(OrderDeleteView order)
     {
         static_cast<Derived*>(this)->deleteOrder(order);
     }
+    void replaceOrder(OrderReplaceView order)
+    {
+        static_cast<Derived*>(this)->replaceOrder(order);
+    }
+    void addOrderWithMPID(AddOrderWithMPIDView order)
+    {
+        static_cast<Derived*>(this)->addOrderWithMPID(order);
+    }
+    void executeOrderWithPrice(OrderExecutedWithPriceView order)
+    {
+        static_cast<Derived*>(this)->executeOrderWithPrice(order);
+    }
+    void trade(TradeView trade)
+    {
+        static_cast<Derived*>(this)->trade(trade);
+    }
+    void flushOrderbook(OrderbookFlushView flush)
+    {
+        static_cast<Derived*>(this)->flushOrderbook(flush);
+    }
+    void orderbookDirectory(OrderBookDirectoryView directory)
+    {
+        static_cast<Derived*>(this)->orderbookDirectory(directory);
+    }
+    void tickSizeTableEntry(TickSizeTableEntryView entry)
+    {
+        static_cast<Derived*>(this)->tickSizeTableEntry(entry);
+    }
+    void combinationOrderbookLeg(CombinationOrderbookLegView leg)
+    {
+        static_cast<Derived*>(this)->combinationOrderbookLeg(leg);
+    }
+    void orderbookState(OrderBookStateView state)
+    {
+        static_cast<Derived*>(this)->orderbookState(state);
+    }
+    void equilibriumPriceUpdate(EquilibriumPriceUpdateView update)
+    {
+        static_cast<Derived*>(this)->equilibriumPriceUpdate(update);
+    }
+    void systemEvent(SystemEventView event)
+    {
+        static_cast<Derived*>(this)->systemEvent(event);
+    }
+
+    // nullptr for a book no message has created yet.
+    BookState* findBook(uint32_t orderbook_id)
+    {
+        const auto index = m_registry.find(orderbook_id);
+        return index == algocor::OrderbookRegistry::NO_BOOK ? nullptr : &m_books[index];
+    }
+
+    const BookState* findBook(uint32_t orderbook_id) const
+    {
+        const auto index = m_registry.find(orderbook_id);
+        return index == algocor::OrderbookRegistry::NO_BOOK ? nullptr : &m_books[index];
+    }
+
+    // Registers the book the first time it is seen, nullptr when the registry is full.
+    BookState* createBook(uint32_t orderbook_id, std::string_view symbol = {})
+    {
+        const auto index = m_registry.registerBook(orderbook_id, symbol);
+        if (index == algocor::OrderbookRegistry::NO_BOOK) [[unlikely]] {
+            LOG_ERROR("No room for orderbook {}, {} books registered", orderbook_id, m_registry.size());
+            return nullptr;
+        }
+        if (index >= m_books.size()) [[unlikely]] {
+            m_books.ensure(index).orders.reserve(m_bookOrderReserve);
+        }
+        return &m_books[index];
+    }
+
+    const BookState& book(uint32_t orderbook_id) const
+    {
+        const auto* found = findBook(orderbook_id);
+        if (found == nullptr) {
+            throw std::out_of_range("no such orderbook");
+        }
+        return *found;
+    }
+
+    const algocor::OrderbookRegistry& registry() const
+    {
+        return m_registry;
+    }
 
     // Accessors for unit tests
     bool hasOrder(uint32_t orderbook_id, uint64_t order_id, char side) const
     {
-        return m_orderMap.contains({ orderbook_id, order_id, side });
+        const auto* book = findBook(orderbook_id);
+        return book != nullptr && book->orders.contains({ order_id, orderbook_id, side });
+    }
+
+    const OrderRecord& getOrder(uint32_t orderbook_id, uint64_t order_id, char side) const
+    {
+        const auto* entry = book(orderbook_id).orders.find({ order_id, orderbook_id, side });
+        if (entry == nullptr) {
+            throw std::out_of_range("no such order");
+        }
+        return m_orders.get(entry->value);
+    }
+
+    // Maps the order slabs up front, so adds do not allocate records. Book indexes are sized as their book is registered, see
+    // setBookOrderReserve().
+    void reserveOrders(std::size_t count)
+    {
+        m_orders.reserve(count);
+    }
+
+    // Sizes the order index of every book registered from now on for `count` live orders, so a book that stays within it never
+    // rehashes in the session. Set it before the first message: the directory registers the books ahead of the open. An index that
+    // outgrows it still doubles, with a warning.
+    void setBookOrderReserve(std::size_t count)
+    {
+        m_bookOrderReserve = count;
+    }
+
+    // Called by the parser ahead of a message that looks an order up, so the index slot is in cache by the time it is applied.
+    void prefetchOrder(uint32_t orderbook_id, uint64_t order_id, char side) const
+    {
+        if (const auto* book = findBook(orderbook_id)) {
+            book->orders.prefetch({ order_id, orderbook_id, side });
+        }
     }
 
-    const ItchOrder& getOrder(uint32_t orderbook_id, uint64_t order_id, char side) const
+    // Same for a book the caller has already looked up in the registry.
+    void prefetchOrder(algocor::OrderbookRegistry::Index book_index, uint32_t orderbook_id, uint64_t order_id, char side) const
     {
-        return m_orderMap.at({ orderbook_id, order_id, side });
+        m_books[book_index].orders.prefetch({ order_id, orderbook_id, side });
     }
 
-    const L2Orderbook& getOrderbook(uint32_t orderbook_id) const
+    const Orderbook& getOrderbook(uint32_t orderbook_id) const
     {
-        return m_orderbookMap.at(orderbook_id);
+        return book(orderbook_id).orderbook;
+    }
+
+    // Sum of Orderbook::MemoryUsage() over all books, see getOrderbook() for a single one.
+    std::size_t orderbookMemoryUsage() const
+    {
+        std::size_t bytes = 0;
+        for (algocor::OrderbookRegistry::Index index = 0; index < m_books.size(); ++index) {
+            bytes += m_books[index].orderbook.MemoryUsage();
+        }
+        return bytes;
     }
 };
 
-class ConcreteOrderbookBuilder : public OrderbookBuilder<ConcreteOrderbookBuilder> {
+// Orderbook is any type with the L2Orderbook interface (AddOrder / ExecuteOrder / DeleteOrder / ReplaceOrder by side, price, qty).
+template<typename Orderbook>
+class BasicOrderbookBuilder : public OrderbookBuilder<BasicOrderbookBuilder<Orderbook>, Orderbook> {
+    using Base = OrderbookBuilder<BasicOrderbookBuilder<Orderbook>, Orderbook>;
+
 public:
-    void addOrder(const AddOrder& order_add)
+    using typename Base::BookState;
+    using typename Base::OrderRecord;
+    using Index = algocor::OrderbookRegistry::Index;
+    using Base::findBook;
+    using Base::IS_L3_BOOK;
+    using Base::m_orders;
+
+    // Adds whose exchange reported rank (orderbook_position) did not match the rank in the L3 book, always 0 for L2 books.
+    uint64_t m_queueMismatches { 0 };
+
+    // Visible level changes of every book, in the order the updates arrived.
+    algocor::BookEventRing<> m_bookEvents;
+
+    algocor::BookEventRing<>& bookEvents()
     {
-        const auto order_id = be64toh(order_add.order_id);
-        const auto orderbook_id = be32toh(order_add.orderbook_id);
-        const auto price = static_cast<int32_t>(be32toh(order_add.price));
-        const auto qty = be64toh(order_add.quantity);
-        const auto side = static_cast<char>(order_add.side);
+        return m_bookEvents;
+    }
 
-        ItchOrder order { order_id, price, qty, side, orderbook_id };
-        m_orderMap[{ orderbook_id, order_id, side }] = order;
+    // Optional shadow verification, every book update is recorded for it when set.
+    algocor::BookVerifier* m_verifier { nullptr };
 
-        auto& orderbook = m_orderbookMap[orderbook_id];
-        orderbook.AddOrder(side, price, qty);
+    void setVerifier(algocor::BookVerifier* verifier)
+    {
+        m_verifier = verifier;
+    }
+
+    void recordMutation(algocor::BookMutation::Kind kind,
+        uint32_t orderbook_id,
+        const Orderbook& orderbook,
+        char side,
+        int32_t price,
+        uint64_t qty,
+        int32_t new_price = 0,
+        uint64_t new_qty = 0)
+    {
+        if (m_verifier != nullptr) [[unlikely]] {
+            if (m_verifier->outOfSync(orderbook_id)) [[unlikely]] {
+                resyncVerifier(orderbook_id, orderbook);
+                return;
+            }
+            const auto [best_price, best_qty] = orderbook.BestLevel(side);
+            m_verifier->record({ orderbook_id, price, qty, new_price, best_price, new_qty, best_qty, kind, side });
+        }
     }
 
-    void executeOrder(const OrderExecuted& order_executed)
+    // Re-seeds the verifier's reference book after it lost records of the book. The hot book already holds the update being recorded,
+    // so its levels stand for that update too. While the verifier has no room the update is dropped and the next one tries again.
+    void resyncVerifier(uint32_t orderbook_id, const Orderbook& orderbook)
     {
-        const auto order_id = be64toh(order_executed.order_id);
-        const auto orderbook_id = be32toh(order_executed.orderbook_id);
-        const auto side = static_cast<char>(order_executed.side);
-        const auto executed_qty = be64toh(order_executed.quantity);
+        const auto index = Base::registry().find(orderbook_id);
+        const auto in_auction
+            = index != algocor::OrderbookRegistry::NO_BOOK && m_tradingStates.phase(index) == algocor::TradingPhase::Auction;
+        m_verifier->resync(orderbook_id, orderbook.Bids().size() + orderbook.Asks().size(), in_auction, [&](const auto& seed) {
+            orderbook.Bids().forEach([&](int32_t price, uint64_t qty) { seed('B', price, qty); });
+            orderbook.Asks().forEach([&](int32_t price, uint64_t qty) { seed('S', price, qty); });
+        });
+    }
+
+    // MoldUDP64 sequence number of the message being applied and the last Seconds message, set by the parser.
+    uint64_t m_sequence { 0 };
+    uint64_t m_seconds { 0 };
 
-        auto it = m_orderMap.find({ orderbook_id, order_id, side });
-        if (it == m_orderMap.end())
+    void setSequence(uint64_t sequence)
+    {
+        m_sequence = sequence;
+        if (m_ownOrders != nullptr && m_ownOrders->inserted() != m_ownOrdersSeen) [[unlikely]] {
+            collectOwnOrders();
+        }
+    }
+
+    void seconds(SecondsView seconds)
+    {
+        m_seconds = seconds.second();
+    }
+
+    // Snapshot of one book for readers on other threads. Take the reference once, after the book exists: the map itself is not safe to
+    // look up concurrently.
+    const algocor::PublishedBookSnapshot<Orderbook::SNAPSHOT_DEPTH>& snapshot(uint32_t orderbook_id) const
+    {
+        return Base::book(orderbook_id).orderbook.Snapshot();
+    }
+
+    void publishVisibleChanges(uint32_t orderbook_id, Orderbook& orderbook, char side, int32_t price, uint32_t nanoseconds)
+    {
+        const auto push_event = [&](std::size_t level, int32_t level_price, uint64_t level_qty) {
+            m_bookEvents.push({ .orderbook_id = orderbook_id,
+                .price = level_price,
+                .qty = level_qty,
+                .kind = level == 0 ? algocor::BookEvent::Kind::Bbo : algocor::BookEvent::Kind::Depth,
+                .side = side,
+                .level = static_cast<uint8_t>(level) });
+        };
+
+        const auto first_changed = orderbook.PublishVisibleChanges(side, price, push_event);
+
+        if (first_changed == 0 && !m_combinations.empty()) [[unlikely]] {
+            const auto [best_price, best_qty] = orderbook.BestLevel(side);
+            m_combinations.onTopOfBook(orderbook_id, side, best_price, best_qty != 0);
+        }
+
+        if (first_changed < Orderbook::SNAPSHOT_DEPTH) {
+            orderbook.PublishSnapshot(m_sequence, timestamp(nanoseconds));
+        }
+    }
+
+    // Nanoseconds since midnight of a message.
+    uint64_t timestamp(uint32_t nanoseconds) const
+    {
+        return m_seconds * 1'000'000'000 + nanoseconds;
+    }
+
+    // Printable trades of every instrument by registry index, see algocor::TradeTape.
+    algocor::DenseBookArray<algocor::TradeTape<>> m_tradeTapes;
+
+    const algocor::TradeTape<>& tradeTape(uint32_t orderbook_id) const
+    {
+        const auto index = Base::registry().find(orderbook_id);
+        if (index == algocor::OrderbookRegistry::NO_BOOK) {
+            throw std::out_of_range("no such orderbook");
+        }
+        return m_tradeTapes[index];
+    }
+
+    // Tick size bands of every instrument by registry index, see algocor::TickTable. Identity tables for books without any.
+    algocor::DenseBookArray<algocor::TickTable> m_tickTables;
+
+    // The identity table for a book no message has created yet.
+    const algocor::TickTable& tickTable(uint32_t orderbook_id) const
+    {
+        static const algocor::TickTable identity;
+        const auto index = Base::registry().find(orderbook_id);
+        return index == algocor::OrderbookRegistry::NO_BOOK ? identity : m_tickTables[index];
+    }
+
+    // Registers the book like OrderbookBuilder::createBook() and sets up its tape and tick table with it, so a first print does not
+    // build one.
+    BookState* createBook(uint32_t orderbook_id, std::string_view symbol = {})
+    {
+        auto* book = Base::createBook(orderbook_id, symbol);
+        if (book != nullptr && m_tradeTapes.size() < Base::registry().size()) [[unlikely]] {
+            const auto last = static_cast<algocor::OrderbookRegistry::Index>(Base::registry().size() - 1);
+            m_tradeTapes.ensure(last);
+            m_tickTables.ensure(last);
+        }
+        return book;
+    }
+
+    // One band per message; where a band ends is implied by the start of the next one.
+    void tickSizeTableEntry(TickSizeTableEntryView entry)
+    {
+        const auto orderbook_id = entry.orderbookId();
+        const auto tick_size = entry.tickSize();
+        const auto price_from = entry.priceFrom();
+        if (createBook(orderbook_id) == nullptr) [[unlikely]] {
+            return;
+        }
+        if (!m_tickTables[Base::registry().find(orderbook_id)].addBand(price_from, static_cast<int64_t>(tick_size))) [[unlikely]] {
+            LOG_ERROR("Tick size band {} from {} of orderbook {} ignored", tick_size, price_from, orderbook_id);
+        }
+    }
+
+    // Combination orderbooks and their legs, with implied prices kept current from the top of the leg books, see
+    // algocor::CombinationRegistry.
+    algocor::CombinationRegistry m_combinations;
+
+    const algocor::CombinationRegistry& combinations() const
+    {
+        return m_combinations;
+    }
+
+    void combinationOrderbookLeg(CombinationOrderbookLegView leg)
+    {
+        const auto combination_id = leg.combinationOrderbookId();
+        const auto leg_orderbook_id = leg.legOrderbookId();
+        const auto ratio = leg.legRatio();
+        if (!m_combinations.addLeg(combination_id, { leg_orderbook_id, ratio, leg.legSide() == algocor::LegSide::Opposite })) [[unlikely]] {
+            LOG_ERROR("Leg {} of combination orderbook {} with ratio {} ignored", leg_orderbook_id, combination_id, ratio);
             return;
+        }
+
+        // Legs are normally announced before any order, but a book may already be built after a snapshot or a late join.
+        for (const auto orderbook_id : { combination_id, leg_orderbook_id }) {
+            if (const auto* book = findBook(orderbook_id)) {
+                for (const auto side : { 'B', 'S' }) {
+                    const auto [best_price, best_qty] = book->orderbook.BestLevel(side);
+                    m_combinations.onTopOfBook(orderbook_id, side, best_price, best_qty != 0);
+                }
+            }
+        }
+    }
 
-        auto& orderbook = m_orderbookMap[orderbook_id];
-        orderbook.ExecuteOrder(side, it->second.price, executed_qty);
+    // Trading phase and auction state of every book, see algocor::TradingStateTable.
+    algocor::TradingStateTable m_tradingStates;
 
-        it->second.left_qty -= executed_qty;
-        if (it->second.left_qty == 0)
-            m_orderMap.erase(it);
+    const algocor::TradingStateTable& tradingStates() const
+    {
+        return m_tradingStates;
     }
 
-    void deleteOrder(const OrderDelete& order_delete)
+    // Unknown for a book no message has created yet.
+    algocor::TradingPhase tradingPhase(uint32_t orderbook_id) const
     {
-        const auto order_id = be64toh(order_delete.order_id);
-        const auto orderbook_id = be32toh(order_delete.orderbook_id);
-        const auto side = static_cast<char>(order_delete.side);
+        const auto index = Base::registry().find(orderbook_id);
+        return index == algocor::OrderbookRegistry::NO_BOOK ? algocor::TradingPhase::Unknown : m_tradingStates.phase(index);
+    }
 
-        auto it = m_orderMap.find({ orderbook_id, order_id, side });
-        if (it == m_orderMap.end())
+    void orderbookState(OrderBookStateView state)
+    {
+        const auto orderbook_id = state.orderbookId();
+        auto* book = createBook(orderbook_id);
+        if (book == nullptr) [[unlikely]] {
             return;
+        }
 
-        auto& orderbook = m_orderbookMap[orderbook_id];
-        orderbook.DeleteOrder(side, it->second.price, it->second.left_qty);
+        const auto name = algocor::trimSymbol(state.stateName());
+        const auto phase = algocor::tradingPhaseOf(name);
+        if (phase == algocor::TradingPhase::Unknown) [[unlikely]] {
+            LOG_WARNING("Unknown state {} of orderbook {}", name, orderbook_id);
+        }
 
-        m_orderMap.erase(it);
+        const auto previous = m_tradingStates.setPhase(Base::registry().find(orderbook_id), phase);
+        // The shadow books accept a crossed book only while it is in an auction.
+        const auto in_auction = phase == algocor::TradingPhase::Auction;
+        if ((previous == algocor::TradingPhase::Auction) != in_auction) {
+            recordMutation(algocor::BookMutation::Kind::Auction, orderbook_id, book->orderbook, 'B', 0, in_auction ? 1 : 0);
+        }
+    }
+
+    void equilibriumPriceUpdate(EquilibriumPriceUpdateView update)
+    {
+        const auto orderbook_id = update.orderbookId();
+        if (createBook(orderbook_id) == nullptr) [[unlikely]] {
+            return;
+        }
+
+        m_tradingStates.setAuction(Base::registry().find(orderbook_id),
+            { .timestamp = timestamp(update.nanoseconds()),
+                .equilibrium_price = update.equilibriumPrice(),
+                .best_bid_price = update.bestBidPrice(),
+                .best_ask_price = update.bestAskPrice(),
+                .reserved = 0,
+                .bid_qty_at_equilibrium = update.availableBidQuantity(),
+                .ask_qty_at_equilibrium = update.availableAskQuantity(),
+                .best_bid_qty = update.bestBidQuantity(),
+                .best_ask_qty = update.bestAskQuantity() });
+    }
+
+    void systemEvent(SystemEventView event)
+    {
+        if (event.eventCode() == algocor::EventCode::EndOfMessages) {
+            m_tradingStates.closeAll(Base::registry().size());
+        }
+    }
+
+    // Queue position of one of our resting orders. An order that joins a level where own orders rest carries the epoch of the last own
+    // order that joined before it, so a delete knows which own orders it was ahead of; executions always take the front of the queue.
+    // With several own orders at one price, an order that queued behind an own order that has since left counts as ahead of the rest.
+    // Epochs are unique among tracked own orders, see nextOwnEpoch().
+    struct QueuePosition {
+        algocor::OwnOrderMap::Entry* entry;
+        uint64_t ahead;
+        uint32_t orderbook_id;
+        int32_t price;
+        char side;
+        uint16_t epoch;
+    };
+
+    algocor::OwnOrderMap* m_ownOrders { nullptr };
+    uint32_t m_ownOrdersSeen { 0 };
+    std::vector<algocor::OwnOrderMap::Entry*> m_pendingOwnOrders;  // accepted, their add not applied yet.
+    std::vector<QueuePosition> m_queuePositions;                   // in the order they joined their levels.
+    uint16_t m_ownEpoch { 0 };
+
+    // Orders in the map are matched against the adds and their queue ahead is kept up to date in it, see OwnOrderMap::queueAhead().
+    void setOwnOrders(algocor::OwnOrderMap* own_orders)
+    {
+        m_ownOrders = own_orders;
+        m_ownOrdersSeen = 0;
+    }
+
+    // Orders inserted into the map since the last call. One whose add was applied already was accepted late and is placed behind
+    // everything at its price; the others are placed when their add arrives.
+    void collectOwnOrders()
+    {
+        for (const auto inserted = m_ownOrders->inserted(); m_ownOrdersSeen < inserted; ++m_ownOrdersSeen) {
+            auto& own_order = m_ownOrders->entry(m_ownOrdersSeen);
+            if (!own_order.live()) {
+                continue;
+            }
+            auto* book = findBook(own_order.orderbook_id);
+            const algocor::OrderKey key { own_order.order_id, own_order.orderbook_id, own_order.side };
+            const auto* entry = book == nullptr ? nullptr : book->orders.find(key);
+            if (entry == nullptr) {
+                m_pendingOwnOrders.push_back(&own_order);
+                continue;
+            }
+            const auto& order = m_orders.get(entry->value);
+            trackOwnOrder(*book, own_order, order.price, book->orderbook.LevelQty(order.side, order.price) - order.left_qty);
+        }
+    }
+
+    void trackOwnOrder(BookState& book, algocor::OwnOrderMap::Entry& own_order, int32_t price, uint64_t ahead)
+    {
+        m_queuePositions.push_back({ &own_order, ahead, own_order.orderbook_id, price, own_order.side, nextOwnEpoch() });
+        ++book.own_orders;
+        own_order.queue_ahead.store(ahead, std::memory_order_relaxed);
+    }
+
+    // Epochs wrap, so one still held by a tracked own order is skipped: two own orders at a level with the same epoch would stop the
+    // walk of onOwnLevelReduce() at the wrong one. 0 is left for orders that joined with no own order at their level.
+    uint16_t nextOwnEpoch()
+    {
+        const auto held = [this](uint16_t epoch) {
+            return std::any_of(
+                m_queuePositions.begin(), m_queuePositions.end(), [&](const auto& position) { return position.epoch == epoch; });
+        };
+        do {
+            m_ownEpoch = m_ownEpoch == UINT16_MAX ? 1 : static_cast<uint16_t>(m_ownEpoch + 1);
+        } while (held(m_ownEpoch));
+        return m_ownEpoch;
+    }
+
+    void untrackOwnOrder(BookState& book, std::size_t index)
+    {
+        m_queuePositions[index].entry->queue_ahead.store(algocor::OwnOrderMap::UNKNOWN, std::memory_order_relaxed);
+        m_queuePositions.erase(m_queuePositions.begin() + static_cast<std::ptrdiff_t>(index));
+        --book.own_orders;
+    }
+
+    static void setQueueAhead(QueuePosition& position, uint64_t ahead)
+    {
+        position.ahead = ahead;
+        position.entry->queue_ahead.store(ahead, std::memory_order_relaxed);
+    }
+
+    static bool atLevel(const QueuePosition& position, uint32_t orderbook_id, char side, int32_t price)
+    {
+        return position.orderbook_id == orderbook_id && position.side == side && position.price == price;
+    }
+
+    // Epoch for an order joining the back of a level, 0 when no own order rests there.
+    uint16_t lastOwnEpoch(uint32_t orderbook_id, char side, int32_t price) const
+    {
+        for (auto position = m_queuePositions.rbegin(); position != m_queuePositions.rend(); ++position) {
+            if (atLevel(*position, orderbook_id, side, price)) {
+                return position->epoch;
+            }
+        }
+        return 0;
+    }
+
+    // Called for every add while own orders wait for theirs.
+    void placeOwnOrder(BookState& book, uint64_t order_id, uint32_t orderbook_id, char side, int32_t price, uint64_t qty)
+    {
+        for (auto index = m_pendingOwnOrders.size(); index-- > 0;) {
+            auto* own_order = m_pendingOwnOrders[index];
+            const auto live = own_order->live();
+            const auto match
+                = live && own_order->order_id == order_id && own_order->orderbook_id == orderbook_id && own_order->side == side;
+            if (!live || match) {
+                m_pendingOwnOrders.erase(m_pendingOwnOrders.begin() + static_cast<std::ptrdiff_t>(index));
+            }
+            if (match) {
+                trackOwnOrder(book, *own_order, price, book.orderbook.LevelQty(side, price) - qty);
+            }
+        }
+    }
+
+    // An execution at a price with own orders: it took the front of the queue, so every other own order there moves up by `qty`.
+    void onOwnLevelExecution(BookState& book, uint64_t order_id, uint32_t orderbook_id, char side, int32_t price, uint64_t qty, bool filled)
+    {
+        for (auto index = m_queuePositions.size(); index-- > 0;) {
+            auto& position = m_queuePositions[index];
+            if (!atLevel(position, orderbook_id, side, price)) {
+                continue;
+            }
+            if (position.entry->order_id != order_id) {
+                setQueueAhead(position, position.ahead - std::min(position.ahead, qty));
+            } else if (filled) {
+                untrackOwnOrder(book, index);
+            } else {
+                setQueueAhead(position, 0);
+            }
+        }
+    }
+
+    // An order at a price with own orders lost `qty`, by leaving the level (`gone`) or shrinking in place. Walking from the latest own
+    // order back, the order was ahead of each one until the one whose epoch it carries. Returns the own order that left, if it was one.
+    algocor::OwnOrderMap::Entry* onOwnLevelReduce(
+        BookState& book, uint64_t order_id, uint32_t orderbook_id, char side, int32_t price, uint64_t qty, uint16_t epoch, bool gone)
+    {
+        algocor::OwnOrderMap::Entry* left = nullptr;
+        auto behind = false;
+        for (auto index = m_queuePositions.size(); index-- > 0;) {
+            auto& position = m_queuePositions[index];
+            if (!atLevel(position, orderbook_id, side, price)) {
+                continue;
+            }
+            if (position.entry->order_id == order_id) {
+                if (gone) {
+                    left = position.entry;
+                    untrackOwnOrder(book, index);
+                }
+                continue;
+            }
+            behind = behind || position.epoch == epoch;
+            if (!behind) {
+                setQueueAhead(position, position.ahead - std::min(position.ahead, qty));
+            }
+        }
+        return left;
+    }
+
+    void addOrder(AddOrderView order_add)
+    {
+        addOrder(order_add, Base::registry().find(order_add.orderbookId()));
+    }
+
+    // The handlers taking a `book_index` are for callers that resolved the registry index of the message's book ahead, like the batch
+    // decode of ItchParser. For an add it may be NO_BOOK, the book is created then; the others need a book the registry holds.
+    void addOrder(AddOrderView order_add, Index book_index)
+    {
+        const auto order_id = order_add.orderId();
+        const auto orderbook_id = order_add.orderbookId();
+        const auto price = order_add.price();
+        const auto qty = order_add.quantity();
+        const auto side = order_add.side();
+
+        // Records keep 32 bits of quantity; a larger one would leave the level with more than its orders could ever remove.
+        if (qty > UINT32_MAX) [[unlikely]] {
+            LOG_ERROR("Quantity {} of order id {} on orderbook {} does not fit an order record, add ignored", qty, order_id, orderbook_id);
+            return;
+        }
+        auto* book = book_index != algocor::OrderbookRegistry::NO_BOOK ? &Base::m_books[book_index] : createBook(orderbook_id);
+        if (book == nullptr) [[unlikely]]
+            return;
+        auto& [orderbook, orders, own_orders] = *book;
+        if (orders.full() && Base::m_bookOrderReserve != 0) [[unlikely]] {
+            LOG_WARNING(
+                "Order index of orderbook {} grows past {} orders in the session, raise book_order_reserve", orderbook_id, orders.size());
+        }
+        const auto [entry, inserted] = orders.tryEmplace({ order_id, orderbook_id, side }, algocor::SlabPool<ItchOrder>::NULL_HANDLE);
+        if (!inserted) [[unlikely]] {
+            LOG_ERROR("Duplicate order id {} on orderbook {} side {}, add ignored", order_id, orderbook_id, side);
+            return;
+        }
+
+        entry->value = m_orders.allocate();
+        auto& order = m_orders.get(entry->value);
+        order.price = price;
+        order.left_qty = static_cast<uint32_t>(qty);
+        order.orderbook_id = orderbook_id;
+        order.side = side;
+        order.own_epoch = own_orders != 0 ? lastOwnEpoch(orderbook_id, side, price) : 0;
+
+        if constexpr (IS_L3_BOOK) {
+            const auto rank = order_add.orderbookPosition();
+            if (orderbook.AddOrder(m_orders, entry->value, rank) != rank && rank != 0) [[unlikely]] {
+                ++m_queueMismatches;
+            }
+        } else {
+            orderbook.AddOrder(side, price, qty);
+        }
+        if (!m_pendingOwnOrders.empty()) [[unlikely]] {
+            placeOwnOrder(*book, order_id, orderbook_id, side, price, qty);
+        }
+        publishVisibleChanges(orderbook_id, orderbook, side, price, order_add.nanoseconds());
+        recordMutation(algocor::BookMutation::Kind::Add, orderbook_id, orderbook, side, price, qty);
+    }
+
+    // The MPID variant is an AddOrder with the participant id appended, the book does not need it.
+    void addOrderWithMPID(AddOrderWithMPIDView order_add)
+    {
+        addOrder(order_add);
+    }
+
+    void addOrderWithMPID(AddOrderWithMPIDView order_add, Index book_index)
+    {
+        addOrder(order_add, book_index);
+    }
+
+    void executeOrder(OrderExecutedView order_executed)
+    {
+        if (const auto index = Base::registry().find(order_executed.orderbookId()); index != algocor::OrderbookRegistry::NO_BOOK) {
+            applyExecution(order_executed, index);
+        }
+    }
+
+    void executeOrder(OrderExecutedView order_executed, Index book_index)
+    {
+        applyExecution(order_executed, book_index);
+    }
+
+    void executeOrderWithPrice(OrderExecutedWithPriceView order_executed)
+    {
+        if (const auto index = Base::registry().find(order_executed.orderbookId()); index != algocor::OrderbookRegistry::NO_BOOK) {
+            applyExecution(order_executed, index);
+        }
+    }
+
+    void executeOrderWithPrice(OrderExecutedWithPriceView order_executed, Index book_index)
+    {
+        applyExecution(order_executed, book_index);
+    }
+
+    // A trade that did not execute a visible order, it only goes on the tape.
+    void trade(TradeView trade)
+    {
+        const auto orderbook_id = trade.orderbookId();
+        if (trade.printable() && createBook(orderbook_id) != nullptr) {
+            m_tradeTapes[Base::registry().find(orderbook_id)].record(
+                { timestamp(trade.nanoseconds()), trade.matchId(), trade.quantity(), trade.tradePrice(), trade.side() });
+        }
+    }
+
+    // 'E' and 'C' share their leading fields, 'C' adds the trade price and whether the trade is printable.
+    template<typename Execution>
+    void applyExecution(Execution order_executed, Index index)
+    {
+        const auto order_id = order_executed.orderId();
+        const auto orderbook_id = order_executed.orderbookId();
+        const auto side = order_executed.side();
+        auto executed_qty = order_executed.quantity();
+        const auto nanoseconds = order_executed.nanoseconds();
+
+        auto* book = &Base::m_books[index];
+        auto& [orderbook, orders, own_orders] = *book;
+        auto* entry = orders.find({ order_id, orderbook_id, side });
+        if (entry == nullptr)
+            return;
+
+        auto& order = m_orders.get(entry->value);
+        // More than is left would wrap the record and keep it in the index after its level is gone: the order is taken as filled.
+        if (executed_qty > order.left_qty) [[unlikely]] {
+            LOG_ERROR("Execution of {} on order id {} on orderbook {} with {} left, order taken as filled",
+                executed_qty,
+                order_id,
+                orderbook_id,
+                order.left_qty);
+            executed_qty = order.left_qty;
+        }
+        if constexpr (IS_L3_BOOK) {
+            orderbook.ExecuteOrder(m_orders, entry->value, executed_qty);
+        } else {
+            orderbook.ExecuteOrder(side, order.price, executed_qty);
+            order.left_qty -= static_cast<uint32_t>(executed_qty);
+        }
+        if (own_orders != 0) [[unlikely]] {
+            onOwnLevelExecution(*book, order_id, orderbook_id, side, order.price, executed_qty, order.left_qty == 0);
+        }
+        publishVisibleChanges(orderbook_id, orderbook, side, order.price, nanoseconds);
+        recordMutation(algocor::BookMutation::Kind::Execute, orderbook_id, orderbook, side, order.price, executed_qty);
+
+        algocor::TradePrint print { timestamp(nanoseconds), order_executed.matchId(), executed_qty, order.price, side };
+        if constexpr (std::is_same_v<Execution, OrderExecutedWithPriceView>) {
+            print.price = order_executed.tradePrice();
+            if (order_executed.printable()) {
+                m_tradeTapes[index].record(print);
+            }
+        } else {
+            m_tradeTapes[index].record(print);
+        }
+
+        if (order.left_qty == 0) {
+            m_orders.release(entry->value);
+            orders.erase(entry);
+        }
+    }
+
+    void deleteOrder(OrderDeleteView order_delete)
+    {
+        if (const auto index = Base::registry().find(order_delete.orderbookId()); index != algocor::OrderbookRegistry::NO_BOOK) {
+            deleteOrder(order_delete, index);
+        }
+    }
+
+    void deleteOrder(OrderDeleteView order_delete, Index book_index)
+    {
+        const auto order_id = order_delete.orderId();
+        const auto orderbook_id = order_delete.orderbookId();
+        const auto side = order_delete.side();
+
+        auto* book = &Base::m_books[book_index];
+        auto& [orderbook, orders, own_orders] = *book;
+        auto* entry = orders.find({ order_id, orderbook_id, side });
+        if (entry == nullptr)
+            return;
+
+        const auto& order = m_orders.get(entry->value);
+        if constexpr (IS_L3_BOOK) {
+            orderbook.DeleteOrder(m_orders, entry->value);
+        } else {
+            orderbook.DeleteOrder(side, order.price, order.left_qty);
+        }
+        if (own_orders != 0) [[unlikely]] {
+            onOwnLevelReduce(*book, order_id, orderbook_id, side, order.price, order.left_qty, order.own_epoch, true);
+        }
+        publishVisibleChanges(orderbook_id, orderbook, side, order.price, order_delete.nanoseconds());
+        recordMutation(algocor::BookMutation::Kind::Delete, orderbook_id, orderbook, side, order.price, order.left_qty);
+
+        m_orders.release(entry->value);
+        orders.erase(entry);
+    }
+
+    // The order keeps its id, index entry and record; price and quantity change in place with one combined level update.
+    void replaceOrder(OrderReplaceView order_replace)
+    {
+        if (const auto index = Base::registry().find(order_replace.orderbookId()); index != algocor::OrderbookRegistry::NO_BOOK) {
+            replaceOrder(order_replace, index);
+        }
+    }
+
+    void replaceOrder(OrderReplaceView order_replace, Index book_index)
+    {
+        const auto order_id = order_replace.orderId();
+        const auto orderbook_id = order_replace.orderbookId();
+        const auto side = order_replace.side();
+        const auto new_price = order_replace.price();
+        const auto new_qty = order_replace.quantity();
+
+        if (new_qty > UINT32_MAX) [[unlikely]] {
+            LOG_ERROR("Quantity {} of order id {} on orderbook {} does not fit an order record, replace ignored",
+                new_qty,
+                order_id,
+                orderbook_id);
+            return;
+        }
+        auto* book = &Base::m_books[book_index];
+        auto& [orderbook, orders, own_orders] = *book;
+        auto* entry = orders.find({ order_id, orderbook_id, side });
+        if (entry == nullptr)
+            return;
+
+        auto& order = m_orders.get(entry->value);
+        const auto old_price = order.price;
+        const uint64_t old_qty = order.left_qty;
+
+        if constexpr (IS_L3_BOOK) {
+            const auto rank = order_replace.orderbookPosition();
+            const auto placed = orderbook.ReplaceOrder(m_orders, entry->value, new_price, static_cast<uint32_t>(new_qty), rank);
+            if (placed != 0 && placed != rank && rank != 0) [[unlikely]] {
+                ++m_queueMismatches;
+            }
+        } else {
+            orderbook.ReplaceOrder(side, old_price, old_qty, new_price, new_qty);
+            order.price = new_price;
+            order.left_qty = static_cast<uint32_t>(new_qty);
+        }
+        if (own_orders != 0) [[unlikely]] {
+            replaceAtOwnLevel(*book, order_id, order, old_price, old_qty);
+        }
+
+        // The better of the two prices decides whether a visible level can have changed.
+        const auto touched_price = side == 'B' ? std::max(old_price, new_price) : std::min(old_price, new_price);
+        publishVisibleChanges(orderbook_id, orderbook, side, touched_price, order_replace.nanoseconds());
+        recordMutation(algocor::BookMutation::Kind::Replace, orderbook_id, orderbook, side, old_price, old_qty, new_price, new_qty);
+    }
+
+    // A smaller quantity at the same price keeps the order's place, anything else sends it to the back of its new level.
+    void replaceAtOwnLevel(BookState& book, uint64_t order_id, OrderRecord& order, int32_t old_price, uint64_t old_qty)
+    {
+        if (order.price == old_price && order.left_qty <= old_qty) {
+            onOwnLevelReduce(book, order_id, order.orderbook_id, order.side, old_price, old_qty - order.left_qty, order.own_epoch, false);
+            return;
+        }
+
+        auto* own_order = onOwnLevelReduce(book, order_id, order.orderbook_id, order.side, old_price, old_qty, order.own_epoch, true);
+        order.own_epoch = book.own_orders != 0 ? lastOwnEpoch(order.orderbook_id, order.side, order.price) : 0;
+        if (own_order != nullptr) {
+            trackOwnOrder(book, *own_order, order.price, book.orderbook.LevelQty(order.side, order.price) - order.left_qty);
+        }
+    }
+
+    // Names the book and gives it its slot ahead of its first order.
+    void orderbookDirectory(OrderBookDirectoryView directory)
+    {
+        createBook(directory.orderbookId(), directory.symbol());
+    }
+
+    // Removes every order of one book. Walks that book's index only, orders of other books on the thread are not touched. The orders
+    // leave the book one by one like deletes, so features and the verifier stay in step without a separate reset path.
+    void flushOrderbook(OrderbookFlushView flush)
+    {
+        const auto orderbook_id = flush.orderbookId();
+
+        auto* book = findBook(orderbook_id);
+        if (book == nullptr)
+            return;
+        auto& [orderbook, orders, own_orders] = *book;
+
+        orders.forEach([&](const auto& entry) {
+            const auto& order = m_orders.get(entry.value);
+            if constexpr (IS_L3_BOOK) {
+                orderbook.DeleteOrder(m_orders, entry.value);
+            } else {
+                orderbook.DeleteOrder(order.side, order.price, order.left_qty);
+            }
+            recordMutation(algocor::BookMutation::Kind::Delete, orderbook_id, orderbook, order.side, order.price, order.left_qty);
+            m_orders.release(entry.value);
+        });
+        orders.clear();
+        for (auto index = m_queuePositions.size(); own_orders != 0 && index-- > 0;) {
+            if (m_queuePositions[index].orderbook_id == orderbook_id) {
+                untrackOwnOrder(*book, index);
+            }
+        }
+
+        // A price better than any level makes both sides republish in full.
+        const auto nanoseconds = flush.nanoseconds();
+        publishVisibleChanges(orderbook_id, orderbook, 'B', Orderbook::NO_ASK, nanoseconds);
+        publishVisibleChanges(orderbook_id, orderbook, 'S', Orderbook::NO_BID, nanoseconds);
     }
 };
 
+// Level storage picked at compile time, e.g. L2OrderbookBuilder<algocor::BPlusTreePolicy> for deep VIOP books.
+template<typename LevelPolicy, unsigned Features = algocor::NO_BOOK_FEATURES>
+using L2OrderbookBuilder = BasicOrderbookBuilder<BasicL2Orderbook<LevelPolicy, Features>>;
+
+using ConcreteOrderbookBuilder = L2OrderbookBuilder<algocor::SortedVectorPolicy>;
+using TickLadderOrderbookBuilder = L2OrderbookBuilder<algocor::TickLadderPolicy>;
+
+// Same stream, order by order books with queue positions.
+template<typename LevelPolicy, unsigned Features = algocor::NO_BOOK_FEATURES>
+using L3OrderbookBuilder = BasicOrderbookBuilder<BasicL3Orderbook<LevelPolicy, Features>>;
+
+using ConcreteL3OrderbookBuilder = L3OrderbookBuilder<algocor::SortedVectorPolicy>;
+
 }  // namespace algocor::protocol::itch
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace algocor
+{
+
+// OrderBookDirectory symbols are padded to their field width.
+inline std::string_view trimSymbol(std::string_view symbol)
+{
+    return symbol.substr(0, symbol.find_last_not_of(std::string_view { " \0", 2 }) + 1);
+}
+
+// Orderbooks of one partition, each given a dense index when it is announced by an OrderBookDirectory ('R') message, or when an
+// order for it shows up first. The index addresses the books in a DenseBookArray, so the per message lookup is a probe of one small
+// open addressing table instead of a hash map walk.
+class OrderbookRegistry {
+public:
+    using Index = uint32_t;
+    static constexpr Index NO_BOOK = UINT32_MAX;
+
+    // Books a partition can hold, BIST partitions carry a few thousand including the VIOP series.
+    static constexpr std::size_t MAX_ORDERBOOKS = 1 << 14;
+
+private:
+    struct Slot {
+        uint32_t orderbook_id;
+        Index index;  // NO_BOOK when the slot is empty.
+    };
+
+    // Kept at most half full, an id is nearly always found in the slot it hashes to.
+    static constexpr std::size_t TABLE_SIZE = MAX_ORDERBOOKS * 2;
+    static constexpr unsigned TABLE_SHIFT = 32 - std::countr_zero(TABLE_SIZE);
+
+    std::vector<Slot> m_slots;
+    std::vector<uint32_t> m_orderbookIds;
+    std::vector<std::string> m_symbols;
+    std::unordered_map<std::string, Index> m_bySymbol;
+
+    static std::size_t slotOf(uint32_t orderbook_id)
+    {
+        // Fibonacci hashing, sparse exchange ids spread over the table.
+        return (orderbook_id * 0x9E3779B9U) >> TABLE_SHIFT;
+    }
+
+public:
+    OrderbookRegistry()
+        : m_slots(TABLE_SIZE, Slot { 0, NO_BOOK })
+    {
+    }
+
+    [[nodiscard]] Index find(uint32_t orderbook_id) const
+    {
+        for (auto slot = slotOf(orderbook_id);; slot = (slot + 1) & (TABLE_SIZE - 1)) {
+            const auto& entry = m_slots[slot];
+            if (entry.index == NO_BOOK || entry.orderbook_id == orderbook_id) [[likely]] {
+                return entry.index;
+            }
+        }
+    }
+
+    // Index of the book, assigning the next one to an id seen for the first time. NO_BOOK once MAX_ORDERBOOKS are registered. A
+    // non-empty `symbol` names the book, or renames it when it was registered without one.
+    Index registerBook(uint32_t orderbook_id, std::string_view symbol = {})
+    {
+        auto slot = slotOf(orderbook_id);
+        while (m_slots[slot].index != NO_BOOK && m_slots[slot].orderbook_id != orderbook_id) {
+            slot = (slot + 1) & (TABLE_SIZE - 1);
+        }
+
+        auto index = m_slots[slot].index;
+        if (index == NO_BOOK) {
+            if (m_orderbookIds.size() == MAX_ORDERBOOKS) [[unlikely]] {
+                return NO_BOOK;
+            }
+            index = static_cast<Index>(m_orderbookIds.size());
+            m_slots[slot] = { orderbook_id, index };
+            m_orderbookIds.push_back(orderbook_id);
+            m_symbols.emplace_back();
+        }
+
+        symbol = trimSymbol(symbol);
+        if (!symbol.empty() && m_symbols[index] != symbol) {
+            m_bySymbol.erase(m_symbols[index]);
+            m_symbols[index] = symbol;
+            m_bySymbol[m_symbols[index]] = index;
+        }
+        return index;
+    }
+
+    // NO_BOOK for a symbol no directory message announced.
+    [[nodiscard]] Index findSymbol(std::string_view symbol) const
+    {
+        const auto it = m_bySymbol.find(std::string(symbol));
+        return it == m_bySymbol.end() ? NO_BOOK : it->second;
+    }
+
+    [[nodiscard]] uint32_t orderbookId(Index index) const
+    {
+        return m_orderbookIds[index];
+    }
+
+    // Empty for books that were not announced.
+    [[nodiscard]] const std::string& symbol(Index index) const
+    {
+        return m_symbols[index];
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_orderbookIds.size();
+    }
+};
+
+// Books of a partition by registry index, side by side in one allocation of OrderbookRegistry::MAX_ORDERBOOKS slots. Books are
+// constructed in place as they are registered and never move, which suits books that own atomics or are pinned by readers; pages of
+// slots that are never used are never touched.
+template<typename Book>
+class DenseBookArray {
+    static constexpr std::size_t CAPACITY = OrderbookRegistry::MAX_ORDERBOOKS;
+
+    Book* m_books;
+    std::size_t m_size { 0 };
+
+public:
+    DenseBookArray()
+        : m_books(static_cast<Book*>(::operator new(CAPACITY * sizeof(Book), std::align_val_t { alignof(Book) })))
+    {
+    }
+
+    DenseBookArray(const DenseBookArray&) = delete;
+    DenseBookArray& operator=(const DenseBookArray&) = delete;
+
+    ~DenseBookArray()
+    {
+        for (std::size_t index = 0; index < m_size; ++index) {
+            m_books[index].~Book();
+        }
+        ::operator delete(m_books, std::align_val_t { alignof(Book) });
+    }
+
+    // Constructs the books up to `index`, indexes are handed out in order so this is at most the one new book.
+    Book& ensure(OrderbookRegistry::Index index)
+    {
+        while (m_size <= index) {
+            new (&m_books[m_size]) Book {};
+            ++m_size;
+        }
+        return m_books[index];
+    }
+
+    Book& operator[](OrderbookRegistry::Index index)
+    {
+        return m_books[index];
+    }
+
+    const Book& operator[](OrderbookRegistry::Index index) const
+    {
+        return m_books[index];
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_size;
+    }
+};
+
+}  // namespace algocor
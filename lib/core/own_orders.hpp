@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace algocor
+{
+
+// Our resting orders by exchange order id, shared by the order entry session and the book builders. The order manager inserts an order
+// when OUCH accepts it and erases it once it is filled or gone; builders match the ids against ITCH adds and publish how much
+// quantity is queued ahead of each order at its price, which strategies read with queueAhead() from any thread.
+//
+// Single writer (the order entry thread), any number of readers, no locks. Erased slots are not reused, so at most CAPACITY orders can
+// be inserted over the life of the map; the order manager hands out fewer tokens than that per session.
+//
+// Exchange order id 0 is not used and is never inserted.
+class OwnOrderMap {
+public:
+    static constexpr std::size_t CAPACITY = 4096;
+    static constexpr uint64_t UNKNOWN = UINT64_MAX;  // queueAhead() of an order no builder has placed yet.
+
+    struct Entry {
+        std::atomic<uint64_t> key { EMPTY };             // order_id while the order is in the map.
+        std::atomic<uint64_t> queue_ahead { UNKNOWN };  // written by the builder of the order's book.
+        uint64_t order_id { 0 };
+        uint32_t token { 0 };
+        uint32_t orderbook_id { 0 };
+        char side { 0 };
+
+        [[nodiscard]] bool live() const
+        {
+            return key.load(std::memory_order_acquire) == order_id;
+        }
+    };
+
+private:
+    static constexpr std::size_t TABLE_SIZE = CAPACITY * 2;
+    static constexpr uint64_t EMPTY = 0;
+    static constexpr uint64_t REMOVED = UINT64_MAX;  // keeps probe chains through an erased order intact.
+
+    std::unique_ptr<Entry[]> m_table { new Entry[TABLE_SIZE] };
+    // Slots in insertion order, so builders can pick up orders they have not seen yet without scanning the table.
+    std::unique_ptr<std::atomic<uint32_t>[]> m_log { new std::atomic<uint32_t>[CAPACITY] {} };
+    std::atomic<uint32_t> m_inserted { 0 };
+
+    static std::size_t slotOf(uint64_t order_id)
+    {
+        return (order_id * 0x9E3779B97F4A7C15ULL) >> 51;  // top 13 bits, TABLE_SIZE == 1 << 13.
+    }
+
+    static_assert(TABLE_SIZE == 1 << 13);
+
+    std::size_t probe(uint64_t order_id) const
+    {
+        for (auto slot = slotOf(order_id);; slot = (slot + 1) & (TABLE_SIZE - 1)) {
+            const auto id = m_table[slot].key.load(std::memory_order_acquire);
+            if (id == order_id || id == EMPTY) {
+                return slot;
+            }
+        }
+    }
+
+public:
+    // Writer side. False when the id is 0, already present or the map is full.
+    bool insert(uint64_t order_id, uint32_t token, uint32_t orderbook_id, char side)
+    {
+        if (order_id == EMPTY || order_id == REMOVED) {
+            return false;
+        }
+        const auto inserted = m_inserted.load(std::memory_order_relaxed);
+        const auto slot = probe(order_id);
+        if (inserted == CAPACITY || m_table[slot].key.load(std::memory_order_relaxed) == order_id) [[unlikely]] {
+            return false;
+        }
+
+        auto& entry = m_table[slot];
+        entry.order_id = order_id;
+        entry.token = token;
+        entry.orderbook_id = orderbook_id;
+        entry.side = side;
+        entry.queue_ahead.store(UNKNOWN, std::memory_order_relaxed);
+        entry.key.store(order_id, std::memory_order_release);
+
+        m_log[inserted].store(static_cast<uint32_t>(slot), std::memory_order_relaxed);
+        m_inserted.store(inserted + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Writer side.
+    void erase(uint64_t order_id)
+    {
+        if (order_id == EMPTY || order_id == REMOVED) {
+            return;
+        }
+        const auto slot = probe(order_id);
+        if (m_table[slot].key.load(std::memory_order_relaxed) == order_id) {
+            m_table[slot].key.store(REMOVED, std::memory_order_release);
+        }
+    }
+
+    // Quantity queued ahead of the order at its price, UNKNOWN until its builder has placed it (or when it is not ours).
+    [[nodiscard]] uint64_t queueAhead(uint64_t order_id) const
+    {
+        if (order_id == EMPTY || order_id == REMOVED) {
+            return UNKNOWN;
+        }
+        const auto& entry = m_table[probe(order_id)];
+        return entry.key.load(std::memory_order_acquire) == order_id ? entry.queue_ahead.load(std::memory_order_relaxed) : UNKNOWN;
+    }
+
+    // Orders inserted so far; entry(i) for i below it is the i-th one, possibly erased since.
+    [[nodiscard]] uint32_t inserted() const
+    {
+        return m_inserted.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] Entry& entry(uint32_t insertion)
+    {
+        return m_table[m_log[insertion].load(std::memory_order_relaxed)];
+    }
+};
+
+}  // namespace algocor
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <sys/mman.h>
+#include <type_traits>
+
+#include "../utility/overwrite_macros.hpp"
+#include "../utility/quill_wrapper.hpp"
+
+namespace algocor
+{
+
+// Fixed size records addressed by 32-bit handles. Records live in 2 MB slabs, backed by huge pages when the system has them reserved
+// (MAP_HUGETLB) and by transparent huge pages otherwise, so a few million orders cost a handful of TLB entries. A handle stays valid
+// until the record is released, slabs are never moved or returned. Released records go on an intrusive LIFO free list: the next
+// allocation reuses the record that was touched last and is most likely still in cache.
+//
+// Not thread safe, owned by the thread that applies the feed.
+template<typename T>
+class SlabPool {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>);
+    static_assert(sizeof(T) >= sizeof(uint32_t) && std::has_single_bit(sizeof(T)), "records are addressed by shift and mask");
+
+public:
+    using Handle = uint32_t;
+
+    static constexpr Handle NULL_HANDLE = UINT32_MAX;
+    static constexpr std::size_t SLAB_BYTES = 2 * 1024 * 1024;
+    static constexpr std::size_t RECORDS_PER_SLAB = SLAB_BYTES / sizeof(T);
+    static constexpr std::size_t SLAB_SHIFT = std::countr_zero(RECORDS_PER_SLAB);
+    static constexpr std::size_t MAX_SLABS = NULL_HANDLE / RECORDS_PER_SLAB;
+
+    SlabPool()
+        : m_slabs(std::make_unique<T*[]>(MAX_SLABS))
+    {
+    }
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    ~SlabPool()
+    {
+        for (std::size_t slab = 0; slab < m_slabCount; ++slab) {
+            munmap(m_slabs[slab], SLAB_BYTES);
+        }
+    }
+
+    // Maps slabs for `count` records up front, so allocate() never reaches mmap during the session.
+    void reserve(std::size_t count)
+    {
+        while (m_slabCount * RECORDS_PER_SLAB < count) {
+            addSlab();
+        }
+    }
+
+    // The record is left as it was, assign it before use.
+    [[nodiscard]] Handle allocate()
+    {
+        ++m_size;
+
+        if (m_freeHead != NULL_HANDLE) [[likely]] {
+            const auto handle = m_freeHead;
+            std::memcpy(&m_freeHead, &get(handle), sizeof(Handle));
+            return handle;
+        }
+
+        if (m_nextUnused == m_slabCount * RECORDS_PER_SLAB) [[unlikely]] {
+            addSlab();
+        }
+        return static_cast<Handle>(m_nextUnused++);
+    }
+
+    void release(Handle handle)
+    {
+        --m_size;
+        std::memcpy(&get(handle), &m_freeHead, sizeof(Handle));
+        m_freeHead = handle;
+    }
+
+    [[nodiscard]] T& get(Handle handle)
+    {
+        return m_slabs[handle >> SLAB_SHIFT][handle & (RECORDS_PER_SLAB - 1)];
+    }
+
+    [[nodiscard]] const T& get(Handle handle) const
+    {
+        return m_slabs[handle >> SLAB_SHIFT][handle & (RECORDS_PER_SLAB - 1)];
+    }
+
+    // Live records.
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_size;
+    }
+
+    [[nodiscard]] std::size_t reservedBytes() const
+    {
+        return m_slabCount * SLAB_BYTES;
+    }
+
+private:
+    std::unique_ptr<T*[]> m_slabs;
+    std::size_t m_slabCount { 0 };
+    std::size_t m_nextUnused { 0 };  // records below it have been handed out at least once.
+    std::size_t m_size { 0 };
+    Handle m_freeHead { NULL_HANDLE };
+
+    __attribute__((noinline, cold)) void addSlab()
+    {
+        if (m_slabCount == MAX_SLABS) {
+            LOG_ERROR("Slab pool is out of handles, {} records live", m_size);
+            throw std::bad_alloc();
+        }
+
+        void* slab = mmap(nullptr, SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE | MAP_HUGETLB, -1, 0);
+        if (slab == MAP_FAILED) {
+            slab = mapTransparentHugePage();
+        }
+
+        m_slabs[m_slabCount++] = static_cast<T*>(slab);
+    }
+
+    // No reserved huge pages. A transparent one needs a 2 MB aligned range: map twice the size, trim both ends, then fault it in.
+    static void* mapTransparentHugePage()
+    {
+        void* mapping = mmap(nullptr, 2 * SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping == MAP_FAILED) {
+            LOG_ERROR("Slab pool could not map {} bytes", 2 * SLAB_BYTES);
+            throw std::bad_alloc();
+        }
+
+        auto* begin = static_cast<std::byte*>(mapping);
+        const auto head = (SLAB_BYTES - reinterpret_cast<std::uintptr_t>(begin) % SLAB_BYTES) % SLAB_BYTES;
+        if (head != 0) {
+            munmap(begin, head);
+        }
+        munmap(begin + head + SLAB_BYTES, SLAB_BYTES - head);
+
+        void* slab = begin + head;
+        madvise(slab, SLAB_BYTES, MADV_HUGEPAGE);
+        std::memset(slab, 0, SLAB_BYTES);
+        return slab;
+    }
+};
+
+}  // namespace algocor
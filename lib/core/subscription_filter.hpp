@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "orderbook_registry.hpp"
+
+namespace algocor
+{
+
+// Orderbooks a market data partition keeps books for, checked by the parser before a message reaches the builder.
+//
+// An unsubscribed id is rejected by one bit test in a 512 byte bitset that stays in L1; only ids whose bit is set, the subscribed ones
+// and rare collisions, go on to an exact probe of the id table. Reads take no lock; ids and symbols can be added and removed from any
+// thread while the parser runs, writers serialise on a mutex. Symbols are resolved to ids as OrderBookDirectory messages announce them.
+//
+// Books that are unsubscribed stop getting messages, so what they hold goes stale. Every removed id is logged, and the parser flushes
+// the book of each one it has not seen yet before its next packet, see unsubscribed().
+//
+// Orderbook id 0 is not used by the exchange and is never subscribed.
+class SubscriptionFilter {
+public:
+    // Ids subscribed at once.
+    static constexpr std::size_t CAPACITY = 1024;
+
+private:
+    static constexpr std::size_t BITS = 4096;
+    static constexpr std::size_t TABLE_SIZE = CAPACITY * 2;
+    static constexpr uint32_t EMPTY = 0;
+    static constexpr uint32_t REMOVED = UINT32_MAX;  // keeps probe chains through a removed id intact.
+
+    std::array<std::atomic<uint64_t>, BITS / 64> m_bits {};
+    std::unique_ptr<std::atomic<uint32_t>[]> m_table { new std::atomic<uint32_t>[TABLE_SIZE] {} };
+    std::size_t m_used { 0 };     // table slots that hold an id.
+    std::size_t m_removed { 0 };  // table slots that hold REMOVED.
+    std::unordered_set<std::string> m_symbols;
+    std::vector<uint32_t> m_unsubscribed;  // every id removed, in order.
+    std::mutex m_writeMutex;               // guards the members above against concurrent writers.
+    std::atomic<std::size_t> m_unsubscribedCount { 0 };
+
+    static uint32_t hash(uint32_t orderbook_id)
+    {
+        return orderbook_id * 0x9E3779B9U;
+    }
+
+    static std::size_t bitOf(uint32_t orderbook_id)
+    {
+        return hash(orderbook_id) >> 20;  // top 12 bits, BITS == 1 << 12.
+    }
+
+    static std::size_t slotOf(uint32_t orderbook_id)
+    {
+        return hash(orderbook_id) >> 21;  // top 11 bits, TABLE_SIZE == 1 << 11.
+    }
+
+    static_assert(BITS == 1 << 12 && TABLE_SIZE == 1 << 11);
+
+public:
+    [[nodiscard]] bool contains(uint32_t orderbook_id) const
+    {
+        const auto bit = bitOf(orderbook_id);
+        if ((m_bits[bit / 64].load(std::memory_order_relaxed) & (uint64_t { 1 } << (bit % 64))) == 0) [[likely]] {
+            return false;
+        }
+
+        for (auto slot = slotOf(orderbook_id);; slot = (slot + 1) & (TABLE_SIZE - 1)) {
+            const auto id = m_table[slot].load(std::memory_order_acquire);
+            if (id == orderbook_id) {
+                return true;
+            }
+            if (id == EMPTY) {
+                return false;
+            }
+        }
+    }
+
+private:
+    bool subscribeLocked(uint32_t orderbook_id)
+    {
+        if (orderbook_id == EMPTY || orderbook_id == REMOVED) {
+            return false;
+        }
+        if (contains(orderbook_id)) {
+            return true;
+        }
+
+        if (m_used == CAPACITY) [[unlikely]] {
+            return false;
+        }
+
+        // The first removed slot on the probe path is reused: readers probe on through it until an empty slot either way.
+        auto slot = slotOf(orderbook_id);
+        auto reused = TABLE_SIZE;
+        for (;; slot = (slot + 1) & (TABLE_SIZE - 1)) {
+            const auto id = m_table[slot].load(std::memory_order_relaxed);
+            if (id == EMPTY) {
+                break;
+            }
+            if (id == REMOVED && reused == TABLE_SIZE) {
+                reused = slot;
+            }
+        }
+        if (reused != TABLE_SIZE) {
+            slot = reused;
+            --m_removed;
+        } else if (m_used + m_removed + 1 == TABLE_SIZE) [[unlikely]] {
+            return false;  // the last empty slot ends every probe.
+        }
+        ++m_used;
+
+        // The id is in the table before its bit lets readers probe for it.
+        m_table[slot].store(orderbook_id, std::memory_order_release);
+        const auto bit = bitOf(orderbook_id);
+        m_bits[bit / 64].fetch_or(uint64_t { 1 } << (bit % 64), std::memory_order_release);
+        return true;
+    }
+
+public:
+    // False when the id is 0 or the table has no room left.
+    bool subscribe(uint32_t orderbook_id)
+    {
+        const std::lock_guard lock(m_writeMutex);
+        return subscribeLocked(orderbook_id);
+    }
+
+    void unsubscribe(uint32_t orderbook_id)
+    {
+        const std::lock_guard lock(m_writeMutex);
+        if (orderbook_id == EMPTY || orderbook_id == REMOVED) {
+            return;
+        }
+        auto slot = slotOf(orderbook_id);
+        for (;; slot = (slot + 1) & (TABLE_SIZE - 1)) {
+            const auto id = m_table[slot].load(std::memory_order_relaxed);
+            if (id == EMPTY) {
+                return;
+            }
+            if (id == orderbook_id) {
+                break;
+            }
+        }
+        m_table[slot].store(REMOVED, std::memory_order_release);
+        --m_used;
+        ++m_removed;
+
+        // No probe goes past a removed slot followed by an empty one, so such slots can be emptied, from the end of the run back.
+        while (m_table[(slot + 1) & (TABLE_SIZE - 1)].load(std::memory_order_relaxed) == EMPTY
+            && m_table[slot].load(std::memory_order_relaxed) == REMOVED) {
+            m_table[slot].store(EMPTY, std::memory_order_release);
+            --m_removed;
+            slot = (slot - 1) & (TABLE_SIZE - 1);
+        }
+
+        m_unsubscribed.push_back(orderbook_id);
+        m_unsubscribedCount.store(m_unsubscribed.size(), std::memory_order_release);
+
+        // The bit stays set while another subscribed id shares it.
+        const auto bit = bitOf(orderbook_id);
+        auto bit_in_use = false;
+        for (std::size_t index = 0; index < TABLE_SIZE && !bit_in_use; ++index) {
+            const auto id = m_table[index].load(std::memory_order_relaxed);
+            bit_in_use = id != EMPTY && id != REMOVED && bitOf(id) == bit;
+        }
+        if (!bit_in_use) {
+            m_bits[bit / 64].fetch_and(~(uint64_t { 1 } << (bit % 64)), std::memory_order_release);
+        }
+    }
+
+    // Drops every id and symbol, not safe while the parser runs.
+    void clear()
+    {
+        const std::lock_guard lock(m_writeMutex);
+        for (auto& word : m_bits) {
+            word.store(0, std::memory_order_relaxed);
+        }
+        for (std::size_t slot = 0; slot < TABLE_SIZE; ++slot) {
+            const auto id = m_table[slot].exchange(EMPTY, std::memory_order_relaxed);
+            if (id != EMPTY && id != REMOVED) {
+                m_unsubscribed.push_back(id);
+            }
+        }
+        m_used = 0;
+        m_removed = 0;
+        m_symbols.clear();
+        m_unsubscribedCount.store(m_unsubscribed.size(), std::memory_order_release);
+    }
+
+    // Ids removed so far, by unsubscribe() or clear(). A reader keeps the count it has handled and passes it to forEachUnsubscribed()
+    // when this moves on.
+    [[nodiscard]] std::size_t unsubscribed() const
+    {
+        return m_unsubscribedCount.load(std::memory_order_acquire);
+    }
+
+    // Calls `f` with each id removed after the first `from`, returns the new count.
+    template<typename F>
+    std::size_t forEachUnsubscribed(std::size_t from, F&& f)
+    {
+        const std::lock_guard lock(m_writeMutex);
+        for (auto index = from; index < m_unsubscribed.size(); ++index) {
+            f(m_unsubscribed[index]);
+        }
+        return m_unsubscribed.size();
+    }
+
+    // Subscribes the book once an OrderBookDirectory message announces `symbol`, see onDirectory().
+    void subscribeSymbol(std::string_view symbol)
+    {
+        const std::lock_guard lock(m_writeMutex);
+        m_symbols.emplace(symbol);
+    }
+
+    // Called by the parser for every directory message, padding of `symbol` is ignored.
+    void onDirectory(uint32_t orderbook_id, std::string_view symbol)
+    {
+        const std::lock_guard lock(m_writeMutex);
+        if (!m_symbols.empty() && m_symbols.contains(std::string(trimSymbol(symbol)))) {
+            subscribeLocked(orderbook_id);
+        }
+    }
+};
+
+}  // namespace algocor
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+
+#include "../utility/overwrite_macros.hpp"
+#include "../utility/quill_wrapper.hpp"
+
+namespace algocor
+{
+
+// One side of a book, stored as a price ladder. Every price inside a window of 2^WindowBits ticks maps directly to a slot by its
+// offset from a moving anchor, so add/execute/delete are a subtraction and an index: no search, no memmove. Occupancy is tracked with a
+// two-level bitmap (one bit per slot, one summary bit per 64 slots), so the next best level after a level empties is found with two
+// lzcnt (bids) or tzcnt (asks) instructions.
+//
+// Levels that are worse than everything inside the window are parked in a cold std::map and pulled back in lazily when the window drains.
+// The window is re-anchored when a price improves beyond it, which is rare with a window of thousands of ticks.
+//
+// A tick here is one unit of the raw ITCH price field.
+template<bool IsBid, unsigned WindowBits = 12>
+class TickLadder {
+    static_assert(WindowBits >= 6 && WindowBits <= 12, "two-level bitmap covers at most 64 * 64 slots");
+
+    static constexpr int64_t SLOTS = int64_t { 1 } << WindowBits;
+    static constexpr int64_t WORDS = SLOTS / 64;
+
+    std::array<uint64_t, SLOTS> m_qty {};
+    std::array<uint64_t, WORDS> m_occupied {};
+    uint64_t m_summary { 0 };
+    int64_t m_anchor { 0 };  // price of slot 0.
+    uint32_t m_levelCount { 0 };
+
+    // Levels worse than every level in the window. Cold, only touched on re-anchor and when the window drains.
+    std::map<int32_t, uint64_t> m_overflow;
+
+    [[nodiscard]] static constexpr bool isBetter(int64_t lhs, int64_t rhs)
+    {
+        if constexpr (IsBid) {
+            return lhs > rhs;
+        } else {
+            return lhs < rhs;
+        }
+    }
+
+    [[nodiscard]] bool inWindow(int64_t offset) const
+    {
+        return static_cast<uint64_t>(offset) < static_cast<uint64_t>(SLOTS);
+    }
+
+    void setBit(int64_t slot)
+    {
+        const auto word = slot >> 6;
+        m_occupied[word] |= uint64_t { 1 } << (slot & 63);
+        m_summary |= uint64_t { 1 } << word;
+    }
+
+    void clearBit(int64_t slot)
+    {
+        const auto word = slot >> 6;
+        m_occupied[word] &= ~(uint64_t { 1 } << (slot & 63));
+        if (m_occupied[word] == 0) {
+            m_summary &= ~(uint64_t { 1 } << word);
+        }
+    }
+
+    // Best occupied slot, highest for bids and lowest for asks. Window must not be empty.
+    [[nodiscard]] int64_t bestSlot() const
+    {
+        if constexpr (IsBid) {
+            const int64_t word = 63 - std::countl_zero(m_summary);
+            return (word << 6) + 63 - std::countl_zero(m_occupied[word]);
+        } else {
+            const int64_t word = std::countr_zero(m_summary);
+            return (word << 6) + std::countr_zero(m_occupied[word]);
+        }
+    }
+
+    [[nodiscard]] std::pair<int32_t, uint64_t> bestOverflow() const
+    {
+        if constexpr (IsBid) {
+            return *m_overflow.rbegin();
+        } else {
+            return *m_overflow.begin();
+        }
+    }
+
+    // Moves the window so that `best` sits near its better edge with room left for price improvement. Everything that no longer fits is
+    // pushed into the overflow map, then overflow levels that fit the new window are pulled back in.
+    __attribute__((noinline, cold)) void reanchor(int64_t best)
+    {
+        LOG_DEBUG("Re-anchoring tick ladder around price {}", best);
+
+        for (uint64_t summary = m_summary; summary != 0; summary &= summary - 1) {
+            const int64_t word = std::countr_zero(summary);
+            for (uint64_t bits = m_occupied[word]; bits != 0; bits &= bits - 1) {
+                const int64_t slot = (word << 6) + std::countr_zero(bits);
+                m_overflow[static_cast<int32_t>(m_anchor + slot)] += m_qty[slot];
+                m_qty[slot] = 0;
+            }
+            m_occupied[word] = 0;
+        }
+        m_summary = 0;
+        m_levelCount = 0;
+
+        m_anchor = IsBid ? best - (SLOTS * 3 / 4) : best - (SLOTS / 4);
+
+        auto first = m_overflow.lower_bound(static_cast<int32_t>(std::max<int64_t>(m_anchor, INT32_MIN)));
+        auto last = m_overflow.lower_bound(static_cast<int32_t>(std::min<int64_t>(m_anchor + SLOTS, INT32_MAX)));
+        for (auto iter = first; iter != last; ++iter) {
+            const auto slot = iter->first - m_anchor;
+            m_qty[slot] = iter->second;
+            setBit(slot);
+            ++m_levelCount;
+        }
+        m_overflow.erase(first, last);
+    }
+
+public:
+    [[nodiscard]] bool empty() const
+    {
+        return m_summary == 0 && m_overflow.empty();
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return m_levelCount + m_overflow.size();
+    }
+
+    // The window lives inside the ladder, only overflow map nodes are on the heap (value plus three pointers and the colour).
+    [[nodiscard]] std::size_t memoryBytes() const
+    {
+        return m_overflow.size() * (sizeof(std::pair<const int32_t, uint64_t>) + 4 * sizeof(void*));
+    }
+
+    [[nodiscard]] std::pair<int32_t, uint64_t> best() const
+    {
+        if (m_summary != 0) [[likely]] {
+            const auto slot = bestSlot();
+            return { static_cast<int32_t>(m_anchor + slot), m_qty[slot] };
+        }
+
+        return bestOverflow();
+    }
+
+    void add(int32_t price, uint64_t qty)
+    {
+        // A zero quantity would mark the slot occupied without making it a level, see the contract in level_stores.hpp.
+        if (qty == 0) [[unlikely]] {
+            return;
+        }
+        int64_t offset = price - m_anchor;
+
+        if (!inWindow(offset)) [[unlikely]] {
+            if (m_summary == 0 || isBetter(price, m_anchor + bestSlot())) {
+                // Empty window or a new best outside of it: move the window.
+                reanchor(price);
+                offset = price - m_anchor;
+            } else {
+                m_overflow[price] += qty;
+                return;
+            }
+        }
+
+        if (m_qty[offset] == 0) {
+            setBit(offset);
+            ++m_levelCount;
+        }
+        m_qty[offset] += qty;
+    }
+
+    // Returns false if there is no level at `price`. The level is removed once its quantity is consumed.
+    bool remove(int32_t price, uint64_t qty)
+    {
+        const int64_t offset = price - m_anchor;
+
+        if (inWindow(offset) && m_qty[offset] != 0) [[likely]] {
+            if (m_qty[offset] > qty) [[likely]] {
+                m_qty[offset] -= qty;
+                return true;
+            }
+
+            m_qty[offset] = 0;
+            clearBit(offset);
+            --m_levelCount;
+
+            if (m_summary == 0 && !m_overflow.empty()) [[unlikely]] {
+                reanchor(bestOverflow().first);
+            }
+            return true;
+        }
+
+        auto iter = m_overflow.find(price);
+        if (iter == m_overflow.end()) [[unlikely]] {
+            return false;
+        }
+
+        if (iter->second > qty) {
+            iter->second -= qty;
+        } else {
+            m_overflow.erase(iter);
+        }
+        return true;
+    }
+
+    bool modify(int32_t price, uint64_t old_qty, uint64_t new_qty)
+    {
+        const int64_t offset = price - m_anchor;
+
+        if (inWindow(offset) && m_qty[offset] != 0) [[likely]] {
+            m_qty[offset] = m_qty[offset] - old_qty + new_qty;
+            if (m_qty[offset] == 0) [[unlikely]] {
+                clearBit(offset);
+                --m_levelCount;
+                if (m_summary == 0 && !m_overflow.empty()) [[unlikely]] {
+                    reanchor(bestOverflow().first);
+                }
+            }
+            return true;
+        }
+
+        auto iter = m_overflow.find(price);
+        if (iter == m_overflow.end()) [[unlikely]] {
+            return false;
+        }
+
+        iter->second = iter->second - old_qty + new_qty;
+        if (iter->second == 0) {
+            m_overflow.erase(iter);
+        }
+        return true;
+    }
+
+    // Copies up to `count` best levels, best first. Walks the occupancy bitmap, so empty slots cost nothing.
+    std::size_t top(std::size_t count, int32_t* prices, uint64_t* qtys) const
+    {
+        std::size_t levels = 0;
+
+        for (uint64_t summary = m_summary; summary != 0 && levels < count;) {
+            const int64_t word = IsBid ? 63 - std::countl_zero(summary) : std::countr_zero(summary);
+            summary &= ~(uint64_t { 1 } << word);
+
+            for (uint64_t bits = m_occupied[word]; bits != 0 && levels < count; ++levels) {
+                const int64_t bit = IsBid ? 63 - std::countl_zero(bits) : std::countr_zero(bits);
+                bits &= ~(uint64_t { 1 } << bit);
+                const int64_t slot = (word << 6) + bit;
+                prices[levels] = static_cast<int32_t>(m_anchor + slot);
+                qtys[levels] = m_qty[slot];
+            }
+        }
+
+        const auto copy = [&](const auto& level) {
+            prices[levels] = level.first;
+            qtys[levels] = level.second;
+            ++levels;
+        };
+        if constexpr (IsBid) {
+            for (auto iter = m_overflow.rbegin(); iter != m_overflow.rend() && levels < count; ++iter) {
+                copy(*iter);
+            }
+        } else {
+            for (auto iter = m_overflow.begin(); iter != m_overflow.end() && levels < count; ++iter) {
+                copy(*iter);
+            }
+        }
+        return levels;
+    }
+
+    // Visits levels from best to worst. Not for the hot path.
+    template<typename Func>
+    void forEach(Func&& func) const
+    {
+        if constexpr (IsBid) {
+            for (int64_t slot = SLOTS - 1; slot >= 0; --slot) {
+                if (m_qty[slot] != 0) {
+                    func(static_cast<int32_t>(m_anchor + slot), m_qty[slot]);
+                }
+            }
+            for (auto iter = m_overflow.rbegin(); iter != m_overflow.rend(); ++iter) {
+                func(iter->first, iter->second);
+            }
+        } else {
+            for (int64_t slot = 0; slot < SLOTS; ++slot) {
+                if (m_qty[slot] != 0) {
+                    func(static_cast<int32_t>(m_anchor + slot), m_qty[slot]);
+                }
+            }
+            for (const auto& [price, qty] : m_overflow) {
+                func(price, qty);
+            }
+        }
+    }
+};
+
+struct TickLadderPolicy {
+    template<bool IsBid>
+    using Side = TickLadder<IsBid>;
+};
+
+}  // namespace algocor
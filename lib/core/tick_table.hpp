@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <emmintrin.h>  // SSE2, baseline on x86-64.
+
+namespace algocor
+{
+
+// Tick size bands of one instrument, from its TickSizeTableEntry ('L') messages, for converting ITCH prices to tick numbers and back.
+// BIST tick sizes grow with the price, so a price is first matched to its band: the band starts sit in one cache line and are compared
+// against the price four at a time, the band is the count of starts not above it. No branch depends on the price.
+//
+// Tick index 0 is the start of the lowest band; prices below it count in that band. Before any band is added the table is the identity.
+class TickTable {
+public:
+    static constexpr std::size_t MAX_BANDS = 16;
+
+private:
+    static constexpr int32_t UNUSED = INT32_MAX;  // start of a band not in use, never at or below a price.
+
+    alignas(64) std::array<int32_t, MAX_BANDS> m_from { initialBounds() };
+    alignas(64) std::array<int32_t, MAX_BANDS> m_firstTick { initialBounds() };  // tick index of each band start.
+    alignas(64) std::array<int32_t, MAX_BANDS> m_tickSize { initialTickSizes() };
+    uint32_t m_bands { 0 };
+
+    static constexpr std::array<int32_t, MAX_BANDS> initialBounds()
+    {
+        std::array<int32_t, MAX_BANDS> bounds {};
+        bounds.fill(UNUSED);
+        bounds[0] = 0;
+        return bounds;
+    }
+
+    static constexpr std::array<int32_t, MAX_BANDS> initialTickSizes()
+    {
+        std::array<int32_t, MAX_BANDS> tick_sizes {};
+        tick_sizes.fill(1);
+        return tick_sizes;
+    }
+
+    // Index of the last bound not above `value`, 0 when all are above it.
+    static std::size_t bandOf(const std::array<int32_t, MAX_BANDS>& bounds, int32_t value)
+    {
+        const auto needle = _mm_set1_epi32(value);
+        uint32_t above = 0;
+        for (std::size_t lane = 0; lane < MAX_BANDS; lane += 4) {
+            const auto bound = _mm_load_si128(reinterpret_cast<const __m128i*>(bounds.data() + lane));
+            above |= static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(bound, needle)))) << lane;
+        }
+        const auto count = MAX_BANDS - static_cast<std::size_t>(std::popcount(above));
+        return count - (count != 0);
+    }
+
+public:
+    // Adds the band starting at `from`, or changes its tick size when there is one. False when the table is full or the tick size is
+    // not positive.
+    bool addBand(int32_t from, int64_t tick_size)
+    {
+        if (tick_size <= 0 || tick_size > INT32_MAX || from == UNUSED) {
+            return false;
+        }
+
+        std::size_t band = 0;
+        while (band < m_bands && m_from[band] < from) {
+            ++band;
+        }
+        if (band == m_bands || m_from[band] != from) {
+            if (m_bands == MAX_BANDS) {
+                return false;
+            }
+            for (auto index = m_bands; index > band; --index) {
+                m_from[index] = m_from[index - 1];
+                m_tickSize[index] = m_tickSize[index - 1];
+            }
+            ++m_bands;
+        }
+        m_from[band] = from;
+        m_tickSize[band] = static_cast<int32_t>(tick_size);
+
+        m_firstTick[0] = 0;
+        for (std::size_t index = 1; index < m_bands; ++index) {
+            m_firstTick[index] = m_firstTick[index - 1] + (m_from[index] - m_from[index - 1]) / m_tickSize[index - 1];
+        }
+        return true;
+    }
+
+    // Tick number of `price`, a price between two ticks rounds towards the start of its band.
+    [[nodiscard]] int32_t tickIndex(int32_t price) const
+    {
+        const auto band = bandOf(m_from, price);
+        return m_firstTick[band] + (price - m_from[band]) / m_tickSize[band];
+    }
+
+    [[nodiscard]] int32_t priceOf(int32_t tick_index) const
+    {
+        const auto band = bandOf(m_firstTick, tick_index);
+        return m_from[band] + (tick_index - m_firstTick[band]) * m_tickSize[band];
+    }
+
+    // Price `ticks` ticks above `price` (below for a negative count), across bands.
+    [[nodiscard]] int32_t ticksAway(int32_t price, int32_t ticks) const
+    {
+        return priceOf(tickIndex(price) + ticks);
+    }
+
+    [[nodiscard]] int32_t tickSize(int32_t price) const
+    {
+        return m_tickSize[bandOf(m_from, price)];
+    }
+
+    [[nodiscard]] std::size_t bands() const
+    {
+        return m_bands;
+    }
+};
+
+}  // namespace algocor
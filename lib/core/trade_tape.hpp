@@ -0,0 +1,138 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+
+namespace algocor
+{
+
+// One printable trade: an execution of a resting order ('E', 'C') or a trade reported on its own ('P').
+struct TradePrint {
+    uint64_t timestamp;  // nanoseconds since midnight.
+    uint64_t match_id;
+    uint64_t qty;
+    int32_t price;
+    char side;  // side of the resting order, ' ' when the exchange does not disclose it.
+};
+
+static_assert(sizeof(TradePrint) == 32);
+
+// Trade tape of one instrument: the last Capacity prints in a ring plus statistics kept up to date as prints arrive, so readers get
+// last price, volume, VWAP and OHLC in O(1). Session figures cover every print since construction or reset(), window figures the prints
+// still in the ring.
+template<std::size_t Capacity = 256>
+class TradeTape {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    std::array<TradePrint, Capacity> m_prints {};
+    uint64_t m_count { 0 };
+
+    int32_t m_open { 0 };
+    int32_t m_high { INT32_MIN };
+    int32_t m_low { INT32_MAX };
+    int32_t m_last { 0 };
+    uint64_t m_volume { 0 };
+    double m_turnover { 0.0 };  // sum of price * qty, in price units. A double does not overflow over a session.
+
+    uint64_t m_windowVolume { 0 };
+    int64_t m_windowTurnover { 0 };  // exact, at most Capacity prints.
+
+public:
+    void record(const TradePrint& print)
+    {
+        auto& slot = m_prints[m_count & (Capacity - 1)];
+        if (m_count >= Capacity) {
+            m_windowVolume -= slot.qty;
+            m_windowTurnover -= static_cast<int64_t>(slot.price) * static_cast<int64_t>(slot.qty);
+        }
+        slot = print;
+
+        if (m_count == 0) {
+            m_open = print.price;
+        }
+        ++m_count;
+        m_high = std::max(m_high, print.price);
+        m_low = std::min(m_low, print.price);
+        m_last = print.price;
+        m_volume += print.qty;
+        m_turnover += static_cast<double>(print.price) * static_cast<double>(print.qty);
+
+        m_windowVolume += print.qty;
+        m_windowTurnover += static_cast<int64_t>(print.price) * static_cast<int64_t>(print.qty);
+    }
+
+    // Starts a new session, e.g. on the start of trading system event.
+    void reset()
+    {
+        *this = TradeTape {};
+    }
+
+    // Prints ever recorded, the ring holds the last min(tradeCount(), Capacity) of them.
+    [[nodiscard]] uint64_t tradeCount() const
+    {
+        return m_count;
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return static_cast<std::size_t>(std::min<uint64_t>(m_count, Capacity));
+    }
+
+    // 0 is the most recent print, size() - 1 the oldest still held.
+    [[nodiscard]] const TradePrint& operator[](std::size_t age) const
+    {
+        return m_prints[(m_count - 1 - age) & (Capacity - 1)];
+    }
+
+    [[nodiscard]] const TradePrint& lastPrint() const
+    {
+        return (*this)[0];
+    }
+
+    // The OHLC accessors return 0 (high INT32_MIN, low INT32_MAX) before the first print.
+    [[nodiscard]] int32_t open() const
+    {
+        return m_open;
+    }
+
+    [[nodiscard]] int32_t high() const
+    {
+        return m_high;
+    }
+
+    [[nodiscard]] int32_t low() const
+    {
+        return m_low;
+    }
+
+    [[nodiscard]] int32_t last() const
+    {
+        return m_last;
+    }
+
+    [[nodiscard]] uint64_t volume() const
+    {
+        return m_volume;
+    }
+
+    // 0 before the first print.
+    [[nodiscard]] double vwap() const
+    {
+        return m_volume == 0 ? 0.0 : m_turnover / static_cast<double>(m_volume);
+    }
+
+    [[nodiscard]] uint64_t windowVolume() const
+    {
+        return m_windowVolume;
+    }
+
+    [[nodiscard]] double windowVwap() const
+    {
+        return m_windowVolume == 0 ? 0.0 : static_cast<double>(m_windowTurnover) / static_cast<double>(m_windowVolume);
+    }
+};
+
+}  // namespace algocor
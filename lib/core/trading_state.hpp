@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../utility/seqlock.hpp"
+#include "orderbook_registry.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+namespace algocor
+{
+
+enum class TradingPhase : uint8_t
+{
+    Unknown,  // no OrderBookState yet, or a state name not classified below.
+    Continuous,
+    Auction,  // orders are collected or matched at a single price, the book may be crossed.
+    Halted,
+    Closed,
+};
+
+// Phase of an OrderBookState ('O') state name. BIST names the states in Turkish, e.g. P_SUREKLI_ISLEM for continuous trading, with a
+// prefix that differs between markets. Names are matched on keywords, as the longer ones are cut to the 20 byte field.
+inline TradingPhase tradingPhaseOf(std::string_view state_name)
+{
+    const auto has = [&](std::string_view word) { return state_name.find(word) != std::string_view::npos; };
+    if (has("DURDUR") || has("HALT")) {
+        return TradingPhase::Halted;
+    }
+    if (has("SUREKLI") || has("CONTINUOUS")) {
+        return TradingPhase::Continuous;
+    }
+    if (has("TOPLAM") || has("ESLES") || has("TEK_FIYAT") || has("AUCTION")) {
+        return TradingPhase::Auction;
+    }
+    if (has("KAPALI") || has("GUN_SONU") || has("CLOSE")) {
+        return TradingPhase::Closed;
+    }
+    return TradingPhase::Unknown;
+}
+
+// Latest EquilibriumPriceUpdate ('Z') of a book in auction, all zero outside of one.
+struct AuctionState {
+    uint64_t timestamp;  // exchange time, nanoseconds since midnight.
+    int32_t equilibrium_price;
+    int32_t best_bid_price;
+    int32_t best_ask_price;
+    uint32_t reserved;
+    uint64_t bid_qty_at_equilibrium;
+    uint64_t ask_qty_at_equilibrium;
+    uint64_t best_bid_qty;
+    uint64_t best_ask_qty;
+};
+
+using PublishedAuctionState = Seqlock<AuctionState>;
+
+static_assert(sizeof(PublishedAuctionState) == 64);
+
+// Trading phase and auction state of every book of a partition, by OrderbookRegistry index. Phases are one byte per book in a single
+// array, so checking whether a book trades continuously is one load from a table that stays in cache; auction details sit apart in a
+// seqlock per book. Written by the book builder, read by any thread with an index resolved once after the book was registered.
+class TradingStateTable {
+    static constexpr std::size_t CAPACITY = OrderbookRegistry::MAX_ORDERBOOKS;
+
+    std::unique_ptr<std::atomic<TradingPhase>[]> m_phases { new std::atomic<TradingPhase>[CAPACITY] {} };
+    std::unique_ptr<PublishedAuctionState[]> m_auctions { new PublishedAuctionState[CAPACITY] };
+
+public:
+    [[nodiscard]] TradingPhase phase(OrderbookRegistry::Index index) const
+    {
+        return m_phases[index].load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool isContinuous(OrderbookRegistry::Index index) const
+    {
+        return phase(index) == TradingPhase::Continuous;
+    }
+
+    // Writer side, returns the previous phase. Leaving an auction clears its state.
+    TradingPhase setPhase(OrderbookRegistry::Index index, TradingPhase phase)
+    {
+        const auto previous = m_phases[index].exchange(phase, std::memory_order_relaxed);
+        if (previous == TradingPhase::Auction && phase != TradingPhase::Auction) {
+            m_auctions[index].store({});
+        }
+        return previous;
+    }
+
+    // Writer side, for every registered book at the end of the session.
+    void closeAll(std::size_t books)
+    {
+        for (OrderbookRegistry::Index index = 0; index < books; ++index) {
+            setPhase(index, TradingPhase::Closed);
+        }
+    }
+
+    // Writer side.
+    void setAuction(OrderbookRegistry::Index index, const AuctionState& auction)
+    {
+        m_auctions[index].store(auction);
+    }
+
+    // All zero for a book that never had an equilibrium price update.
+    [[nodiscard]] AuctionState auction(OrderbookRegistry::Index index) const
+    {
+        return m_auctions[index].load();
+    }
+};
+
+}  // namespace algocor
@@ -130,6 +130,7 @@ void TcpClient::handleMessage(const char* data, uint16_t length)
 
             // not byte swapping orderbook ID to improve latency.
             m_marketAccessor.m_orderManager.orderAccepted(order_accepted.order_token,
+                be64toh(order_accepted.order_id),
                 be64toh(order_accepted.quantity),
                 order_accepted.orderbook_id,
                 be32toh(order_accepted.price),
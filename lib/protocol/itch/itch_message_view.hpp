@@ -0,0 +1,512 @@
+#pragma once
+
+#include "../../constants.hpp"
+#include "../../types.hpp"
+#include "itch_add_order.hpp"
+#include "itch_add_order_with_mpid.hpp"
+#include "itch_combination_orderbook_leg.hpp"
+#include "itch_equilibrium_price_update.hpp"
+#include "itch_order_delete.hpp"
+#include "itch_order_executed.hpp"
+#include "itch_order_executed_with_price.hpp"
+#include "itch_order_replace.hpp"
+#include "itch_orderbook_directory.hpp"
+#include "itch_orderbook_flush.hpp"
+#include "itch_orderbook_state.hpp"
+#include "itch_seconds.hpp"
+#include "itch_system_event.hpp"
+#include "itch_tick_size_table_entry.hpp"
+#include "itch_trade.hpp"
+
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+namespace algocor::protocol::itch
+{
+
+// std::byteswap is C++23.
+template<std::unsigned_integral T>
+constexpr T byteswap(T value)
+{
+    if constexpr (sizeof(T) == 1) {
+        return value;
+    } else if constexpr (sizeof(T) == 2) {
+        return __builtin_bswap16(value);
+    } else if constexpr (sizeof(T) == 4) {
+        return __builtin_bswap32(value);
+    } else {
+        static_assert(sizeof(T) == 8);
+        return __builtin_bswap64(value);
+    }
+}
+
+// Network (big endian) to host order, or back.
+template<std::unsigned_integral T>
+constexpr T networkToHost(T value)
+{
+    if constexpr (std::endian::native == std::endian::little) {
+        return byteswap(value);
+    } else {
+        return value;
+    }
+}
+
+// Wire bytes of a field as they are, in network order.
+template<std::size_t Offset, std::unsigned_integral T>
+T loadNetworkOrder(const char* message)
+{
+    T value;
+    std::memcpy(&value, message + Offset, sizeof(value));
+    return value;
+}
+
+// Read-only view of one ITCH message in the receive buffer. Fields are loaded from their wire offsets and put in host order when
+// they are read, so a handler touches only the bytes it uses and never forms a reference to a misaligned packed member. A view is
+// also made from the packed struct of its message, which is how tests and replays build messages.
+template<typename Message>
+class MessageView {
+    const char* m_message;
+
+protected:
+    template<std::size_t Offset, typename T>
+    T field() const
+    {
+        if constexpr (sizeof(T) == 1) {
+            return static_cast<T>(m_message[Offset]);
+        } else {
+            using Raw = std::make_unsigned_t<T>;
+            return static_cast<T>(networkToHost(loadNetworkOrder<Offset, Raw>(m_message)));
+        }
+    }
+
+    // Compares a field with a host order value without swapping the field: the constant is swapped instead, which the compiler does
+    // at compile time for a literal.
+    template<std::size_t Offset, std::unsigned_integral T>
+    bool fieldEquals(T value) const
+    {
+        return loadNetworkOrder<Offset, T>(m_message) == networkToHost(value);
+    }
+
+    // Fixed width text field as it is on the wire, with its padding.
+    template<std::size_t Offset, std::size_t Length>
+    std::string_view text() const
+    {
+        return { m_message + Offset, Length };
+    }
+
+public:
+    static constexpr std::size_t SIZE = sizeof(Message);
+
+    explicit MessageView(const char* message)
+        : m_message(message)
+    {
+    }
+
+    // NOLINTNEXTLINE(google-explicit-constructor): a packed message converts to its view wherever a handler takes one.
+    MessageView(const Message& message)
+        : m_message(reinterpret_cast<const char*>(&message))
+    {
+    }
+
+    [[nodiscard]] const char* data() const
+    {
+        return m_message;
+    }
+
+    [[nodiscard]] uint32_t nanoseconds() const
+    {
+        return field<algocor::TIMESTAMP_NANOSECONDS_OFFSET, uint32_t>();
+    }
+};
+
+class AddOrderView : public MessageView<AddOrder> {
+public:
+    using MessageView::MessageView;
+
+    // The MPID variant appends the participant id to the same fields.
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    AddOrderView(const AddOrderWithMPID& message)
+        : MessageView(reinterpret_cast<const char*>(&message))
+    {
+        static_assert(constants::ADD_ORDER_WITH_MPID_MSG_LOT_TYPE_OFFSET == constants::ADD_ORDER_MSG_LOT_TYPE_OFFSET
+            && constants::ADD_ORDER_WITH_MPID_MSG_PRICE_OFFSET == constants::ADD_ORDER_MSG_PRICE_OFFSET
+            && constants::ADD_ORDER_WITH_MPID_MSG_ORDERBOOK_POS_OFFSET == constants::ADD_ORDER_MSG_ORDERBOOK_POS_OFFSET
+            && constants::ADD_ORDER_WITH_MPID_MSG_PARTICIPANT_ID_OFFSET == static_cast<int>(constants::ADD_ORDER_MSG_SIZE));
+    }
+
+    [[nodiscard]] uint64_t orderId() const
+    {
+        return field<constants::ADD_ORDER_MSG_ORDER_ID_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return field<constants::ADD_ORDER_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] bool isOrderbook(uint32_t orderbook_id) const
+    {
+        return fieldEquals<constants::ADD_ORDER_MSG_ORDERBOOK_ID_OFFSET>(orderbook_id);
+    }
+
+    [[nodiscard]] char side() const
+    {
+        return field<constants::ADD_ORDER_MSG_SIDE_OFFSET, char>();
+    }
+
+    [[nodiscard]] uint32_t orderbookPosition() const
+    {
+        return field<constants::ADD_ORDER_MSG_ORDERBOOK_POS_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] uint64_t quantity() const
+    {
+        return field<constants::ADD_ORDER_MSG_QUANTITY_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] int32_t price() const
+    {
+        return field<constants::ADD_ORDER_MSG_PRICE_OFFSET, int32_t>();
+    }
+};
+
+// 'E' and 'C' share their leading fields, see OrderExecutedWithPriceView for the rest of 'C'.
+template<typename Message>
+class BasicOrderExecutedView : public MessageView<Message> {
+    using Base = MessageView<Message>;
+
+    static_assert(constants::ORDER_EXEC_WITH_PX_MSG_ORDER_ID_OFFSET == constants::ORDER_EXEC_MSG_ORDER_ID_OFFSET
+        && constants::ORDER_EXEC_WITH_PX_MSG_ORDERBOOK_ID_OFFSET == constants::ORDER_EXEC_MSG_ORDERBOOK_ID_OFFSET
+        && constants::ORDER_EXEC_WITH_PX_MSG_SIDE_OFFSET == constants::ORDER_EXEC_MSG_SIDE_OFFSET
+        && constants::ORDER_EXEC_WITH_PX_MSG_EXEC_QTY_OFFSET == constants::ORDER_EXEC_MSG_EXEC_QTY_OFFSET
+        && constants::ORDER_EXEC_WITH_PX_MSG_MATCH_ID_OFFSET == constants::ORDER_EXEC_MSG_MATCH_ID_OFFSET);
+
+public:
+    using Base::Base;
+
+    [[nodiscard]] uint64_t orderId() const
+    {
+        return Base::template field<constants::ORDER_EXEC_MSG_ORDER_ID_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return Base::template field<constants::ORDER_EXEC_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] bool isOrderbook(uint32_t orderbook_id) const
+    {
+        return Base::template fieldEquals<constants::ORDER_EXEC_MSG_ORDERBOOK_ID_OFFSET>(orderbook_id);
+    }
+
+    [[nodiscard]] char side() const
+    {
+        return Base::template field<constants::ORDER_EXEC_MSG_SIDE_OFFSET, char>();
+    }
+
+    [[nodiscard]] uint64_t quantity() const
+    {
+        return Base::template field<constants::ORDER_EXEC_MSG_EXEC_QTY_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] uint64_t matchId() const
+    {
+        return Base::template field<constants::ORDER_EXEC_MSG_MATCH_ID_OFFSET, uint64_t>();
+    }
+};
+
+using OrderExecutedView = BasicOrderExecutedView<OrderExecuted>;
+
+class OrderExecutedWithPriceView : public BasicOrderExecutedView<OrderExecutedWithPrice> {
+public:
+    using BasicOrderExecutedView::BasicOrderExecutedView;
+
+    [[nodiscard]] int32_t tradePrice() const
+    {
+        return field<constants::ORDER_EXEC_WITH_PX_MSG_TRADE_PX_OFFSET, int32_t>();
+    }
+
+    [[nodiscard]] bool printable() const
+    {
+        return field<constants::ORDER_EXEC_WITH_PX_MSG_PRINTABLE_OFFSET, char>() == static_cast<char>(algocor::Printable::Yes);
+    }
+};
+
+class OrderDeleteView : public MessageView<OrderDelete> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint64_t orderId() const
+    {
+        return field<constants::ORDER_DELETE_MSG_ORDER_ID_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return field<constants::ORDER_DELETE_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] bool isOrderbook(uint32_t orderbook_id) const
+    {
+        return fieldEquals<constants::ORDER_DELETE_MSG_ORDERBOOK_ID_OFFSET>(orderbook_id);
+    }
+
+    [[nodiscard]] char side() const
+    {
+        return field<constants::ORDER_DELETE_MSG_SIDE_OFFSET, char>();
+    }
+};
+
+class OrderReplaceView : public MessageView<OrderReplace> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint64_t orderId() const
+    {
+        return field<constants::REPLACE_ORDER_MSG_ORDER_ID_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return field<constants::REPLACE_ORDER_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] bool isOrderbook(uint32_t orderbook_id) const
+    {
+        return fieldEquals<constants::REPLACE_ORDER_MSG_ORDERBOOK_ID_OFFSET>(orderbook_id);
+    }
+
+    [[nodiscard]] char side() const
+    {
+        return field<constants::REPLACE_ORDER_MSG_SIDE_OFFSET, char>();
+    }
+
+    [[nodiscard]] uint32_t orderbookPosition() const
+    {
+        return field<constants::REPLACE_ORDER_MSG_ORDERBOOK_POS_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] uint64_t quantity() const
+    {
+        return field<constants::REPLACE_ORDER_MSG_QUANTITY_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] int32_t price() const
+    {
+        return field<constants::REPLACE_ORDER_MSG_PRICE_OFFSET, int32_t>();
+    }
+};
+
+// The participant id is not read, the view only keeps 'F' apart from 'A' for builders that handle the two differently.
+class AddOrderWithMPIDView : public AddOrderView {
+public:
+    explicit AddOrderWithMPIDView(const char* message)
+        : AddOrderView(message)
+    {
+    }
+
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    AddOrderWithMPIDView(const AddOrderWithMPID& message)
+        : AddOrderView(message)
+    {
+    }
+};
+
+class TradeView : public MessageView<Trade> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint64_t matchId() const
+    {
+        return field<constants::TRADE_MSG_MATCH_ID_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] char side() const
+    {
+        return field<constants::TRADE_MSG_SIDE_OFFSET, char>();
+    }
+
+    [[nodiscard]] uint64_t quantity() const
+    {
+        return field<constants::TRADE_MSG_QUANTITY_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return field<constants::TRADE_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] int32_t tradePrice() const
+    {
+        return field<constants::TRADE_MSG_TRADE_PRICE_OFFSET, int32_t>();
+    }
+
+    [[nodiscard]] bool printable() const
+    {
+        return field<constants::TRADE_MSG_PRINTABLE_OFFSET, char>() == static_cast<char>(algocor::Printable::Yes);
+    }
+};
+
+// Carries the seconds since midnight where other messages have their nanoseconds.
+class SecondsView : public MessageView<Seconds> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint32_t second() const
+    {
+        return field<algocor::TIMESTAMP_NANOSECONDS_OFFSET, uint32_t>();
+    }
+};
+
+class EquilibriumPriceUpdateView : public MessageView<EquilibriumPriceUpdate> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return field<constants::EQUILIBRIUM_PRICE_UPDATE_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] uint64_t availableBidQuantity() const
+    {
+        return field<constants::EQUILIBRIUM_PRICE_UPDATE_MSG_AVAILABLE_BID_QTY_EQUI_PX_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] uint64_t availableAskQuantity() const
+    {
+        return field<constants::EQUILIBRIUM_PRICE_UPDATE_MSG_AVAILABLE_ASK_QTY_EQUI_PX_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] int32_t equilibriumPrice() const
+    {
+        return field<constants::EQUILIBRIUM_PRICE_UPDATE_MSG_EQUI_PX_OFFSET, int32_t>();
+    }
+
+    [[nodiscard]] int32_t bestBidPrice() const
+    {
+        return field<constants::EQUILIBRIUM_PRICE_UPDATE_MSG_BEST_BID_PRICE_OFFSET, int32_t>();
+    }
+
+    [[nodiscard]] int32_t bestAskPrice() const
+    {
+        return field<constants::EQUILIBRIUM_PRICE_UPDATE_MSG_BEST_ASK_PRICE_OFFSET, int32_t>();
+    }
+
+    [[nodiscard]] uint64_t bestBidQuantity() const
+    {
+        return field<constants::EQUILIBRIUM_PRICE_UPDATE_MSG_BEST_BID_QTY_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] uint64_t bestAskQuantity() const
+    {
+        return field<constants::EQUILIBRIUM_PRICE_UPDATE_MSG_BEST_ASK_QTY_OFFSET, uint64_t>();
+    }
+};
+
+class OrderBookStateView : public MessageView<OrderBookState> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return field<constants::ORDERBOOK_STATE_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] std::string_view stateName() const
+    {
+        return text<constants::ORDERBOOK_STATE_MSG_STATE_NAME_OFFSET, constants::STATE_NAME_LENGTH>();
+    }
+};
+
+class OrderbookFlushView : public MessageView<OrderbookFlush> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return field<constants::ORDERBOOK_FLUSH_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+};
+
+// Only the fields the books are keyed and named by.
+class OrderBookDirectoryView : public MessageView<OrderBookDirectory> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return field<constants::ORDERBOOK_DIRECTORY_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] std::string_view symbol() const
+    {
+        return text<constants::ORDERBOOK_DIRECTORY_MSG_SYMBOL_OFFSET, constants::SYMBOL_LENGTH>();
+    }
+};
+
+class TickSizeTableEntryView : public MessageView<TickSizeTableEntry> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint32_t orderbookId() const
+    {
+        return field<constants::TICK_SIZE_MSG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] uint64_t tickSize() const
+    {
+        return field<constants::TICK_SIZE_MSG_TICK_SIZE_OFFSET, uint64_t>();
+    }
+
+    [[nodiscard]] int32_t priceFrom() const
+    {
+        return field<constants::TICK_SIZE_MSG_PRICE_FROM_OFFSET, int32_t>();
+    }
+
+    [[nodiscard]] int32_t priceTo() const
+    {
+        return field<constants::TICK_SIZE_MSG_PRICE_TO_OFFSET, int32_t>();
+    }
+};
+
+class CombinationOrderbookLegView : public MessageView<CombinationOrderbookLeg> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] uint32_t combinationOrderbookId() const
+    {
+        return field<constants::COMBO_ORDERBOOK_LEG_MSG_COMBO_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] uint32_t legOrderbookId() const
+    {
+        return field<constants::COMBO_ORDERBOOK_LEG_MSG_LEG_ORDERBOOK_ID_OFFSET, uint32_t>();
+    }
+
+    [[nodiscard]] algocor::LegSide legSide() const
+    {
+        return field<constants::COMBO_ORDERBOOK_LEG_MSG_LEG_SIDE_OFFSET, algocor::LegSide>();
+    }
+
+    [[nodiscard]] uint32_t legRatio() const
+    {
+        return field<constants::COMBO_ORDERBOOK_LEG_MSG_LEG_RATIO_OFFSET, uint32_t>();
+    }
+};
+
+class SystemEventView : public MessageView<SystemEvent> {
+public:
+    using MessageView::MessageView;
+
+    [[nodiscard]] algocor::EventCode eventCode() const
+    {
+        return field<constants::SYSTEM_EVENT_MSG_EVENT_CODE_OFFSET, algocor::EventCode>();
+    }
+};
+
+}  // namespace algocor::protocol::itch
@@ -1,23 +1,174 @@
 #pragma once
 #include "../core/orderbook_builder.hpp"
+#include "../core/subscription_filter.hpp"
 #include "../moldudp64/moldudp64_downstream_header.hpp"
 #include "../moldudp64/moldudp64_message_block.hpp"
 #include "itch_add_order.hpp"
+#include "itch_add_order_with_mpid.hpp"
+#include "itch_combination_orderbook_leg.hpp"
+#include "itch_equilibrium_price_update.hpp"
+#include "itch_message_view.hpp"
 #include "itch_order_delete.hpp"
 #include "itch_order_executed.hpp"
+#include "itch_order_executed_with_price.hpp"
+#include "itch_order_replace.hpp"
+#include "itch_orderbook_directory.hpp"
+#include "itch_orderbook_flush.hpp"
+#include "itch_orderbook_state.hpp"
+#include "itch_seconds.hpp"
+#include "itch_short_sell_status.hpp"
+#include "itch_system_event.hpp"
+#include "itch_tick_size_table_entry.hpp"
+#include "itch_trade.hpp"
 
 #include <array>
+#include <cstddef>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <utility>
 
 namespace algocor::protocol::itch
 {
 
+// Offset of the orderbook id in each message type that has one, 0 for the others.
+inline constexpr auto ORDERBOOK_ID_OFFSETS = []() {
+    std::array<uint8_t, 256> offsets {};
+    offsets['A'] = constants::ADD_ORDER_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['F'] = constants::ADD_ORDER_WITH_MPID_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['E'] = constants::ORDER_EXEC_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['C'] = constants::ORDER_EXEC_WITH_PX_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['D'] = constants::ORDER_DELETE_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['U'] = constants::REPLACE_ORDER_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['P'] = constants::TRADE_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['Y'] = constants::ORDERBOOK_FLUSH_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['R'] = constants::ORDERBOOK_DIRECTORY_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['M'] = constants::COMBO_ORDERBOOK_LEG_MSG_COMBO_ORDERBOOK_ID_OFFSET;
+    offsets['L'] = constants::TICK_SIZE_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['O'] = constants::ORDERBOOK_STATE_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['Z'] = constants::EQUILIBRIUM_PRICE_UPDATE_MSG_ORDERBOOK_ID_OFFSET;
+    offsets['V'] = constants::SHORT_SELL_MSG_ORDERBOOK_ID_OFFSET;
+    return offsets;
+}();
+
+// Orderbook id of a message with one, see ORDERBOOK_ID_OFFSETS.
+inline uint32_t orderbookIdOf(const char* message, uint8_t offset)
+{
+    uint32_t orderbook_id;
+    std::memcpy(&orderbook_id, message + offset, sizeof(orderbook_id));
+    return be32toh(orderbook_id);
+}
+
+// MoldUDP64 header fields of a packet. The header is packed, its sequence number is never aligned.
+inline uint64_t packetSequenceNumber(const char* packet)
+{
+    return networkToHost(loadNetworkOrder<offsetof(moldudp64::DownstreamHeader, sequence_number), uint64_t>(packet));
+}
+
+inline uint16_t packetMessageCount(const char* packet)
+{
+    return networkToHost(loadNetworkOrder<offsetof(moldudp64::DownstreamHeader, message_count), uint16_t>(packet));
+}
+
+// Length of the MoldUDP64 message block at `block`, without its length field. Blocks follow each other unaligned.
+inline uint16_t messageBlockLength(const char* block)
+{
+    return networkToHost(loadNetworkOrder<0, uint16_t>(block));
+}
+
+// Whether a message passes the subscriptions, messages without an orderbook id always do. Directory messages name their book first, so
+// a subscription by symbol covers the book from its announcement on.
+inline bool isSubscribed(algocor::SubscriptionFilter& subscriptions, const char* message)
+{
+    const auto offset = ORDERBOOK_ID_OFFSETS[static_cast<uint8_t>(message[0])];
+    if (offset == 0) {
+        return true;
+    }
+
+    const auto orderbook_id = orderbookIdOf(message, offset);
+    if (static_cast<MessageType>(message[0]) == MessageType::OrderbookDirectory) [[unlikely]] {
+        subscriptions.onDirectory(orderbook_id, OrderBookDirectoryView { message }.symbol());
+    }
+    return subscriptions.contains(orderbook_id);
+}
+
+// OrderbookFlush of a book that was unsubscribed, messages for it are filtered from then on and what it holds would go stale.
+inline OrderbookFlush unsubscribedFlush(uint32_t orderbook_id)
+{
+    OrderbookFlush flush {};
+    flush.type = MessageType::OrderbookFlush;
+    flush.orderbook_id = { htobe32(orderbook_id) };
+    return flush;
+}
+
+// Message type of each ITCH message the parser can apply, with the view the builder gets it as. Routes are tried in order, so they are
+// listed by how often the type shows up in a BIST equity session: order messages first, reference data and session events last.
+template<MessageType Type, typename MessageStruct>
+struct MessageRoute {
+    static constexpr MessageType TYPE = Type;
+    using Message = MessageStruct;
+};
+
+template<typename... Routes>
+struct MessageRouteList {};
+
+using MessageRoutes = MessageRouteList<MessageRoute<MessageType::AddOrder, AddOrderView>,
+    MessageRoute<MessageType::OrderDelete, OrderDeleteView>,
+    MessageRoute<MessageType::OrderExecuted, OrderExecutedView>,
+    MessageRoute<MessageType::OrderReplace, OrderReplaceView>,
+    MessageRoute<MessageType::OrderExecutedWithPrice, OrderExecutedWithPriceView>,
+    MessageRoute<MessageType::Trade, TradeView>,
+    MessageRoute<MessageType::Seconds, SecondsView>,
+    MessageRoute<MessageType::EquilibriumPriceUpdate, EquilibriumPriceUpdateView>,
+    MessageRoute<MessageType::AddOrderWithMPID, AddOrderWithMPIDView>,
+    MessageRoute<MessageType::OrderbookState, OrderBookStateView>,
+    MessageRoute<MessageType::OrderbookFlush, OrderbookFlushView>,
+    MessageRoute<MessageType::OrderbookDirectory, OrderBookDirectoryView>,
+    MessageRoute<MessageType::TickSizeTableEntry, TickSizeTableEntryView>,
+    MessageRoute<MessageType::CombinationOrderbookLeg, CombinationOrderbookLegView>,
+    MessageRoute<MessageType::SystemEvent, SystemEventView>>;
+
+static_assert(
+    []<typename... Routes>(MessageRouteList<Routes...>) {
+        const std::array types { Routes::TYPE... };
+        for (std::size_t i = 0; i < types.size(); ++i) {
+            for (std::size_t j = i + 1; j < types.size(); ++j) {
+                if (types[i] == types[j]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }(MessageRoutes {}),
+    "a message type is routed twice");
+
+// Order keys of the messages of one packet, one array per field, as gathered by the first pass of ItchParser's batch decode.
+struct ItchMessageBatch {
+    static constexpr std::size_t CAPACITY = 256;  // more than a full Ethernet frame carries, larger packets go in several rounds.
+
+    std::array<const char*, CAPACITY> messages;
+    std::array<uint64_t, CAPACITY> order_ids;
+    std::array<uint32_t, CAPACITY> orderbook_ids;
+    std::array<algocor::OrderbookRegistry::Index, CAPACITY> book_indexes;  // NO_BOOK for a book the builder did not have yet.
+    std::array<uint16_t, CAPACITY> indexes;  // in the packet, for the sequence number.
+    std::array<char, CAPACITY> sides;        // 0 for a message that does not refer to an order.
+    std::size_t size { 0 };
+};
+
 template<typename Builder>
 class ItchParser {
     Builder* m_builder;
     std::string m_session;
 
+    // Books outside the subscription never reach the builder, nullptr passes every book.
+    algocor::SubscriptionFilter* m_subscriptions { nullptr };
+    uint64_t m_filteredMessages { 0 };
+    std::size_t m_unsubscribedSeen { 0 };  // see SubscriptionFilter::unsubscribed().
+
+    // Scratch space of the batch decode, nullptr while messages are applied one at a time.
+    std::unique_ptr<ItchMessageBatch> m_batch;
+
 public:
     explicit ItchParser(Builder& builder)
         : m_builder(&builder)
@@ -34,9 +185,11 @@ public:
 
         m_session = toStringSession(header->session);
 
-        parsePayload(byte_array + sizeof(*header), be16toh(header->message_count), be64toh(header->sequence_number));
+        const auto sequence_number = packetSequenceNumber(byte_array);
+        const auto message_count = packetMessageCount(byte_array);
+        parsePayload(byte_array + sizeof(*header), message_count, sequence_number);
 
-        return { be64toh(header->sequence_number), be16toh(header->message_count) };
+        return { sequence_number, message_count };
     }
 
     const std::string& getSession() const
@@ -44,46 +197,351 @@ public:
         return m_session;
     }
 
+    void setSubscriptions(algocor::SubscriptionFilter* subscriptions)
+    {
+        m_subscriptions = subscriptions;
+        m_unsubscribedSeen = subscriptions != nullptr ? subscriptions->unsubscribed() : 0;
+    }
+
+    // Decodes each packet in two passes, see parseBatch(). Pays off when the order index does not fit in cache and packets carry many
+    // messages.
+    void setBatchDecode(bool enabled)
+    {
+        m_batch = enabled ? std::make_unique<ItchMessageBatch>() : nullptr;
+    }
+
+    // Messages of unsubscribed books dropped so far.
+    uint64_t filteredMessages() const
+    {
+        return m_filteredMessages;
+    }
+
+    // Applies one ITCH message, `sequence_number` is its MoldUDP64 sequence number.
+    void parseMessage(const char* message, uint64_t sequence_number)
+    {
+        dispatch(MessageRoutes {}, static_cast<MessageType>(message[0]), message, sequence_number);
+    }
+
+    // Same for an order message whose book was looked up in the builder's registry ahead, the builder gets its index along.
+    void parseMessage(const char* message, uint64_t sequence_number, algocor::OrderbookRegistry::Index book_index)
+    {
+        dispatch(MessageRoutes {}, static_cast<MessageType>(message[0]), message, sequence_number, book_index);
+    }
+
     void parsePayload(const char* payload, uint16_t message_count, uint64_t sequence_number)
     {
+        if (m_subscriptions != nullptr && m_subscriptions->unsubscribed() != m_unsubscribedSeen) [[unlikely]] {
+            flushUnsubscribed(sequence_number - 1);
+        }
+        if (m_batch != nullptr) {
+            parseBatch(payload, message_count, sequence_number);
+            return;
+        }
+
         uint32_t offset = 0;
         for (uint32_t i = 0; i < message_count; ++i) {
             const auto* block = reinterpret_cast<const moldudp64::MessageBlock*>(payload + offset);
-            offset += be16toh(block->length) + sizeof(block->length);
-
-            switch (static_cast<MessageType>(block->data[0])) {
-                case MessageType::AddOrder:
-                    handleOrderAdd(reinterpret_cast<const AddOrder*>(block->data));
-                    break;
-                case MessageType::OrderExecuted:
-                    handleOrderExecution(reinterpret_cast<const OrderExecuted*>(block->data));
-                    break;
-                case MessageType::OrderDelete:
-                    handleOrderDelete(reinterpret_cast<const OrderDelete*>(block->data));
-                    break;
-                default:
-                    break;  // other types ignored
+            offset += messageBlockLength(payload + offset) + sizeof(block->length);
+
+            if (i + 1 < message_count) {
+                prefetchOrder(reinterpret_cast<const moldudp64::MessageBlock*>(payload + offset));
             }
+
+            if (m_subscriptions != nullptr && !isSubscribed(*m_subscriptions, block->data)) {
+                ++m_filteredMessages;
+                continue;
+            }
+
+            parseMessage(block->data, sequence_number + i);
         }
     }
 
 private:
-    void handleOrderAdd(const AddOrder* order_add)
+    // Empties the books unsubscribed since the last packet through the builder's OrderbookFlush path, as of the last message applied.
+    void flushUnsubscribed(uint64_t sequence_number)
+    {
+        m_unsubscribedSeen = m_subscriptions->forEachUnsubscribed(m_unsubscribedSeen, [&](uint32_t orderbook_id) {
+            const auto flush = unsubscribedFlush(orderbook_id);
+            parseMessage(reinterpret_cast<const char*>(&flush), sequence_number);
+        });
+    }
+
+    // The first pass walks the message blocks and gathers the order keys of the packet into the batch, swapping them to host order
+    // in one loop over each array, and looks their books up in the builder's registry. The second starts loading the index slot of
+    // every order before the messages are applied in order, so the cache misses of the whole packet overlap instead of those of one
+    // message at a time. Messages take their book index along, the builder does not look it up again; a book an add of the same
+    // round creates is looked up when its messages are applied.
+    void parseBatch(const char* payload, uint16_t message_count, uint64_t sequence_number)
+    {
+        static_assert(constants::ADD_ORDER_MSG_ORDER_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDER_ID_OFFSET
+            && constants::ADD_ORDER_MSG_ORDERBOOK_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDERBOOK_ID_OFFSET
+            && constants::ADD_ORDER_MSG_SIDE_OFFSET == constants::ORDER_DELETE_MSG_SIDE_OFFSET
+            && constants::ADD_ORDER_WITH_MPID_MSG_ORDER_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDER_ID_OFFSET
+            && constants::ADD_ORDER_WITH_MPID_MSG_ORDERBOOK_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDERBOOK_ID_OFFSET
+            && constants::ADD_ORDER_WITH_MPID_MSG_SIDE_OFFSET == constants::ORDER_DELETE_MSG_SIDE_OFFSET);
+
+        auto& batch = *m_batch;
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < message_count;) {
+            batch.size = 0;
+            for (; i < message_count && batch.size < ItchMessageBatch::CAPACITY; ++i) {
+                const auto* block = reinterpret_cast<const moldudp64::MessageBlock*>(payload + offset);
+                offset += static_cast<uint32_t>(messageBlockLength(payload + offset) + sizeof(block->length));
+                if (m_subscriptions != nullptr && !isSubscribed(*m_subscriptions, block->data)) {
+                    ++m_filteredMessages;
+                    continue;
+                }
+
+                const auto* message = block->data;
+                const auto event = batch.size++;
+                batch.messages[event] = message;
+                batch.indexes[event] = static_cast<uint16_t>(i);
+                switch (static_cast<MessageType>(message[0])) {
+                    case MessageType::AddOrder:
+                    case MessageType::AddOrderWithMPID:
+                    case MessageType::OrderExecuted:
+                    case MessageType::OrderExecutedWithPrice:
+                    case MessageType::OrderDelete:
+                    case MessageType::OrderReplace:
+                        batch.order_ids[event] = loadNetworkOrder<constants::ORDER_DELETE_MSG_ORDER_ID_OFFSET, uint64_t>(message);
+                        batch.orderbook_ids[event] = loadNetworkOrder<constants::ORDER_DELETE_MSG_ORDERBOOK_ID_OFFSET, uint32_t>(message);
+                        batch.sides[event] = message[constants::ORDER_DELETE_MSG_SIDE_OFFSET];
+                        break;
+                    default:
+                        batch.order_ids[event] = 0;
+                        batch.orderbook_ids[event] = 0;
+                        batch.sides[event] = 0;
+                        break;
+                }
+            }
+
+            for (std::size_t event = 0; event < batch.size; ++event) {
+                batch.order_ids[event] = networkToHost(batch.order_ids[event]);
+                batch.orderbook_ids[event] = networkToHost(batch.orderbook_ids[event]);
+            }
+
+            for (std::size_t event = 0; event < batch.size; ++event) {
+                batch.book_indexes[event] = algocor::OrderbookRegistry::NO_BOOK;
+                if constexpr (requires { m_builder->registry().find(uint32_t {}); }) {
+                    if (batch.sides[event] != 0) {
+                        batch.book_indexes[event] = m_builder->registry().find(batch.orderbook_ids[event]);
+                    }
+                }
+            }
+
+            if constexpr (requires { m_builder->prefetchOrder(algocor::OrderbookRegistry::Index {}, uint32_t {}, uint64_t {}, char {}); }) {
+                for (std::size_t event = 0; event < batch.size; ++event) {
+                    if (batch.book_indexes[event] != algocor::OrderbookRegistry::NO_BOOK) {
+                        m_builder->prefetchOrder(
+                            batch.book_indexes[event], batch.orderbook_ids[event], batch.order_ids[event], batch.sides[event]);
+                    }
+                }
+            } else if constexpr (requires { m_builder->prefetchOrder(uint32_t {}, uint64_t {}, char {}); }) {
+                for (std::size_t event = 0; event < batch.size; ++event) {
+                    if (batch.sides[event] != 0) {
+                        m_builder->prefetchOrder(batch.orderbook_ids[event], batch.order_ids[event], batch.sides[event]);
+                    }
+                }
+            }
+
+            for (std::size_t event = 0; event < batch.size; ++event) {
+                const auto book_index = batch.book_indexes[event];
+                if (book_index != algocor::OrderbookRegistry::NO_BOOK) {
+                    parseMessage(batch.messages[event], sequence_number + batch.indexes[event], book_index);
+                } else {
+                    parseMessage(batch.messages[event], sequence_number + batch.indexes[event]);
+                }
+            }
+        }
+    }
+
+    // Starts loading the order the next message refers to while the current one is applied. Executions (with or without price),
+    // deletes and replaces carry order id, orderbook id and side at the same offsets.
+    void prefetchOrder(const moldudp64::MessageBlock* next)
+    {
+        static_assert(constants::ORDER_EXEC_MSG_ORDER_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDER_ID_OFFSET
+            && constants::ORDER_EXEC_MSG_ORDERBOOK_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDERBOOK_ID_OFFSET
+            && constants::ORDER_EXEC_MSG_SIDE_OFFSET == constants::ORDER_DELETE_MSG_SIDE_OFFSET
+            && constants::REPLACE_ORDER_MSG_ORDER_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDER_ID_OFFSET
+            && constants::REPLACE_ORDER_MSG_ORDERBOOK_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDERBOOK_ID_OFFSET
+            && constants::REPLACE_ORDER_MSG_SIDE_OFFSET == constants::ORDER_DELETE_MSG_SIDE_OFFSET
+            && constants::ORDER_EXEC_WITH_PX_MSG_ORDER_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDER_ID_OFFSET
+            && constants::ORDER_EXEC_WITH_PX_MSG_ORDERBOOK_ID_OFFSET == constants::ORDER_DELETE_MSG_ORDERBOOK_ID_OFFSET
+            && constants::ORDER_EXEC_WITH_PX_MSG_SIDE_OFFSET == constants::ORDER_DELETE_MSG_SIDE_OFFSET);
+
+        if constexpr (requires { m_builder->prefetchOrder(uint32_t {}, uint64_t {}, char {}); }) {
+            const auto type = static_cast<MessageType>(next->data[0]);
+            if (type == MessageType::OrderExecuted || type == MessageType::OrderExecutedWithPrice || type == MessageType::OrderDelete
+                || type == MessageType::OrderReplace) {
+                const OrderDeleteView order { next->data };
+                m_builder->prefetchOrder(order.orderbookId(), order.orderId(), order.side());
+            }
+        }
+    }
+
+    // Tries the routes in order and applies the message with the first one matching its type. Routes of messages the builder does
+    // not handle are compiled out, such messages fall through the chain without touching the builder. A book index, when given, goes
+    // to the builder with the messages it has an index taking handler for.
+    template<typename... Routes, typename... Indexes>
+    void dispatch(MessageRouteList<Routes...>, MessageType type, const char* message, uint64_t sequence_number, Indexes... book_index)
+    {
+        static_cast<void>((tryRoute<Routes>(type, message, sequence_number, book_index...) || ...));
+    }
+
+    template<typename Route, typename... Indexes>
+    bool tryRoute(MessageType type, const char* message, uint64_t sequence_number, Indexes... book_index)
+    {
+        using Message = typename Route::Message;
+        if constexpr (requires(const Message& decoded) { apply(decoded); }) {
+            if (type == Route::TYPE) {
+                if constexpr (requires { m_builder->setSequence(sequence_number); }) {
+                    m_builder->setSequence(sequence_number);
+                }
+                applyWithBook(Message { message }, book_index...);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<typename Message, typename... Indexes>
+    void applyWithBook(const Message& message, Indexes... book_index)
+    {
+        if constexpr (requires { apply(message, book_index...); }) {
+            apply(message, book_index...);
+        } else {
+            apply(message);
+        }
+    }
+
+    // Builder call of each message type. Adds, executions and deletes are required; a builder without the member for one of the others
+    // does not get that message.
+    void apply(AddOrderView order_add)
+    {
+        m_builder->addOrder(order_add);
+    }
+
+    void apply(OrderExecutedView order_executed)
+    {
+        m_builder->executeOrder(order_executed);
+    }
+
+    void apply(OrderDeleteView order_delete)
+    {
+        m_builder->deleteOrder(order_delete);
+    }
+
+    void apply(OrderReplaceView order_replace)
+        requires requires(Builder& builder, OrderReplaceView message) { builder.replaceOrder(message); }
+    {
+        m_builder->replaceOrder(order_replace);
+    }
+
+    void apply(AddOrderWithMPIDView order_add)
+        requires requires(Builder& builder, AddOrderWithMPIDView message) { builder.addOrderWithMPID(message); }
+    {
+        m_builder->addOrderWithMPID(order_add);
+    }
+
+    void apply(OrderExecutedWithPriceView order_executed)
+        requires requires(Builder& builder, OrderExecutedWithPriceView message) { builder.executeOrderWithPrice(message); }
+    {
+        m_builder->executeOrderWithPrice(order_executed);
+    }
+
+    // Order messages with the registry index of their book, for builders with index taking handlers.
+    using BookIndex = algocor::OrderbookRegistry::Index;
+
+    void apply(AddOrderView order_add, BookIndex book_index)
+        requires requires(Builder& builder, AddOrderView message, BookIndex index) { builder.addOrder(message, index); }
+    {
+        m_builder->addOrder(order_add, book_index);
+    }
+
+    void apply(OrderExecutedView order_executed, BookIndex book_index)
+        requires requires(Builder& builder, OrderExecutedView message, BookIndex index) { builder.executeOrder(message, index); }
+    {
+        m_builder->executeOrder(order_executed, book_index);
+    }
+
+    void apply(OrderDeleteView order_delete, BookIndex book_index)
+        requires requires(Builder& builder, OrderDeleteView message, BookIndex index) { builder.deleteOrder(message, index); }
+    {
+        m_builder->deleteOrder(order_delete, book_index);
+    }
+
+    void apply(OrderReplaceView order_replace, BookIndex book_index)
+        requires requires(Builder& builder, OrderReplaceView message, BookIndex index) { builder.replaceOrder(message, index); }
+    {
+        m_builder->replaceOrder(order_replace, book_index);
+    }
+
+    void apply(AddOrderWithMPIDView order_add, BookIndex book_index)
+        requires requires(Builder& builder, AddOrderWithMPIDView message, BookIndex index) { builder.addOrderWithMPID(message, index); }
+    {
+        m_builder->addOrderWithMPID(order_add, book_index);
+    }
+
+    void apply(OrderExecutedWithPriceView order_executed, BookIndex book_index)
+        requires requires(Builder& builder, OrderExecutedWithPriceView message, BookIndex index) {
+            builder.executeOrderWithPrice(message, index);
+        }
+    {
+        m_builder->executeOrderWithPrice(order_executed, book_index);
+    }
+
+    void apply(TradeView trade)
+        requires requires(Builder& builder, TradeView message) { builder.trade(message); }
+    {
+        m_builder->trade(trade);
+    }
+
+    void apply(OrderBookDirectoryView directory)
+        requires requires(Builder& builder, OrderBookDirectoryView message) { builder.orderbookDirectory(message); }
+    {
+        m_builder->orderbookDirectory(directory);
+    }
+
+    void apply(OrderbookFlushView flush)
+        requires requires(Builder& builder, OrderbookFlushView message) { builder.flushOrderbook(message); }
+    {
+        m_builder->flushOrderbook(flush);
+    }
+
+    void apply(TickSizeTableEntryView entry)
+        requires requires(Builder& builder, TickSizeTableEntryView message) { builder.tickSizeTableEntry(message); }
+    {
+        m_builder->tickSizeTableEntry(entry);
+    }
+
+    void apply(CombinationOrderbookLegView leg)
+        requires requires(Builder& builder, CombinationOrderbookLegView message) { builder.combinationOrderbookLeg(message); }
+    {
+        m_builder->combinationOrderbookLeg(leg);
+    }
+
+    void apply(OrderBookStateView state)
+        requires requires(Builder& builder, OrderBookStateView message) { builder.orderbookState(message); }
+    {
+        m_builder->orderbookState(state);
+    }
+
+    void apply(EquilibriumPriceUpdateView update)
+        requires requires(Builder& builder, EquilibriumPriceUpdateView message) { builder.equilibriumPriceUpdate(message); }
     {
-        if (m_builder)
-            m_builder->addOrder(*order_add);
+        m_builder->equilibriumPriceUpdate(update);
     }
 
-    void handleOrderExecution(const OrderExecuted* order_executed)
+    void apply(SystemEventView event)
+        requires requires(Builder& builder, SystemEventView message) { builder.systemEvent(message); }
     {
-        if (m_builder)
-            m_builder->executeOrder(*order_executed);
+        m_builder->systemEvent(event);
     }
 
-    void handleOrderDelete(const OrderDelete* order_delete)
+    void apply(SecondsView seconds)
+        requires requires(Builder& builder, SecondsView message) { builder.seconds(message); }
     {
-        if (m_builder)
-            m_builder->deleteOrder(*order_delete);
+        m_builder->seconds(seconds);
     }
 
     // Helper
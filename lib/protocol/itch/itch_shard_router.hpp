@@ -0,0 +1,280 @@
+#pragma once
+#include "../../utility/message_ring.hpp"
+#include "../../utility/thread.hpp"
+#include "../core/subscription_filter.hpp"
+#include "../moldudp64/moldudp64_downstream_header.hpp"
+#include "../moldudp64/moldudp64_message_block.hpp"
+#include "itch_parser.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace algocor::protocol::itch
+{
+
+// Sharded market data: the receive thread only splits packets into messages and routes each by orderbook id to one of N book workers,
+// each with its own builder, parser and pinned thread. A book always lands on the same shard, so its messages are applied in feed
+// order. Messages without an orderbook id (Seconds, system events) go to every shard.
+//
+// Combination orderbooks are not supported: a combination and its legs hash to different shards, and no builder would see the quotes
+// of them all. CombinationOrderbookLeg messages are dropped with an error instead of leaving implied prices that never get a value.
+//
+// Every shard publishes a watermark, the sequence number up to which it has applied everything routed to it. Shards that got nothing
+// from a packet are still moved on to its last sequence number, so a quiet shard does not look behind.
+//
+// Level storage is thread local (see LevelArena::local()), so a shard's books live and die on its worker: read them while the shards
+// run, stop() destroys each builder on its own thread before joining it.
+template<typename Builder, std::size_t RingLines = (1 << 14)>
+class ItchShardRouter {
+public:
+    using Ring = algocor::MessageRing<RingLines>;
+
+private:
+    struct Shard {
+        Ring ring;
+        std::optional<Builder> builder { std::in_place };
+        ItchParser<Builder> parser { *builder };
+        alignas(64) std::atomic<uint64_t> watermark { 0 };
+        uint64_t routed { 0 };  // last sequence number pushed, receive thread only.
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::atomic<bool> m_running { false };
+    std::string m_session;
+
+    algocor::SubscriptionFilter* m_subscriptions { nullptr };
+    uint64_t m_filteredMessages { 0 };
+    std::size_t m_unsubscribedSeen { 0 };  // see SubscriptionFilter::unsubscribed().
+    uint64_t m_droppedLegs { 0 };
+
+    void workerLoop(Shard& shard, std::size_t index, int core)
+    {
+        setThreadName("book_shard_" + std::to_string(index));
+        if (core >= 0 && !pinThreadToCore(core)) {
+            LOG_WARNING("Book shard {} runs unpinned", index);
+        }
+
+        while (m_running.load(std::memory_order_relaxed)) {
+            if (drainShard(shard) == 0) {
+                __builtin_ia32_pause();
+            }
+        }
+        drainShard(shard);
+        shard.builder.reset();
+    }
+
+    static std::size_t drainShard(Shard& shard)
+    {
+        uint64_t last = 0;
+        const auto count = shard.ring.drain([&](uint64_t sequence, const char* message, uint16_t length) {
+            if (length != 0) {
+                shard.parser.parseMessage(message, sequence);
+            }
+            last = sequence;
+        });
+        if (count != 0) {
+            shard.watermark.store(last, std::memory_order_release);
+        }
+        return count;
+    }
+
+    void dropCombinationLeg()
+    {
+        if (m_droppedLegs++ == 0) {
+            LOG_ERROR("Feed carries combination orderbooks, their implied prices need every leg on one builder: run the partition without "
+                      "book_shard_cpus to keep them");
+        }
+    }
+
+public:
+    explicit ItchShardRouter(std::size_t shard_count)
+    {
+        EXPECT(shard_count != 0);
+        for (std::size_t index = 0; index < shard_count; ++index) {
+            m_shards.push_back(std::make_unique<Shard>());
+        }
+    }
+
+    ItchShardRouter(const ItchShardRouter&) = delete;
+    ItchShardRouter& operator=(const ItchShardRouter&) = delete;
+
+    ~ItchShardRouter()
+    {
+        stop();
+    }
+
+    // One worker thread per shard, pinned to cores[shard] when given.
+    void start(const std::vector<int>& cores = {})
+    {
+        if (m_running.exchange(true)) {
+            LOG_WARNING("Book shards already running");
+            return;
+        }
+        for (std::size_t index = 0; index < m_shards.size(); ++index) {
+            auto& shard = *m_shards[index];
+            const auto core = index < cores.size() ? cores[index] : -1;
+            shard.thread = std::thread([this, &shard, index, core]() { workerLoop(shard, index, core); });
+        }
+    }
+
+    // Applies what is still queued, destroys the builders and joins the workers.
+    void stop()
+    {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+        for (auto& shard : m_shards) {
+            if (shard->thread.joinable()) {
+                shard->thread.join();
+            }
+        }
+    }
+
+    // Same contract as ItchParser::parse(), the messages are applied later on the shard threads.
+    std::pair<uint64_t, uint16_t> parse(const char* byte_array, size_t size)
+    {
+        LOG_TRACE_L3("Routing market data of size {}", size);
+
+        const auto* header = reinterpret_cast<const moldudp64::DownstreamHeader*>(byte_array);
+        const auto sequence_number = packetSequenceNumber(byte_array);
+        const auto message_count = packetMessageCount(byte_array);
+
+        m_session.assign(header->session.begin(), header->session.end());
+        routePayload(byte_array + sizeof(*header), message_count, sequence_number);
+
+        return { sequence_number, message_count };
+    }
+
+    void routePayload(const char* payload, uint16_t message_count, uint64_t sequence_number)
+    {
+        // Books unsubscribed since the last packet are flushed on their shard, see ItchParser::flushUnsubscribed().
+        if (m_subscriptions != nullptr && m_subscriptions->unsubscribed() != m_unsubscribedSeen) [[unlikely]] {
+            m_unsubscribedSeen = m_subscriptions->forEachUnsubscribed(m_unsubscribedSeen, [&](uint32_t orderbook_id) {
+                const auto flush = unsubscribedFlush(orderbook_id);
+                auto& shard = *m_shards[shardOf(orderbook_id)];
+                shard.ring.push(shard.routed, reinterpret_cast<const char*>(&flush), sizeof(flush));
+            });
+        }
+
+        uint32_t offset = 0;
+        for (uint32_t i = 0; i < message_count; ++i) {
+            const auto* block = reinterpret_cast<const moldudp64::MessageBlock*>(payload + offset);
+            const auto length = messageBlockLength(payload + offset);
+            offset += static_cast<uint32_t>(length + sizeof(block->length));
+
+            if (m_subscriptions != nullptr && !isSubscribed(*m_subscriptions, block->data)) {
+                ++m_filteredMessages;
+                continue;
+            }
+            if (length > Ring::MAX_MESSAGE_BYTES) [[unlikely]] {
+                LOG_ERROR("ITCH message type {} of {} bytes does not fit a shard ring, dropped", block->data[0], length);
+                continue;
+            }
+
+            if (static_cast<MessageType>(block->data[0]) == MessageType::CombinationOrderbookLeg) [[unlikely]] {
+                dropCombinationLeg();
+                continue;
+            }
+
+            const auto id_offset = ORDERBOOK_ID_OFFSETS[static_cast<uint8_t>(block->data[0])];
+            if (id_offset != 0) [[likely]] {
+                auto& shard = *m_shards[shardOf(orderbookIdOf(block->data, id_offset))];
+                shard.ring.push(sequence_number + i, block->data, length);
+                shard.routed = sequence_number + i;
+            } else {
+                for (auto& shard : m_shards) {
+                    shard->ring.push(sequence_number + i, block->data, length);
+                    shard->routed = sequence_number + i;
+                }
+            }
+        }
+
+        // Every shard has seen the whole packet, a bare mark moves on the ones it did not end on.
+        const auto last = sequence_number + message_count - 1;
+        for (auto& shard : m_shards) {
+            if (message_count != 0 && shard->routed != last) {
+                shard->ring.push(last, nullptr, 0);
+                shard->routed = last;
+            }
+            shard->ring.publish();
+        }
+    }
+
+    [[nodiscard]] std::size_t shardOf(uint32_t orderbook_id) const
+    {
+        // Fibonacci hashing spreads consecutive ids over the shards.
+        return (static_cast<uint64_t>(orderbook_id * 0x9E3779B9U) * m_shards.size()) >> 32;
+    }
+
+    [[nodiscard]] std::size_t shardCount() const
+    {
+        return m_shards.size();
+    }
+
+    // Sequence number up to which the shard has applied everything routed to it, safe to read from any thread.
+    [[nodiscard]] uint64_t watermark(std::size_t shard) const
+    {
+        return m_shards[shard]->watermark.load(std::memory_order_acquire);
+    }
+
+    // Lowest watermark over the shards: every message up to it is in the books.
+    [[nodiscard]] uint64_t watermark() const
+    {
+        auto lowest = UINT64_MAX;
+        for (std::size_t shard = 0; shard < m_shards.size(); ++shard) {
+            lowest = std::min(lowest, watermark(shard));
+        }
+        return lowest;
+    }
+
+    // The builder of one shard, its books are owned by the shard thread: read them through snapshots and book events. nullptr after
+    // stop(), when the worker has destroyed it.
+    Builder* builder(std::size_t shard)
+    {
+        auto& builder = m_shards[shard]->builder;
+        return builder.has_value() ? &*builder : nullptr;
+    }
+
+    const std::string& getSession() const
+    {
+        return m_session;
+    }
+
+    void setSubscriptions(algocor::SubscriptionFilter* subscriptions)
+    {
+        m_subscriptions = subscriptions;
+        m_unsubscribedSeen = subscriptions != nullptr ? subscriptions->unsubscribed() : 0;
+    }
+
+    uint64_t filteredMessages() const
+    {
+        return m_filteredMessages;
+    }
+
+    // CombinationOrderbookLeg messages dropped, see the class comment.
+    uint64_t droppedCombinationLegs() const
+    {
+        return m_droppedLegs;
+    }
+
+    // Times the receive thread waited for a shard to make room.
+    uint64_t stalls() const
+    {
+        uint64_t stalls = 0;
+        for (const auto& shard : m_shards) {
+            stalls += shard->ring.stalls();
+        }
+        return stalls;
+    }
+};
+
+}  // namespace algocor::protocol::itch
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <fmt/core.h>
 #include <fstream>
@@ -25,6 +26,29 @@ struct MarketDataPartitionConfig {
     uint16_t unicast_destination_port;
     int cpu;
 
+    // Books to build, by symbol or orderbook id. Without a "subscriptions" entry every book of the partition is built.
+    bool subscriptions_enabled { false };
+    std::vector<std::string> subscribed_symbols;
+    std::vector<uint32_t> subscribed_orderbook_ids;
+
+    // Cores of the book workers in sharded mode, empty to build the books on the receive thread.
+    std::vector<int> book_shard_cpus;
+
+    // Decode each packet in two passes before applying it, see ItchParser::setBatchDecode(). Books built on the receive thread only.
+    bool batch_decode { false };
+
+    // Live orders the order index of each book is sized for when the book is registered, see
+    // OrderbookBuilder::setBookOrderReserve(). Without a "book_order_reserve" entry it follows the instrument type: equity books are
+    // few and deep, derivative partitions carry many thin books.
+    static constexpr std::size_t EQUITY_BOOK_ORDERS = 1024;
+    static constexpr std::size_t DERIVATIVE_BOOK_ORDERS = 128;
+    std::size_t book_order_reserve { 0 };
+
+    // Shadow verification of the books on a low priority thread, see algocor::BookVerifier. Every thread that builds books gets its own
+    // verifier, all of them run on `verifier_cpu`, -1 leaves them unpinned.
+    bool verifier_enabled { false };
+    int verifier_cpu { -1 };
+
     [[nodiscard]] std::string toString() const
     {
         return fmt::format("Name: {}, Type: {}, Multicast IP: {}, Multicast Port: {}, "
@@ -244,6 +268,43 @@ private:
             config.unicast_destination_port = partition["unicast_destination_port"];
             config.cpu = partition["cpu"];
 
+            if (partition.contains("subscriptions")) {
+                const auto& subscriptions = partition["subscriptions"];
+                config.subscriptions_enabled = true;
+                if (subscriptions.contains("symbols")) {
+                    config.subscribed_symbols = subscriptions["symbols"].get<std::vector<std::string>>();
+                }
+                if (subscriptions.contains("orderbook_ids")) {
+                    config.subscribed_orderbook_ids = subscriptions["orderbook_ids"].get<std::vector<uint32_t>>();
+                }
+                LOG_INFO("Partition {} subscribes to {} symbols and {} orderbook ids",
+                    config.name,
+                    config.subscribed_symbols.size(),
+                    config.subscribed_orderbook_ids.size());
+            }
+
+            if (partition.contains("book_shard_cpus")) {
+                config.book_shard_cpus = partition["book_shard_cpus"].get<std::vector<int>>();
+            }
+            if (partition.contains("batch_decode")) {
+                config.batch_decode = partition["batch_decode"].get<bool>();
+            }
+            config.book_order_reserve = type == MarketDataPartitionConfig::InstrumentType::Equity
+                ? MarketDataPartitionConfig::EQUITY_BOOK_ORDERS
+                : MarketDataPartitionConfig::DERIVATIVE_BOOK_ORDERS;
+            if (partition.contains("book_order_reserve")) {
+                config.book_order_reserve = partition["book_order_reserve"].get<std::size_t>();
+            }
+            if (partition.contains("verifier")) {
+                const auto& verifier = partition["verifier"];
+                if (verifier.contains("enabled")) {
+                    config.verifier_enabled = verifier["enabled"].get<bool>();
+                }
+                if (verifier.contains("cpu")) {
+                    config.verifier_cpu = verifier["cpu"].get<int>();
+                }
+            }
+
             m_marketDataConfig.partition_configs.push_back(config);
         }
         return true;
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace algocor
+{
+
+// Single producer / single consumer ring of variable length messages, each stored with a sequence number in whole cache lines. Unlike
+// SpscRing the producer waits for room instead of dropping: a book update that is lost cannot be recovered downstream. Messages
+// written with push() become visible to the consumer on publish(), so a packet is handed over with one release store.
+template<std::size_t Lines = (1 << 14)>
+class MessageRing {
+    static_assert((Lines & (Lines - 1)) == 0, "capacity must be a power of two");
+
+public:
+    static constexpr std::size_t LINE_BYTES = 64;
+    static constexpr std::size_t HEADER_BYTES = sizeof(uint64_t) + sizeof(uint16_t);  // sequence, length.
+    static constexpr std::size_t MAX_MESSAGE_BYTES = 4 * LINE_BYTES - HEADER_BYTES;
+
+private:
+    struct alignas(LINE_BYTES) Line {
+        std::array<char, LINE_BYTES> bytes;
+    };
+
+    alignas(64) std::atomic<uint64_t> m_head { 0 };  // lines published, owned by the producer.
+    alignas(64) std::atomic<uint64_t> m_tail { 0 };  // lines consumed, owned by the consumer.
+    alignas(64) uint64_t m_pending { 0 };            // lines written but not yet published.
+    uint64_t m_tailCache { 0 };
+    uint64_t m_stalls { 0 };
+    std::unique_ptr<Line[]> m_lines { new Line[Lines] };
+
+    static std::size_t linesFor(std::size_t length)
+    {
+        return (HEADER_BYTES + length + LINE_BYTES - 1) / LINE_BYTES;
+    }
+
+    char* lineAt(uint64_t index) const
+    {
+        return m_lines[index & (Lines - 1)].bytes.data();
+    }
+
+public:
+    // Waits while the consumer is a full ring behind. `length` is at most MAX_MESSAGE_BYTES, 0 for a bare sequence mark.
+    void push(uint64_t sequence, const char* data, uint16_t length)
+    {
+        const auto lines = linesFor(length);
+        if (m_pending + lines - m_tailCache > Lines) [[unlikely]] {
+            // Publish what is written so far, the consumer may be waiting for it.
+            publish();
+            while (m_pending + lines - (m_tailCache = m_tail.load(std::memory_order_acquire)) > Lines) {
+                ++m_stalls;
+                __builtin_ia32_pause();
+            }
+        }
+
+        std::array<char, 4 * LINE_BYTES> record;
+        std::memcpy(record.data(), &sequence, sizeof(sequence));
+        std::memcpy(record.data() + sizeof(sequence), &length, sizeof(length));
+        if (length != 0) {
+            std::memcpy(record.data() + HEADER_BYTES, data, length);
+        }
+        for (std::size_t line = 0; line < lines; ++line) {
+            std::memcpy(lineAt(m_pending + line), record.data() + line * LINE_BYTES, LINE_BYTES);
+        }
+        m_pending += lines;
+    }
+
+    void publish()
+    {
+        m_head.store(m_pending, std::memory_order_release);
+    }
+
+    // Calls func(uint64_t sequence, const char* data, uint16_t length) for every published message, returns how many were consumed.
+    template<typename Func>
+    std::size_t drain(Func&& func)
+    {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        const auto head = m_head.load(std::memory_order_acquire);
+
+        std::size_t count = 0;
+        std::array<char, 4 * LINE_BYTES> record;
+        while (tail != head) {
+            const char* line = lineAt(tail);
+            uint64_t sequence;
+            uint16_t length;
+            std::memcpy(&sequence, line, sizeof(sequence));
+            std::memcpy(&length, line + sizeof(sequence), sizeof(length));
+
+            const auto lines = linesFor(length);
+            if ((tail & (Lines - 1)) + lines > Lines) [[unlikely]] {
+                // Wraps around the end of the ring, copied together first.
+                for (std::size_t part = 0; part < lines; ++part) {
+                    std::memcpy(record.data() + part * LINE_BYTES, lineAt(tail + part), LINE_BYTES);
+                }
+                line = record.data();
+            }
+            func(sequence, line + HEADER_BYTES, length);
+            tail += lines;
+            ++count;
+        }
+        m_tail.store(tail, std::memory_order_release);
+        return count;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+
+    // Times the producer found the ring full, producer side only.
+    [[nodiscard]] uint64_t stalls() const
+    {
+        return m_stalls;
+    }
+};
+
+}  // namespace algocor
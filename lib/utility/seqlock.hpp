@@ -0,0 +1,78 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace algocor
+{
+
+// Single writer, any number of readers. The writer bumps the version to odd, copies the value and bumps it back to even; it never waits.
+// A reader copies the value between two reads of the version and retries if they differ or are odd. The value is copied as relaxed
+// atomic words so a torn read is detected rather than being a data race.
+template<typename T>
+class alignas(64) Seqlock {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(sizeof(T) % sizeof(uint64_t) == 0 && alignof(T) <= alignof(uint64_t), "copied as 64-bit words");
+
+    static constexpr std::size_t WORDS = sizeof(T) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> m_version { 0 };
+    std::array<std::atomic<uint64_t>, WORDS> m_words {};
+
+public:
+    void store(const T& value)
+    {
+        std::array<uint64_t, WORDS> words;
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const auto version = m_version.load(std::memory_order_relaxed);
+        m_version.store(version + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            m_words[i].store(words[i], std::memory_order_relaxed);
+        }
+        m_version.store(version + 2, std::memory_order_release);
+    }
+
+    // One attempt, false if a write was in progress.
+    [[nodiscard]] bool tryLoad(T& value) const
+    {
+        const auto before = m_version.load(std::memory_order_acquire);
+        if (before & 1) {
+            return false;
+        }
+
+        std::array<uint64_t, WORDS> words;
+        for (std::size_t i = 0; i < WORDS; ++i) {
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_version.load(std::memory_order_relaxed) != before) {
+            return false;
+        }
+
+        std::memcpy(&value, words.data(), sizeof(T));
+        return true;
+    }
+
+    [[nodiscard]] T load() const
+    {
+        T value;
+        while (!tryLoad(value)) {
+            __builtin_ia32_pause();
+        }
+        return value;
+    }
+
+    // Number of completed writes.
+    [[nodiscard]] uint64_t version() const
+    {
+        return m_version.load(std::memory_order_acquire) / 2;
+    }
+};
+
+}  // namespace algocor
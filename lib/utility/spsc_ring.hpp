@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace algocor
+{
+
+// Bounded single producer / single consumer ring. The producer never blocks: push() fails and the record is counted as dropped when
+// the consumer falls behind.
+template<typename T, std::size_t Capacity>
+class SpscRing {
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    alignas(64) std::atomic<uint64_t> m_head { 0 };  // next write, owned by the producer.
+    alignas(64) std::atomic<uint64_t> m_tail { 0 };  // next read, owned by the consumer.
+    alignas(64) uint64_t m_dropped { 0 };
+    std::array<T, Capacity> m_items {};
+
+public:
+    bool push(const T& item)
+    {
+        const auto head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) == Capacity) [[unlikely]] {
+            ++m_dropped;
+            return false;
+        }
+
+        m_items[head & (Capacity - 1)] = item;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        if (tail == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+
+        item = m_items[tail & (Capacity - 1)];
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Calls func(const T&) for every pending item, returns how many were consumed.
+    template<typename Func>
+    std::size_t drain(Func&& func)
+    {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+        const auto head = m_head.load(std::memory_order_acquire);
+        for (auto index = tail; index != head; ++index) {
+            func(m_items[index & (Capacity - 1)]);
+        }
+        m_tail.store(head, std::memory_order_release);
+        return head - tail;
+    }
+
+    [[nodiscard]] bool empty() const
+    {
+        return m_tail.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+    }
+
+    // Producer side only, pushes that succeed before the consumer makes room.
+    [[nodiscard]] std::size_t freeSlots() const
+    {
+        return Capacity - (m_head.load(std::memory_order_relaxed) - m_tail.load(std::memory_order_acquire));
+    }
+
+    // Producer side only.
+    [[nodiscard]] uint64_t dropped() const
+    {
+        return m_dropped;
+    }
+};
+
+}  // namespace algocor
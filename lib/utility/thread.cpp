@@ -1,6 +1,8 @@
 #include "thread.hpp"
 #include "overwrite_macros.hpp"
 
+#include <thread>
+
 namespace algocor
 {
 
@@ -78,6 +80,9 @@ bool setSchedulerPolicy(int policy, int priority)
         case SCHED_OTHER:
             policyName = "SCHED_OTHER";
             break;
+        case SCHED_IDLE:
+            policyName = "SCHED_IDLE";
+            break;
         default:
             policyName = "Unknown";
             break;
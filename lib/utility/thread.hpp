@@ -5,7 +5,7 @@
 namespace algocor
 {
 
-void setThredName(const std::string& name);
+void setThreadName(const std::string& name);
 [[nodiscard]] bool pinThreadToCore(int core);
 [[nodiscard]] bool setSchedulerPolicy(int policy, int priority);
 
@@ -0,0 +1,137 @@
+#include "../core/book_verifier.hpp"
+#include "../core/orderbook_builder.hpp"
+#include <gtest/gtest.h>
+
+using algocor::BookMutation;
+using Kind = BookMutation::Kind;
+
+static BookMutation mutation(Kind kind, char side, int32_t price, uint64_t qty, int32_t best_price, uint64_t best_qty)
+{
+    return { .orderbook_id = 7,
+        .price = price,
+        .qty = qty,
+        .new_price = 0,
+        .best_price = best_price,
+        .new_qty = 0,
+        .best_qty = best_qty,
+        .kind = kind,
+        .side = side };
+}
+
+// --- A consistent stream passes, every kind of inconsistency is reported ---
+TEST(BookVerifierTest, DetectsDivergence)
+{
+    algocor::BookVerifier verifier;
+
+    verifier.record(mutation(Kind::Add, 'B', 100, 10, 100, 10));
+    verifier.record(mutation(Kind::Add, 'S', 101, 5, 101, 5));
+    verifier.record(mutation(Kind::Execute, 'S', 101, 2, 101, 3));
+    EXPECT_EQ(verifier.verifyPending(), 3U);
+    EXPECT_EQ(verifier.divergences(), 0U);
+
+    // Deleting more than the level holds.
+    verifier.record(mutation(Kind::Delete, 'B', 100, 11, 0, 0));
+    verifier.verifyPending();
+    EXPECT_EQ(verifier.divergences(), 1U);
+
+    // Hot book reports a different best level than the reference.
+    verifier.record(mutation(Kind::Add, 'B', 99, 1, 99, 1));
+    verifier.verifyPending();
+    EXPECT_EQ(verifier.divergences(), 2U);
+
+    // Crossed outside an auction, but not inside one.
+    verifier.record(mutation(Kind::Add, 'B', 102, 1, 102, 1));
+    verifier.verifyPending();
+    EXPECT_EQ(verifier.divergences(), 3U);
+
+    verifier.record(mutation(Kind::Auction, 'B', 0, 1, 0, 0));
+    verifier.record(mutation(Kind::Add, 'B', 103, 1, 103, 1));
+    verifier.verifyPending();
+    EXPECT_EQ(verifier.divergences(), 3U);
+    EXPECT_EQ(verifier.verified(), 8U);
+}
+
+// --- The builder records every update, the verifier thread replays them ---
+TEST(BookVerifierTest, VerifiesBuilderUpdates)
+{
+    using namespace algocor::protocol::itch;
+
+    algocor::BookVerifier verifier;
+    ConcreteOrderbookBuilder builder;
+    builder.setVerifier(&verifier);
+    verifier.start();
+
+    for (uint64_t order_id = 1; order_id <= 1'000; ++order_id) {
+        AddOrder add {};
+        add.order_id = { htobe64(order_id) };
+        add.orderbook_id = { htobe32(1) };
+        add.side = order_id % 2 ? algocor::Side::Buy : algocor::Side::Sell;
+        add.quantity = { htobe64(10) };
+        const auto price = static_cast<uint32_t>(order_id % 2 ? 1'000 - order_id % 50 : 1'001 + order_id % 50);
+        add.price = { static_cast<int32_t>(htobe32(price)) };
+        builder.addOrder(add);
+
+        if (order_id % 3 == 0) {
+            OrderDelete del {};
+            del.order_id = { htobe64(order_id) };
+            del.orderbook_id = { htobe32(1) };
+            del.side = add.side;
+            builder.deleteOrder(del);
+        }
+    }
+
+    verifier.stop();
+    EXPECT_EQ(verifier.verified(), 1'333U);
+    EXPECT_EQ(verifier.divergences(), 0U);
+}
+
+// --- A book whose records were dropped is re-seeded from the hot book and verified again, other books go on being verified ---
+TEST(BookVerifierTest, ResyncsBookAfterOverrun)
+{
+    using namespace algocor::protocol::itch;
+
+    algocor::BookVerifier verifier;
+    ConcreteOrderbookBuilder builder;
+    builder.setVerifier(&verifier);
+
+    const auto add = [&](uint32_t orderbook_id, uint64_t order_id) {
+        AddOrder message {};
+        message.order_id = { htobe64(order_id) };
+        message.orderbook_id = { htobe32(orderbook_id) };
+        message.side = order_id % 2 ? algocor::Side::Buy : algocor::Side::Sell;
+        message.quantity = { htobe64(10) };
+        const auto price = static_cast<uint32_t>(order_id % 2 ? 1'000 - order_id % 50 : 1'001 + order_id % 50);
+        message.price = { static_cast<int32_t>(htobe32(price)) };
+        builder.addOrder(message);
+    };
+    const auto remove = [&](uint32_t orderbook_id, uint64_t order_id) {
+        OrderDelete message {};
+        message.order_id = { htobe64(order_id) };
+        message.orderbook_id = { htobe32(orderbook_id) };
+        message.side = order_id % 2 ? algocor::Side::Buy : algocor::Side::Sell;
+        builder.deleteOrder(message);
+    };
+
+    // Nothing drains the ring: the add after it is full is lost, the book the verifier knew is gone.
+    for (uint64_t order_id = 1; order_id <= algocor::BookVerifier::RING_CAPACITY + 1; ++order_id) {
+        add(1, order_id);
+    }
+    EXPECT_EQ(verifier.verifyPending(), algocor::BookVerifier::RING_CAPACITY);
+
+    // The next update of the book re-seeds it, the one of another book is recorded as usual.
+    remove(1, 1);
+    add(2, 1);
+    remove(1, 2);
+    verifier.verifyPending();
+    EXPECT_EQ(verifier.resyncs(), 1U);
+
+    const auto verified = verifier.verified();
+    for (uint64_t order_id = 3; order_id <= 1'000; ++order_id) {
+        remove(1, order_id);
+    }
+    remove(2, 1);
+    verifier.verifyPending();
+    EXPECT_EQ(verifier.verified(), verified + 999);
+    EXPECT_EQ(verifier.divergences(), 0U);
+    EXPECT_EQ(verifier.resyncs(), 1U);
+}
@@ -0,0 +1,145 @@
+#include "../core/combination_registry.hpp"
+#include "../core/orderbook_builder.hpp"
+#include "itch_parser.hpp"
+#include "itch_shard_router.hpp"
+#include "itch_test_messages.hpp"
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace algocor::protocol::itch;
+using namespace algocor::test;
+
+namespace
+{
+
+constexpr auto NO_PRICE = algocor::CombinationRegistry::NO_PRICE;
+
+CombinationOrderbookLeg makeLeg(uint32_t combination_id, uint32_t leg_orderbook_id, algocor::LegSide side, uint32_t ratio)
+{
+    CombinationOrderbookLeg leg {};
+    leg.type = algocor::MessageType::CombinationOrderbookLeg;
+    leg.combination_orderbook_id = { htobe32(combination_id) };
+    leg.leg_orderbook_id = { htobe32(leg_orderbook_id) };
+    leg.leg_side = side;
+    leg.leg_ratio = { htobe32(ratio) };
+    return leg;
+}
+
+}  // namespace
+
+TEST(CombinationRegistryTest, FollowsTopOfLegBooks)
+{
+    algocor::CombinationRegistry registry;
+    // Calendar spread 10: buys book 1 and sells book 2. Strategy 11: buys two of book 1 and one of book 3.
+    EXPECT_TRUE(registry.addLeg(10, { 1, 1, false }));
+    EXPECT_TRUE(registry.addLeg(10, { 2, 1, true }));
+    EXPECT_FALSE(registry.addLeg(10, { 2, 1, true }));
+    EXPECT_FALSE(registry.addLeg(11, { 1, 0, false }));
+    EXPECT_TRUE(registry.addLeg(11, { 1, 2, false }));
+    EXPECT_TRUE(registry.addLeg(11, { 3, 1, false }));
+    EXPECT_EQ(registry.legs(10)->size(), 2U);
+    EXPECT_EQ(registry.legs(12), nullptr);
+
+    EXPECT_EQ(registry.impliedBid(10), NO_PRICE);
+    registry.onTopOfBook(1, 'B', 100, true);
+    registry.onTopOfBook(1, 'S', 102, true);
+    registry.onTopOfBook(2, 'B', 95, true);
+    EXPECT_EQ(registry.impliedBid(10), NO_PRICE);  // needs the ask of book 2.
+    EXPECT_EQ(registry.impliedAsk(10), 7);
+    registry.onTopOfBook(2, 'S', 98, true);
+    EXPECT_EQ(registry.impliedBid(10), 2);
+
+    registry.onTopOfBook(3, 'B', 50, true);
+    EXPECT_EQ(registry.impliedBid(11), 250);
+    EXPECT_EQ(registry.impliedAsk(11), NO_PRICE);
+    EXPECT_EQ(registry.impliedBid(10), 2);  // not a leg of the spread.
+
+    registry.onTopOfBook(1, 'B', 101, true);
+    EXPECT_EQ(registry.impliedBid(10), 3);
+    EXPECT_EQ(registry.impliedBid(11), 252);
+    registry.onTopOfBook(2, 'S', 0, false);
+    EXPECT_EQ(registry.impliedBid(10), NO_PRICE);
+    EXPECT_EQ(registry.impliedAsk(10), 7);
+    registry.onTopOfBook(2, 'S', 98, true);
+    registry.onTopOfBook(1, 'B', 100, true);
+
+    // Implied-in: the spread's own quotes of 3 / 6 against the other leg's outright quote.
+    EXPECT_EQ(registry.impliedLegBid(10, 1), NO_PRICE);
+    registry.onTopOfBook(10, 'B', 3, true);
+    registry.onTopOfBook(10, 'S', 6, true);
+    EXPECT_EQ(registry.impliedLegBid(10, 1), 98);
+    EXPECT_EQ(registry.impliedLegAsk(10, 1), 104);
+    EXPECT_EQ(registry.impliedLegBid(10, 2), 94);
+    EXPECT_EQ(registry.impliedLegAsk(10, 2), 99);
+    EXPECT_EQ(registry.impliedLegBid(10, 3), NO_PRICE);
+
+    // Ratios divide, bids rounding down.
+    registry.onTopOfBook(11, 'B', 255, true);
+    EXPECT_EQ(registry.impliedLegBid(11, 1), NO_PRICE);  // needs the ask of book 3.
+    registry.onTopOfBook(3, 'S', 52, true);
+    EXPECT_EQ(registry.impliedLegBid(11, 1), 101);
+    EXPECT_EQ(registry.impliedLegBid(11, 3), 51);
+}
+
+TEST(CombinationRegistryTest, BuilderFeedsLegQuotes)
+{
+    ConcreteOrderbookBuilder builder;
+    ItchParser<ConcreteOrderbookBuilder> parser(builder);
+    uint64_t sequence = 1;
+    const auto parse = [&](const auto& message) { parser.parseMessage(reinterpret_cast<const char*>(&message), sequence++); };
+
+    // Book 1 is quoted before the spread is announced.
+    parse(makeAdd(1, 'B', 100, 10, 0, 1));
+    parse(makeAdd(2, 'S', 102, 10, 0, 1));
+    parse(makeLeg(10, 1, algocor::LegSide::AsDefined, 1));
+    parse(makeLeg(10, 2, algocor::LegSide::Opposite, 1));
+    parse(makeAdd(3, 'B', 95, 10, 0, 2));
+    parse(makeAdd(4, 'S', 98, 10, 0, 2));
+
+    const auto& combinations = builder.combinations();
+    EXPECT_EQ(combinations.impliedBid(10), 2);
+    EXPECT_EQ(combinations.impliedAsk(10), 7);
+
+    parse(makeAdd(5, 'S', 97, 10, 0, 2));
+    parse(makeAdd(6, 'S', 99, 10, 0, 2));  // behind the top, nothing to do.
+    EXPECT_EQ(combinations.impliedBid(10), 3);
+
+    parse(makeDelete(1, 'B', 1));
+    EXPECT_EQ(combinations.impliedBid(10), NO_PRICE);
+
+    parse(makeAdd(7, 'S', 6, 10, 0, 10));
+    EXPECT_EQ(combinations.impliedLegBid(10, 2), NO_PRICE);
+    parse(makeAdd(8, 'B', 101, 10, 0, 1));
+    EXPECT_EQ(combinations.impliedLegBid(10, 2), 95);
+}
+
+TEST(CombinationRegistryTest, ShardRouterDropsLegsAcrossShards)
+{
+    ItchShardRouter<ConcreteOrderbookBuilder, 64> router(2);
+    constexpr uint32_t COMBINATION_ID = 10;
+    uint32_t leg_id = COMBINATION_ID + 1;
+    while (router.shardOf(leg_id) == router.shardOf(COMBINATION_ID)) {
+        ++leg_id;
+    }
+    router.start();
+
+    MoldPayload payload;
+    payload.append(makeLeg(COMBINATION_ID, leg_id, algocor::LegSide::AsDefined, 1));
+    payload.append(makeAdd(1, 'B', 100, 10, 0, leg_id));
+    payload.append(makeAdd(2, 'S', 6, 10, 0, COMBINATION_ID));
+    router.routePayload(payload.data(), payload.message_count, 1);
+    while (router.watermark() != 3) {
+        std::this_thread::yield();
+    }
+
+    // No shard is left with a combination whose leg quotes it never sees.
+    EXPECT_EQ(router.droppedCombinationLegs(), 1U);
+    for (std::size_t shard = 0; shard < router.shardCount(); ++shard) {
+        EXPECT_TRUE(router.builder(shard)->combinations().empty());
+    }
+    EXPECT_EQ(router.builder(router.shardOf(leg_id))->getOrderbook(leg_id).BestLevel('B'), std::make_pair(100, uint64_t { 10 }));
+    EXPECT_EQ(router.builder(router.shardOf(COMBINATION_ID))->getOrderbook(COMBINATION_ID).BestLevel('S'),
+        std::make_pair(6, uint64_t { 10 }));
+    router.stop();
+}
@@ -2,9 +2,16 @@
 #include "../moldudp64/moldudp64_downstream_header.hpp"
 #include "itch_add_order.hpp"
 #include "itch_parser.hpp"
+#include "itch_shard_router.hpp"
+#include "itch_test_messages.hpp"
 #include <gtest/gtest.h>
 #include <pcap.h>
 
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
 using namespace algocor::protocol::itch;
 
 // --- Mock for static polymorphism ---
@@ -13,15 +20,15 @@ struct MockOrderbookBuilder {
     int exec_calls = 0;
     int del_calls = 0;
 
-    void addOrder(const AddOrder&)
+    void addOrder(AddOrderView)
     {
         ++add_calls;
     }
-    void executeOrder(const OrderExecuted&)
+    void executeOrder(OrderExecutedView)
     {
         ++exec_calls;
     }
-    void deleteOrder(const OrderDelete&)
+    void deleteOrder(OrderDeleteView)
     {
         ++del_calls;
     }
@@ -94,6 +101,69 @@ TEST(ItchParserRealBuilderTest, ParseAddOrders)
     }
 }
 
+// --- The builder publishes a change event only when a visible level moves ---
+TEST(ItchParserRealBuilderTest, PublishesBookEvents)
+{
+    ConcreteOrderbookBuilder builder;
+    ItchParser<ConcreteOrderbookBuilder> parser(builder);
+
+    auto packets = loadPcap("dummy_add_order.pcap");
+    ASSERT_EQ(packets.size(), 1);
+
+    const size_t payload_offset = 14 + 20 + 8;
+    const auto& raw_packet = packets[0];
+    ASSERT_GE(raw_packet.size(), payload_offset);
+    parser.parse(reinterpret_cast<const char*>(raw_packet.data() + payload_offset), raw_packet.size() - payload_offset);
+
+    std::vector<algocor::BookEvent> events;
+    builder.bookEvents().drain([&](const algocor::BookEvent& event) { events.push_back(event); });
+
+    // Bid 1000, ask 1010, then bid 1020 improves the BBO and pushes 1000 down to level 1.
+    ASSERT_EQ(events.size(), 4);
+    using Kind = algocor::BookEvent::Kind;
+    const std::vector<std::tuple<Kind, char, uint8_t, int32_t, uint64_t>> expected = {
+        { Kind::Bbo, 'B', 0, 1000, 100 },
+        { Kind::Bbo, 'S', 0, 1010, 200 },
+        { Kind::Bbo, 'B', 0, 1020, 150 },
+        { Kind::Depth, 'B', 1, 1000, 100 },
+    };
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(events[i].orderbook_id, 1U);
+        EXPECT_EQ(std::make_tuple(events[i].kind, events[i].side, events[i].level, events[i].price, events[i].qty), expected[i]);
+    }
+    EXPECT_TRUE(builder.bookEvents().empty());
+
+    // The last top of book change came from the third message of the packet.
+    const auto snapshot = builder.snapshot(1).load();
+    EXPECT_EQ(snapshot.sequence, 3U);
+    EXPECT_EQ(snapshot.bid_prices[0], 1020);
+    EXPECT_EQ(snapshot.bid_qtys[0], 150U);
+    EXPECT_EQ(snapshot.ask_prices[0], 1010);
+    EXPECT_EQ(snapshot.ask_qtys[0], 200U);
+}
+
+// --- Quantities an order record cannot hold leave the book untouched, an execution of more than is left fills the order ---
+TEST(ItchParserRealBuilderTest, KeepsOrderRecordsInStepWithLevels)
+{
+    ConcreteOrderbookBuilder builder;
+    ItchParser<ConcreteOrderbookBuilder> parser(builder);
+    uint64_t sequence = 0;
+    const auto parse = [&](const auto& message) { parser.parseMessage(reinterpret_cast<const char*>(&message), ++sequence); };
+
+    parse(algocor::test::makeAdd(1, 'B', 100, uint64_t { UINT32_MAX } + 1));
+    EXPECT_FALSE(builder.hasOrder(1, 1, 'B'));
+
+    parse(algocor::test::makeAdd(2, 'B', 100, 10));
+    parse(algocor::test::makeReplace(2, 'B', 101, uint64_t { UINT32_MAX } + 1));
+    EXPECT_EQ(builder.getOrder(1, 2, 'B').price, 100);
+    EXPECT_EQ(builder.getOrderbook(1).BestLevel('B'), std::make_pair(100, uint64_t { 10 }));
+
+    parse(algocor::test::makeExecute(2, 'B', 25));
+    EXPECT_FALSE(builder.hasOrder(1, 2, 'B'));
+    EXPECT_EQ(builder.getOrderbook(1).BestLevel('B').second, 0U);
+    EXPECT_EQ(builder.tradeTape(1).size(), 1U);
+}
+
 // --- Test with mock builder to verify parser forwarding ---
 TEST(ItchParserMockBuilderTest, ForwardMessagesToBuilder)
 {
@@ -115,3 +185,304 @@ TEST(ItchParserMockBuilderTest, ForwardMessagesToBuilder)
     EXPECT_EQ(mock.exec_calls, 0);  // no executed orders in this pcap
     EXPECT_EQ(mock.del_calls, 0);   // no deletes
 }
+
+// --- Views read fields in host order from wherever the message sits in the buffer ---
+TEST(ItchMessageViewTest, ReadsFieldsFromUnalignedBytes)
+{
+    AddOrder add {};
+    add.type = algocor::MessageType::AddOrder;
+    add.nanoseconds = { htobe32(123456789) };
+    add.order_id = { htobe64(0x0102030405060708ULL) };
+    add.orderbook_id = { htobe32(70616) };
+    add.side = algocor::Side::Sell;
+    add.orderbook_position = { htobe32(3) };
+    add.quantity = { htobe64(500) };
+    add.price = { static_cast<int32_t>(htobe32(static_cast<uint32_t>(-2500))) };
+
+    std::array<char, sizeof(AddOrder) + 1> buffer {};
+    std::memcpy(buffer.data() + 1, &add, sizeof(add));
+    const AddOrderView view { buffer.data() + 1 };
+    EXPECT_EQ(view.nanoseconds(), 123456789U);
+    EXPECT_EQ(view.orderId(), 0x0102030405060708ULL);
+    EXPECT_EQ(view.orderbookId(), 70616U);
+    EXPECT_TRUE(view.isOrderbook(70616));
+    EXPECT_FALSE(view.isOrderbook(70617));
+    EXPECT_EQ(view.side(), 'S');
+    EXPECT_EQ(view.orderbookPosition(), 3U);
+    EXPECT_EQ(view.quantity(), 500U);
+    EXPECT_EQ(view.price(), -2500);
+    EXPECT_EQ(AddOrderView { add }.orderId(), view.orderId());
+
+    OrderExecutedWithPrice executed {};
+    executed.type = algocor::MessageType::OrderExecutedWithPrice;
+    executed.order_id = { htobe64(9) };
+    executed.quantity = { htobe64(40) };
+    executed.match_id = { htobe64(77) };
+    executed.trade_price = { static_cast<int32_t>(htobe32(1010)) };
+    executed.printable = algocor::Printable::No;
+    const OrderExecutedWithPriceView executed_view { executed };
+    EXPECT_EQ(executed_view.orderId(), 9U);
+    EXPECT_EQ(executed_view.quantity(), 40U);
+    EXPECT_EQ(executed_view.matchId(), 77U);
+    EXPECT_EQ(executed_view.tradePrice(), 1010);
+    EXPECT_FALSE(executed_view.printable());
+}
+
+// --- Message types without a builder member are skipped before the builder sees them ---
+TEST(ItchParserMockBuilderTest, SkipsUnhandledMessageTypes)
+{
+    struct SecondsBuilder : MockOrderbookBuilder {
+        std::vector<uint64_t> sequences;
+        uint32_t second = 0;
+
+        void setSequence(uint64_t sequence)
+        {
+            sequences.push_back(sequence);
+        }
+        void seconds(SecondsView seconds)
+        {
+            second = seconds.second();
+        }
+    };
+    SecondsBuilder mock;
+    ItchParser<SecondsBuilder> parser(mock);
+
+    Trade trade {};
+    trade.type = algocor::MessageType::Trade;
+    parser.parseMessage(reinterpret_cast<const char*>(&trade), 1);
+    Seconds seconds {};
+    seconds.type = algocor::MessageType::Seconds;
+    seconds.second = { htobe32(36000) };
+    parser.parseMessage(reinterpret_cast<const char*>(&seconds), 2);
+    AddOrder add {};
+    add.type = algocor::MessageType::AddOrder;
+    parser.parseMessage(reinterpret_cast<const char*>(&add), 3);
+    const char unknown[8] = { 'x' };
+    parser.parseMessage(unknown, 4);
+
+    EXPECT_EQ(mock.second, 36000U);
+    EXPECT_EQ(mock.add_calls, 1);
+    EXPECT_EQ(mock.sequences, (std::vector<uint64_t> { 2, 3 }));
+}
+
+// --- Only subscribed books reach the builder, by symbol from the directory or by id, and changes apply to the next message ---
+TEST(ItchParserRealBuilderTest, FiltersUnsubscribedBooks)
+{
+    ConcreteOrderbookBuilder builder;
+    ItchParser<ConcreteOrderbookBuilder> parser(builder);
+    algocor::SubscriptionFilter subscriptions;
+    subscriptions.subscribeSymbol("GARAN.E");
+    subscriptions.subscribe(9);
+    parser.setSubscriptions(&subscriptions);
+
+    algocor::test::MoldPayload payload;
+    const auto add_for = [&](uint32_t orderbook_id, uint64_t order_id) {
+        AddOrder add {};
+        add.type = algocor::MessageType::AddOrder;
+        add.order_id = { htobe64(order_id) };
+        add.orderbook_id = { htobe32(orderbook_id) };
+        add.side = algocor::Side::Buy;
+        add.quantity = { htobe64(10) };
+        add.price = { static_cast<int32_t>(htobe32(100)) };
+        payload.append(add);
+    };
+
+    OrderBookDirectory directory {};
+    directory.type = algocor::MessageType::OrderbookDirectory;
+    directory.orderbook_id = { htobe32(5) };
+    directory.symbol.fill(' ');
+    std::memcpy(directory.symbol.data(), "GARAN.E", 7);
+    payload.append(directory);
+    add_for(5, 1);
+    add_for(7, 2);
+    add_for(9, 3);
+    parser.parsePayload(payload.data(), payload.message_count, 1);
+
+    EXPECT_TRUE(subscriptions.contains(5));
+    EXPECT_TRUE(builder.hasOrder(5, 1, 'B'));
+    EXPECT_FALSE(builder.hasOrder(7, 2, 'B'));
+    EXPECT_TRUE(builder.hasOrder(9, 3, 'B'));
+    EXPECT_EQ(builder.registry().find(7), algocor::OrderbookRegistry::NO_BOOK);
+    EXPECT_EQ(parser.filteredMessages(), 1U);
+
+    subscriptions.unsubscribe(9);
+    subscriptions.subscribe(7);
+    payload.clear();
+    add_for(7, 4);
+    add_for(9, 5);
+    parser.parsePayload(payload.data(), payload.message_count, 5);
+
+    EXPECT_TRUE(builder.hasOrder(7, 4, 'B'));
+    EXPECT_FALSE(builder.hasOrder(9, 5, 'B'));
+    EXPECT_EQ(parser.filteredMessages(), 2U);
+
+    // The unsubscribed book was flushed, its delete is filtered and would have left order 3 behind.
+    EXPECT_FALSE(builder.hasOrder(9, 3, 'B'));
+    EXPECT_EQ(builder.getOrderbook(9).BestLevel('B').second, 0U);
+    EXPECT_EQ(builder.snapshot(9).load().bid_qtys[0], 0U);
+
+    subscriptions.subscribe(9);
+    payload.clear();
+    add_for(9, 6);
+    parser.parsePayload(payload.data(), payload.message_count, 7);
+
+    EXPECT_TRUE(builder.hasOrder(9, 6, 'B'));
+    EXPECT_EQ(builder.getOrderbook(9).BestLevel('B'), std::make_pair(100, uint64_t { 10 }));
+}
+
+// --- Removed ids leave their slots to later ones, the table never fills up with them ---
+TEST(SubscriptionFilterTest, ReusesSlotsOfRemovedIds)
+{
+    constexpr auto CAPACITY = static_cast<uint32_t>(algocor::SubscriptionFilter::CAPACITY);
+    algocor::SubscriptionFilter subscriptions;
+    for (uint32_t orderbook_id = 1; orderbook_id <= CAPACITY; ++orderbook_id) {
+        ASSERT_TRUE(subscriptions.subscribe(orderbook_id));
+    }
+    EXPECT_FALSE(subscriptions.subscribe(5'000));
+
+    for (uint32_t round = 0; round < 10 * CAPACITY; ++round) {
+        const auto orderbook_id = 1 + round % CAPACITY;
+        subscriptions.unsubscribe(orderbook_id);
+        EXPECT_FALSE(subscriptions.contains(orderbook_id));
+        ASSERT_TRUE(subscriptions.subscribe(orderbook_id + (round % 2 == 0 ? 10'000 : 0)));
+        subscriptions.unsubscribe(orderbook_id + 10'000);
+        ASSERT_TRUE(subscriptions.subscribe(orderbook_id));
+    }
+    for (uint32_t orderbook_id = 1; orderbook_id <= CAPACITY; ++orderbook_id) {
+        EXPECT_TRUE(subscriptions.contains(orderbook_id));
+    }
+    EXPECT_FALSE(subscriptions.contains(10'001));
+    EXPECT_EQ(subscriptions.unsubscribed(), 15 * CAPACITY);
+}
+
+// --- Two-pass batch decode builds the same books as applying messages one at a time, across packets larger than a batch ---
+TEST(ItchParserRealBuilderTest, BatchDecodeMatchesSequentialParse)
+{
+    ConcreteOrderbookBuilder reference;
+    ItchParser<ConcreteOrderbookBuilder> parser(reference);
+    ConcreteOrderbookBuilder batched;
+    ItchParser<ConcreteOrderbookBuilder> batch_parser(batched);
+    batch_parser.setBatchDecode(true);
+
+    std::mt19937 rng(5);
+    std::vector<AddOrder> live;
+    uint64_t sequence_number = 1;
+    uint64_t next_order_id = 1;
+    for (int packet = 0; packet < 30; ++packet) {
+        algocor::test::MoldPayload payload;
+
+        const auto messages = packet % 10 == 9 ? 600 : 40;
+        for (int message = 0; message < messages; ++message) {
+            if (live.empty() || rng() % 2 == 0) {
+                AddOrder add {};
+                add.type = algocor::MessageType::AddOrder;
+                add.order_id = { htobe64(next_order_id++) };
+                add.orderbook_id = { htobe32(1 + rng() % 4) };
+                add.side = rng() % 2 == 0 ? algocor::Side::Buy : algocor::Side::Sell;
+                add.quantity = { htobe64(1 + rng() % 50) };
+                const auto offset = static_cast<int32_t>(rng() % 10);
+                const auto price = add.side == algocor::Side::Buy ? 100 - offset : 101 + offset;
+                add.price = { static_cast<int32_t>(htobe32(static_cast<uint32_t>(price))) };
+                payload.append(add);
+                live.push_back(add);
+                continue;
+            }
+
+            const auto index = rng() % live.size();
+            const auto& order = live[index];
+            if (rng() % 2 == 0) {
+                OrderExecuted executed {};
+                executed.type = algocor::MessageType::OrderExecuted;
+                executed.order_id = order.order_id;
+                executed.orderbook_id = order.orderbook_id;
+                executed.side = order.side;
+                executed.quantity = order.quantity;
+                payload.append(executed);
+            } else {
+                OrderDelete del {};
+                del.type = algocor::MessageType::OrderDelete;
+                del.order_id = order.order_id;
+                del.orderbook_id = order.orderbook_id;
+                del.side = order.side;
+                payload.append(del);
+            }
+            live[index] = live.back();
+            live.pop_back();
+        }
+
+        parser.parsePayload(payload.data(), payload.message_count, sequence_number);
+        batch_parser.parsePayload(payload.data(), payload.message_count, sequence_number);
+        sequence_number += payload.message_count;
+    }
+
+    for (uint32_t orderbook_id = 1; orderbook_id <= 4; ++orderbook_id) {
+        EXPECT_EQ(batched.getOrderbook(orderbook_id).GetBestPrices(), reference.getOrderbook(orderbook_id).GetBestPrices());
+        EXPECT_EQ(batched.snapshot(orderbook_id).load().bid_qtys, reference.snapshot(orderbook_id).load().bid_qtys);
+        EXPECT_EQ(batched.snapshot(orderbook_id).load().sequence, reference.snapshot(orderbook_id).load().sequence);
+    }
+    for (const auto& order : live) {
+        const AddOrderView view { order };
+        EXPECT_TRUE(batched.hasOrder(view.orderbookId(), view.orderId(), view.side()));
+    }
+}
+
+// --- Sharded books end up as one builder would build them, and every shard's watermark reaches the last packet ---
+TEST(ItchParserRealBuilderTest, ShardedBooksMatchSingleBuilder)
+{
+    ConcreteOrderbookBuilder reference;
+    ItchParser<ConcreteOrderbookBuilder> parser(reference);
+    // A small ring so the receive side wraps it and waits for the workers.
+    ItchShardRouter<ConcreteOrderbookBuilder, 64> router(3);
+    router.start();
+
+    std::mt19937 rng(11);
+    uint64_t sequence_number = 1;
+    for (int packet = 0; packet < 200; ++packet) {
+        algocor::test::MoldPayload payload;
+
+        Seconds seconds {};
+        seconds.type = algocor::MessageType::Seconds;
+        seconds.second = { htobe32(static_cast<uint32_t>(packet)) };
+        payload.append(seconds);
+        for (int message = 0; message < 20; ++message) {
+            const auto order_id = sequence_number + payload.message_count;
+            AddOrder add {};
+            add.type = algocor::MessageType::AddOrder;
+            add.order_id = { htobe64(order_id) };
+            add.orderbook_id = { htobe32(1 + rng() % 8) };
+            add.side = rng() % 2 == 0 ? algocor::Side::Buy : algocor::Side::Sell;
+            add.quantity = { htobe64(1 + rng() % 50) };
+            const auto offset = static_cast<int32_t>(rng() % 10);
+            const auto price = add.side == algocor::Side::Buy ? 100 - offset : 101 + offset;
+            add.price = { static_cast<int32_t>(htobe32(static_cast<uint32_t>(price))) };
+            payload.append(add);
+
+            if (rng() % 3 == 0) {
+                OrderDelete del {};
+                del.type = algocor::MessageType::OrderDelete;
+                del.order_id = add.order_id;
+                del.orderbook_id = add.orderbook_id;
+                del.side = add.side;
+                payload.append(del);
+            }
+        }
+
+        parser.parsePayload(payload.data(), payload.message_count, sequence_number);
+        router.routePayload(payload.data(), payload.message_count, sequence_number);
+        sequence_number += payload.message_count;
+    }
+
+    while (router.watermark() != sequence_number - 1) {
+        std::this_thread::yield();
+    }
+
+    for (uint32_t orderbook_id = 1; orderbook_id <= 8; ++orderbook_id) {
+        const auto& shard_builder = *router.builder(router.shardOf(orderbook_id));
+        EXPECT_EQ(shard_builder.getOrderbook(orderbook_id).GetBestPrices(), reference.getOrderbook(orderbook_id).GetBestPrices());
+        EXPECT_EQ(shard_builder.snapshot(orderbook_id).load().bid_qtys, reference.snapshot(orderbook_id).load().bid_qtys);
+        EXPECT_EQ(shard_builder.snapshot(orderbook_id).load().sequence, reference.snapshot(orderbook_id).load().sequence);
+    }
+    EXPECT_EQ(router.builder(0)->m_seconds, 199U);
+    router.stop();
+    EXPECT_EQ(router.builder(0), nullptr);
+}
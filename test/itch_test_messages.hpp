@@ -0,0 +1,95 @@
+#pragma once
+
+#include "itch_add_order.hpp"
+#include "itch_order_delete.hpp"
+#include "itch_order_executed.hpp"
+#include "itch_order_replace.hpp"
+
+#include <cstdint>
+#include <vector>
+
+// ITCH order messages and packets for the tests, fields in network order as they come off the wire. Side is 'B' or 'S'.
+namespace algocor::test
+{
+
+inline algocor::Side sideOf(char side)
+{
+    return side == 'B' ? algocor::Side::Buy : algocor::Side::Sell;
+}
+
+inline protocol::itch::AddOrder makeAdd(
+    uint64_t order_id, char side, int32_t price, uint64_t qty, uint32_t rank = 0, uint32_t orderbook_id = 1)
+{
+    protocol::itch::AddOrder add {};
+    add.type = algocor::MessageType::AddOrder;
+    add.order_id = { htobe64(order_id) };
+    add.orderbook_id = { htobe32(orderbook_id) };
+    add.side = sideOf(side);
+    add.orderbook_position = { htobe32(rank) };
+    add.quantity = { htobe64(qty) };
+    add.price = { static_cast<int32_t>(htobe32(static_cast<uint32_t>(price))) };
+    return add;
+}
+
+inline protocol::itch::OrderExecuted makeExecute(uint64_t order_id, char side, uint64_t qty, uint32_t orderbook_id = 1)
+{
+    protocol::itch::OrderExecuted executed {};
+    executed.type = algocor::MessageType::OrderExecuted;
+    executed.order_id = { htobe64(order_id) };
+    executed.orderbook_id = { htobe32(orderbook_id) };
+    executed.side = sideOf(side);
+    executed.quantity = { htobe64(qty) };
+    return executed;
+}
+
+inline protocol::itch::OrderDelete makeDelete(uint64_t order_id, char side, uint32_t orderbook_id = 1)
+{
+    protocol::itch::OrderDelete del {};
+    del.type = algocor::MessageType::OrderDelete;
+    del.order_id = { htobe64(order_id) };
+    del.orderbook_id = { htobe32(orderbook_id) };
+    del.side = sideOf(side);
+    return del;
+}
+
+inline protocol::itch::OrderReplace makeReplace(
+    uint64_t order_id, char side, int32_t price, uint64_t qty, uint32_t rank = 0, uint32_t orderbook_id = 1)
+{
+    protocol::itch::OrderReplace replace {};
+    replace.type = algocor::MessageType::OrderReplace;
+    replace.order_id = { htobe64(order_id) };
+    replace.orderbook_id = { htobe32(orderbook_id) };
+    replace.side = sideOf(side);
+    replace.orderbook_position = { htobe32(rank) };
+    replace.quantity = { htobe64(qty) };
+    replace.price = { static_cast<int32_t>(htobe32(static_cast<uint32_t>(price))) };
+    return replace;
+}
+
+// Message blocks of one MoldUDP64 packet, for ItchParser::parsePayload() and ItchShardRouter::routePayload().
+struct MoldPayload {
+    std::vector<char> bytes;
+    uint16_t message_count { 0 };
+
+    template<typename Message>
+    void append(const Message& message)
+    {
+        const auto length = htobe16(static_cast<uint16_t>(sizeof(message)));
+        bytes.insert(bytes.end(), reinterpret_cast<const char*>(&length), reinterpret_cast<const char*>(&length) + sizeof(length));
+        bytes.insert(bytes.end(), reinterpret_cast<const char*>(&message), reinterpret_cast<const char*>(&message) + sizeof(message));
+        ++message_count;
+    }
+
+    void clear()
+    {
+        bytes.clear();
+        message_count = 0;
+    }
+
+    [[nodiscard]] const char* data() const
+    {
+        return bytes.data();
+    }
+};
+
+}  // namespace algocor::test
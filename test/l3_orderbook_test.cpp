@@ -0,0 +1,265 @@
+#include "../core/orderbook_builder.hpp"
+#include "itch_test_messages.hpp"
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+using namespace algocor::protocol::itch;
+using namespace algocor::test;
+
+namespace
+{
+
+// Left quantities of the queue at `price`, front first.
+std::vector<uint32_t> queueAt(const ConcreteL3OrderbookBuilder& builder, char side, int32_t price)
+{
+    std::vector<uint32_t> qtys;
+    builder.getOrderbook(1).ForEachOrder(builder.m_orders, side, price, [&](const L3Order& order) { qtys.push_back(order.left_qty); });
+    return qtys;
+}
+
+}  // namespace
+
+// --- Orders queue in time priority, or at the rank the exchange reports when it falls inside their level ---
+TEST(L3OrderbookTest, QueuesFollowReportedRank)
+{
+    ConcreteL3OrderbookBuilder builder;
+
+    builder.addOrder(makeAdd(1, 'B', 100, 10, 1));
+    builder.addOrder(makeAdd(2, 'B', 100, 20, 2));
+    builder.addOrder(makeAdd(3, 'B', 100, 30, 3));
+    builder.addOrder(makeAdd(4, 'B', 101, 40, 1));
+    // One order at 101 and three at 100 rank ahead of ranks 1..4, rank 3 is the second place at 100.
+    builder.addOrder(makeAdd(5, 'B', 100, 50, 3));
+    EXPECT_EQ(builder.m_queueMismatches, 0U);
+    EXPECT_EQ(queueAt(builder, 'B', 100), (std::vector<uint32_t> { 10, 50, 20, 30 }));
+
+    const auto& book = builder.getOrderbook(1);
+    const auto* level = book.Level('B', 100);
+    ASSERT_NE(level, nullptr);
+    EXPECT_EQ(level->count, 4U);
+    EXPECT_EQ(level->qty, 110U);
+
+    // A rank outside the level is a disagreement, the order goes to the back.
+    builder.addOrder(makeAdd(6, 'B', 100, 60, 1));
+    EXPECT_EQ(builder.m_queueMismatches, 1U);
+    EXPECT_EQ(queueAt(builder, 'B', 100), (std::vector<uint32_t> { 10, 50, 20, 30, 60 }));
+
+    builder.executeOrder(makeExecute(1, 'B', 4));
+    builder.deleteOrder(makeDelete(2, 'B'));
+    EXPECT_EQ(queueAt(builder, 'B', 100), (std::vector<uint32_t> { 6, 50, 30, 60 }));
+    EXPECT_EQ(level->count, 4U);
+    EXPECT_EQ(level->qty, 146U);
+    EXPECT_EQ(book.BestLevel('B'), std::make_pair(101, uint64_t { 40 }));
+
+    const auto position_of = [&](uint64_t order_id) {
+        const auto* entry = builder.book(1).orders.find({ order_id, 1, 'B' });
+        return book.QueuePosition(builder.m_orders, entry->value);
+    };
+    EXPECT_EQ(position_of(1), 1U);
+    EXPECT_EQ(position_of(3), 3U);
+    EXPECT_EQ(position_of(6), 4U);
+
+    // Filling the only order at 101 removes the level.
+    builder.executeOrder(makeExecute(4, 'B', 40));
+    EXPECT_EQ(book.Level('B', 101), nullptr);
+    EXPECT_FALSE(builder.hasOrder(1, 4, 'B'));
+    EXPECT_EQ(book.BestLevel('B'), std::make_pair(100, uint64_t { 146 }));
+}
+
+// --- Reported ranks count the orders of every better level, levels reopen at their price after emptying ---
+TEST(L3OrderbookTest, RanksCountBetterLevels)
+{
+    ConcreteL3OrderbookBuilder builder;
+    for (uint64_t order_id = 1; order_id <= 5; ++order_id) {
+        builder.addOrder(makeAdd(order_id, 'B', 106 - static_cast<int32_t>(order_id), 10, static_cast<uint32_t>(order_id)));
+    }
+    // Two better levels and one order at 103 ahead.
+    builder.addOrder(makeAdd(6, 'B', 103, 20, 4));
+    EXPECT_EQ(builder.m_queueMismatches, 0U);
+    EXPECT_EQ(queueAt(builder, 'B', 103), (std::vector<uint32_t> { 10, 20 }));
+
+    // Rank 2 lies in a better level, the order goes to the back of 101.
+    builder.addOrder(makeAdd(7, 'B', 101, 30, 2));
+    EXPECT_EQ(builder.m_queueMismatches, 1U);
+    EXPECT_EQ(queueAt(builder, 'B', 101), (std::vector<uint32_t> { 10, 30 }));
+
+    builder.executeOrder(makeExecute(1, 'B', 10));
+    EXPECT_EQ(builder.getOrderbook(1).Level('B', 105), nullptr);
+    builder.addOrder(makeAdd(8, 'B', 105, 40, 1));
+    builder.addOrder(makeAdd(9, 'B', 102, 50, 6));
+    EXPECT_EQ(builder.m_queueMismatches, 1U);
+    EXPECT_EQ(builder.getOrderbook(1).Level('B', 105)->count, 1U);
+    EXPECT_EQ(queueAt(builder, 'B', 102), (std::vector<uint32_t> { 10, 50 }));
+}
+
+// --- A replace keeps the order's record, a smaller quantity at the same price keeps its place in the queue ---
+TEST(L3OrderbookTest, ReplaceKeepsOrLosesPriority)
+{
+    ConcreteL3OrderbookBuilder builder;
+    builder.addOrder(makeAdd(1, 'S', 200, 10, 1));
+    builder.addOrder(makeAdd(2, 'S', 200, 20, 2));
+    builder.addOrder(makeAdd(3, 'S', 200, 30, 3));
+
+    builder.replaceOrder(makeReplace(1, 'S', 200, 5, 1));
+    EXPECT_EQ(queueAt(builder, 'S', 200), (std::vector<uint32_t> { 5, 20, 30 }));
+
+    builder.replaceOrder(makeReplace(1, 'S', 200, 15, 3));
+    EXPECT_EQ(queueAt(builder, 'S', 200), (std::vector<uint32_t> { 20, 30, 15 }));
+
+    builder.replaceOrder(makeReplace(2, 'S', 199, 20, 1));
+    EXPECT_EQ(queueAt(builder, 'S', 200), (std::vector<uint32_t> { 30, 15 }));
+    EXPECT_EQ(queueAt(builder, 'S', 199), (std::vector<uint32_t> { 20 }));
+    EXPECT_EQ(builder.m_queueMismatches, 0U);
+
+    const auto& order = builder.getOrder(1, 2, 'S');
+    EXPECT_EQ(order.price, 199);
+    EXPECT_EQ(builder.getOrderbook(1).BestLevel('S'), std::make_pair(199, uint64_t { 20 }));
+    EXPECT_EQ(builder.getOrderbook(1).Level('S', 200)->qty, 45U);
+    EXPECT_EQ(builder.m_orders.size(), 3U);
+}
+
+// --- A flush empties one book and frees its orders, the other books keep theirs ---
+template<typename Builder>
+void checkFlush()
+{
+    Builder builder;
+    algocor::BookVerifier verifier;
+    builder.setVerifier(&verifier);
+
+    for (uint64_t order_id = 1; order_id <= 300; ++order_id) {
+        const auto orderbook_id = static_cast<uint32_t>(1 + order_id % 3);
+        const auto side = order_id % 2 == 0 ? 'B' : 'S';
+        const auto price = side == 'B' ? 100 - static_cast<int32_t>(order_id % 7) : 101 + static_cast<int32_t>(order_id % 7);
+        builder.addOrder(makeAdd(order_id, side, price, order_id, 0, orderbook_id));
+    }
+    const auto best_before = builder.getOrderbook(3).GetBestPrices();
+
+    OrderbookFlush flush {};
+    flush.orderbook_id = { htobe32(2) };
+    builder.flushOrderbook(flush);
+
+    EXPECT_EQ(builder.m_orders.size(), 200U);
+    EXPECT_EQ(builder.book(2).orders.size(), 0U);
+    EXPECT_FALSE(builder.hasOrder(2, 1, 'S'));
+    EXPECT_TRUE(builder.hasOrder(3, 2, 'B'));
+    EXPECT_EQ(builder.getOrderbook(2).GetBestPrices(), std::make_pair(L2Orderbook::NO_BID, L2Orderbook::NO_ASK));
+    EXPECT_EQ(builder.getOrderbook(3).GetBestPrices(), best_before);
+
+    const auto snapshot = builder.snapshot(2).load();
+    EXPECT_EQ(snapshot.bid_qtys[0], 0U);
+    EXPECT_EQ(snapshot.ask_qtys[0], 0U);
+
+    // The book takes new orders after the flush.
+    builder.addOrder(makeAdd(1, 'S', 105, 10, 0, 2));
+    EXPECT_EQ(builder.getOrderbook(2).BestLevel('S'), std::make_pair(105, uint64_t { 10 }));
+
+    verifier.verifyPending();
+    EXPECT_EQ(verifier.divergences(), 0U);
+}
+
+TEST(L3OrderbookTest, FlushRemovesOnlyThatBook)
+{
+    checkFlush<ConcreteOrderbookBuilder>();
+    checkFlush<ConcreteL3OrderbookBuilder>();
+}
+
+// --- A book's order index is sized as the book is registered and does not rehash while it stays within the reserve ---
+TEST(L3OrderbookTest, BookIndexesAreSizedAtRegistration)
+{
+    ConcreteOrderbookBuilder builder;
+    builder.setBookOrderReserve(1'000);
+
+    OrderBookDirectory directory {};
+    directory.orderbook_id = { htobe32(1) };
+    builder.orderbookDirectory(directory);
+    const auto capacity = builder.book(1).orders.capacity();
+    EXPECT_GE(capacity * 3, 1'000U * 4);
+
+    for (uint64_t order_id = 1; order_id <= 1'000; ++order_id) {
+        builder.addOrder(makeAdd(order_id, 'B', 100, 1));
+    }
+    EXPECT_EQ(builder.book(1).orders.capacity(), capacity);
+    EXPECT_EQ(builder.book(1).orders.size(), 1'000U);
+}
+
+// --- Same stream into an L2 and an L3 builder, level aggregates and L3 queues agree and the L2 updates verify ---
+TEST(L3OrderbookTest, MatchesL2Builder)
+{
+    ConcreteOrderbookBuilder l2;
+    ConcreteL3OrderbookBuilder l3;
+    algocor::BookVerifier verifier;
+    l2.setVerifier(&verifier);
+
+    struct Live {
+        uint64_t order_id;
+        char side;
+        uint64_t qty;
+    };
+    std::vector<Live> live;
+    std::mt19937 rng(17);
+
+    for (uint64_t order_id = 1; order_id <= 5'000; ++order_id) {
+        const bool is_bid = (rng() & 1) != 0;
+        const auto price = is_bid ? 1'000 - static_cast<int32_t>(rng() % 20) : 1'001 + static_cast<int32_t>(rng() % 20);
+        const auto add = makeAdd(order_id, is_bid ? 'B' : 'S', price, 1 + rng() % 100, 0);
+        l2.addOrder(add);
+        l3.addOrder(add);
+        live.push_back({ order_id, is_bid ? 'B' : 'S', AddOrderView { add }.quantity() });
+
+        if (rng() % 2 == 0) {
+            const auto index = rng() % live.size();
+            auto& order = live[index];
+            const auto dice = rng() % 3;
+            if (dice == 0) {
+                const auto qty = 1 + rng() % order.qty;
+                l2.executeOrder(makeExecute(order.order_id, order.side, qty));
+                l3.executeOrder(makeExecute(order.order_id, order.side, qty));
+                order.qty -= qty;
+            } else if (dice == 1) {
+                const auto offset = static_cast<int32_t>(rng() % 20);
+                const auto new_price = order.side == 'B' ? 1'000 - offset : 1'001 + offset;
+                const auto replace = makeReplace(order.order_id, order.side, new_price, 1 + rng() % 100, 0);
+                l2.replaceOrder(replace);
+                l3.replaceOrder(replace);
+                order.qty = OrderReplaceView { replace }.quantity();
+            } else {
+                l2.deleteOrder(makeDelete(order.order_id, order.side));
+                l3.deleteOrder(makeDelete(order.order_id, order.side));
+                order.qty = 0;
+            }
+            if (order.qty == 0) {
+                order = live.back();
+                live.pop_back();
+            }
+        }
+    }
+
+    const auto& l2_book = l2.getOrderbook(1);
+    const auto& l3_book = l3.getOrderbook(1);
+    const auto check_side = [&](char side, const auto& levels) {
+        levels.forEach([&](int32_t price, uint64_t qty) {
+            const auto* level = l3_book.Level(side, price);
+            ASSERT_NE(level, nullptr);
+            EXPECT_EQ(level->qty, qty);
+
+            uint64_t queued = 0;
+            uint32_t count = 0;
+            l3_book.ForEachOrder(l3.m_orders, side, price, [&](const L3Order& order) {
+                queued += order.left_qty;
+                ++count;
+            });
+            EXPECT_EQ(queued, qty);
+            EXPECT_EQ(count, level->count);
+        });
+    };
+    check_side('B', l2_book.Bids());
+    check_side('S', l2_book.Asks());
+    EXPECT_EQ(l3_book.GetBestPrices(), l2_book.GetBestPrices());
+    EXPECT_EQ(l3.m_orders.size(), live.size());
+    EXPECT_EQ(l3.m_queueMismatches, 0U);
+
+    verifier.verifyPending();
+    EXPECT_EQ(verifier.divergences(), 0U);
+}
@@ -0,0 +1,424 @@
+#include "book_snapshot.hpp"
+#include "l2_orderbook.hpp"
+#include "level_arena.hpp"
+#include "level_search.hpp"
+#include "level_stores.hpp"
+#include "tick_ladder.hpp"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// --- Replays a random add / remove sequence against a std::map reference ---
+template<typename Ladder, bool IsBid>
+static void replayAgainstReference(Ladder& ladder, unsigned seed)
+{
+    std::map<int32_t, uint64_t> reference;
+    std::mt19937 rng(seed);
+
+    for (int i = 0; i < 50'000; ++i) {
+        // Drift the price center so the ladder has to re-anchor and spill into its overflow.
+        const int32_t center = 10'000 + (i / 5'000) * 300 * ((i / 20'000) % 2 ? -1 : 1);
+        const int32_t price = center + static_cast<int32_t>(rng() % 2'000) - 1'000;
+
+        if (rng() % 3 != 0 || reference.empty()) {
+            const uint64_t qty = 1 + rng() % 50;
+            ladder.add(price, qty);
+            reference[price] += qty;
+        } else {
+            auto iter = std::next(reference.begin(), static_cast<long>(rng() % reference.size()));
+            const uint64_t qty = 1 + rng() % (iter->second + 5);
+            ASSERT_TRUE(ladder.remove(iter->first, qty));
+            if (iter->second > qty) {
+                iter->second -= qty;
+            } else {
+                reference.erase(iter);
+            }
+        }
+
+        ASSERT_EQ(ladder.size(), reference.size());
+        if (!reference.empty()) {
+            const auto expected = IsBid ? *reference.rbegin() : *reference.begin();
+            ASSERT_EQ(ladder.best().first, expected.first) << "step " << i;
+            ASSERT_EQ(ladder.best().second, expected.second) << "step " << i;
+        }
+    }
+
+    EXPECT_FALSE(ladder.remove(-2'000'000'000, 1));
+
+    std::vector<std::pair<int32_t, uint64_t>> levels;
+    ladder.forEach([&](int32_t price, uint64_t qty) { levels.emplace_back(price, qty); });
+    std::vector<std::pair<int32_t, uint64_t>> expected(reference.begin(), reference.end());
+    if (IsBid) {
+        std::reverse(expected.begin(), expected.end());
+    }
+    EXPECT_EQ(levels, expected);
+}
+
+// --- Every level store policy must behave like the reference on both sides ---
+template<typename Policy>
+class LevelStoreTest : public ::testing::Test {};
+
+using LevelPolicies = ::testing::Types<algocor::SortedVectorPolicy,
+    algocor::BranchlessBinaryPolicy,
+    algocor::BPlusTreePolicy,
+    algocor::FixedArrayPolicy<16384>,
+    algocor::TopNPolicy<>,
+    algocor::TickLadderPolicy>;
+TYPED_TEST_SUITE(LevelStoreTest, LevelPolicies);
+
+TYPED_TEST(LevelStoreTest, BidsMatchReference)
+{
+    auto bids = std::make_unique<typename TypeParam::template Side<true>>();
+    replayAgainstReference<typename TypeParam::template Side<true>, true>(*bids, 1);
+}
+
+TYPED_TEST(LevelStoreTest, AsksMatchReference)
+{
+    auto asks = std::make_unique<typename TypeParam::template Side<false>>();
+    replayAgainstReference<typename TypeParam::template Side<false>, false>(*asks, 2);
+}
+
+TYPED_TEST(LevelStoreTest, OrderbookBestPrices)
+{
+    auto book = std::make_unique<BasicL2Orderbook<TypeParam>>();
+    using Book = BasicL2Orderbook<TypeParam>;
+    EXPECT_EQ(book->GetBestPrices(), std::make_pair(Book::NO_BID, Book::NO_ASK));
+
+    book->AddOrder('B', 1000, 100);
+    book->AddOrder('B', 1020, 150);
+    book->AddOrder('S', 1030, 200);
+    EXPECT_EQ(book->GetBestPrices(), std::make_pair(1020, 1030));
+
+    book->ExecuteOrder('B', 1020, 150);
+    EXPECT_EQ(book->GetBestPrices(), std::make_pair(1000, 1030));
+
+    book->ReplaceOrder('S', 1030, 200, 1030, 50);
+    EXPECT_EQ(book->Asks().best().second, 50U);
+
+    book->ReplaceOrder('S', 1030, 50, 1025, 50);
+    EXPECT_EQ(book->GetBestPrices(), std::make_pair(1000, 1025));
+    EXPECT_EQ(book->Asks().size(), 1U);
+}
+
+// A zero quantity adds no level, so the next add at that price creates one and the best is never an empty level.
+TYPED_TEST(LevelStoreTest, ZeroQuantityAddsNoLevel)
+{
+    auto bids = std::make_unique<typename TypeParam::template Side<true>>();
+    bids->add(1000, 0);
+    EXPECT_TRUE(bids->empty());
+    EXPECT_EQ(bids->size(), 0U);
+
+    bids->add(1000, 5);
+    bids->add(1010, 0);
+    EXPECT_EQ(bids->size(), 1U);
+    EXPECT_EQ(bids->best(), std::make_pair(1000, uint64_t { 5 }));
+
+    int32_t prices[4] {};
+    uint64_t qtys[4] {};
+    ASSERT_EQ(bids->top(4, prices, qtys), 1U);
+    EXPECT_EQ(prices[0], 1000);
+    EXPECT_EQ(qtys[0], 5U);
+
+    EXPECT_TRUE(bids->remove(1000, 5));
+    EXPECT_TRUE(bids->empty());
+    EXPECT_EQ(bids->size(), 0U);
+}
+
+// Applying only the published changes to a copy of the visible levels must reproduce the top of the book after every update.
+TYPED_TEST(LevelStoreTest, VisibleChangesFollowTop)
+{
+    using Book = BasicL2Orderbook<TypeParam>;
+    constexpr auto DEPTH = Book::VISIBLE_DEPTH;
+
+    auto book = std::make_unique<Book>();
+    std::map<int32_t, uint64_t> reference;
+    std::vector<std::pair<int32_t, uint64_t>> shadow(DEPTH);
+    std::mt19937 rng(7);
+    std::size_t published = 0;
+
+    for (int i = 0; i < 20'000; ++i) {
+        int32_t price;
+        if (rng() % 3 != 0 || reference.empty()) {
+            price = 1'000 + static_cast<int32_t>(rng() % 200);
+            const uint64_t qty = 1 + rng() % 50;
+            book->AddOrder('S', price, qty);
+            reference[price] += qty;
+        } else {
+            auto iter = std::next(reference.begin(), static_cast<long>(rng() % reference.size()));
+            price = iter->first;
+            const uint64_t qty = 1 + rng() % iter->second;
+            book->DeleteOrder('S', price, qty);
+            if ((iter->second -= qty) == 0) {
+                reference.erase(iter);
+            }
+        }
+
+        book->PublishVisibleChanges('S', price, [&](std::size_t level, int32_t level_price, uint64_t level_qty) {
+            ASSERT_LT(level, DEPTH);
+            shadow[level] = { level_price, level_qty };
+            ++published;
+        });
+
+        auto expected = reference.begin();
+        for (std::size_t level = 0; level < DEPTH; ++level) {
+            const auto want = expected != reference.end() ? *expected++ : std::pair<const int32_t, uint64_t> { 0, 0 };
+            ASSERT_EQ(shadow[level].first, want.first) << "step " << i << " level " << level;
+            ASSERT_EQ(shadow[level].second, want.second) << "step " << i << " level " << level;
+        }
+    }
+
+    // Updates below the visible depth are not published at all.
+    EXPECT_LT(published, 20'000U);
+    std::size_t deep_updates = 0;
+    book->AddOrder('S', 5'000, 1);
+    book->PublishVisibleChanges('S', 5'000, [&](std::size_t, int32_t, uint64_t) { ++deep_updates; });
+    EXPECT_EQ(deep_updates, 0U);
+}
+
+// Incrementally maintained features must match a recomputation from scratch after every update.
+TYPED_TEST(LevelStoreTest, FeaturesMatchRecomputation)
+{
+    constexpr unsigned FEATURES = algocor::FEATURE_MICRO_PRICE | algocor::FEATURE_TOP_IMBALANCE | algocor::FEATURE_ORDER_FLOW_IMBALANCE
+        | algocor::FEATURE_DEPTH_TO_PRICE;
+    auto book = std::make_unique<BasicL2Orderbook<TypeParam, FEATURES>>();
+
+    std::map<int32_t, uint64_t, std::greater<>> bids;
+    std::map<int32_t, uint64_t> asks;
+    std::mt19937 rng(11);
+    int64_t order_flow = 0;
+
+    const auto top_qty = [](const auto& levels) {
+        uint64_t total = 0;
+        auto iter = levels.begin();
+        for (int level = 0; level < 5 && iter != levels.end(); ++level, ++iter) {
+            total += iter->second;
+        }
+        return total;
+    };
+
+    for (int i = 0; i < 20'000; ++i) {
+        const bool is_bid = rng() % 2 == 0;
+        const auto best = [&]() -> std::pair<int32_t, uint64_t> {
+            if (is_bid) {
+                return bids.empty() ? std::make_pair(INT32_MIN, uint64_t { 0 }) : std::make_pair(bids.begin()->first, bids.begin()->second);
+            }
+            return asks.empty() ? std::make_pair(INT32_MAX, uint64_t { 0 }) : std::make_pair(asks.begin()->first, asks.begin()->second);
+        };
+        const auto old_best = best();
+
+        auto apply = [&](auto& levels) {
+            if (rng() % 3 != 0 || levels.empty()) {
+                const int32_t price = is_bid ? 990 - static_cast<int32_t>(rng() % 30) : 1'010 + static_cast<int32_t>(rng() % 30);
+                const uint64_t qty = 1 + rng() % 20;
+                book->AddOrder(is_bid ? 'B' : 'S', price, qty);
+                levels[price] += qty;
+                return;
+            }
+
+            auto iter = std::next(levels.begin(), static_cast<long>(rng() % levels.size()));
+            const uint64_t qty = 1 + rng() % iter->second;
+            if (rng() % 2 == 0) {
+                book->ExecuteOrder(is_bid ? 'B' : 'S', iter->first, qty);
+                if ((iter->second -= qty) == 0) {
+                    levels.erase(iter);
+                }
+            } else {
+                // Same price replace with a new quantity.
+                const uint64_t new_qty = rng() % 10;
+                book->ReplaceOrder(is_bid ? 'B' : 'S', iter->first, qty, iter->first, new_qty);
+                if ((iter->second = iter->second - qty + new_qty) == 0) {
+                    levels.erase(iter);
+                }
+            }
+        };
+        if (is_bid) {
+            apply(bids);
+        } else {
+            apply(asks);
+        }
+
+        const auto new_best = best();
+        const auto old_qty = static_cast<int64_t>(old_best.second);
+        const auto new_qty = static_cast<int64_t>(new_best.second);
+        if (is_bid) {
+            order_flow += (new_best.first >= old_best.first ? new_qty : 0) - (new_best.first <= old_best.first ? old_qty : 0);
+        } else {
+            order_flow += (new_best.first >= old_best.first ? old_qty : 0) - (new_best.first <= old_best.first ? new_qty : 0);
+        }
+
+        const auto& features = book->GetFeatures();
+        ASSERT_EQ(features.orderFlowImbalance(), order_flow) << "step " << i;
+
+        const auto bid_total = static_cast<double>(top_qty(bids));
+        const auto ask_total = static_cast<double>(top_qty(asks));
+        ASSERT_DOUBLE_EQ(features.topImbalance(), bid_total + ask_total == 0 ? 0.0 : (bid_total - ask_total) / (bid_total + ask_total));
+
+        if (!bids.empty() && !asks.empty()) {
+            const auto bid_qty = static_cast<double>(bids.begin()->second);
+            const auto ask_qty = static_cast<double>(asks.begin()->second);
+            ASSERT_DOUBLE_EQ(features.microPrice(),
+                (bids.begin()->first * ask_qty + asks.begin()->first * bid_qty) / (bid_qty + ask_qty));
+        }
+
+        uint64_t depth = 0;
+        auto iter = asks.begin();
+        for (int level = 0; level < 5 && iter != asks.end() && iter->first <= 1'020; ++level, ++iter) {
+            depth += iter->second;
+        }
+        ASSERT_EQ(features.depthToPrice('S', 1'020), depth) << "step " << i;
+    }
+}
+
+// A reader spinning on the seqlock must never observe a half-written snapshot.
+TEST(SeqlockTest, ReadersNeverSeeTornSnapshots)
+{
+    algocor::PublishedBookSnapshot<4> published;
+    std::atomic<bool> done { false };
+    std::atomic<uint64_t> torn { 0 };
+
+    std::thread reader([&]() {
+        while (!done.load(std::memory_order_relaxed)) {
+            const auto snapshot = published.load();
+            if (snapshot.sequence == 0) {
+                continue;  // nothing published yet.
+            }
+            for (std::size_t level = 0; level < 4; ++level) {
+                const auto expected = static_cast<int32_t>(snapshot.sequence) + static_cast<int32_t>(level);
+                if (snapshot.bid_prices[level] != expected || snapshot.ask_qtys[level] != snapshot.sequence) {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+
+    for (uint64_t sequence = 1; sequence <= 200'000; ++sequence) {
+        algocor::BookSnapshot<4> snapshot {};
+        snapshot.sequence = sequence;
+        snapshot.timestamp = sequence;
+        for (std::size_t level = 0; level < 4; ++level) {
+            snapshot.bid_prices[level] = static_cast<int32_t>(sequence + level);
+            snapshot.ask_qtys[level] = sequence;
+        }
+        published.store(snapshot);
+    }
+    done.store(true);
+    reader.join();
+
+    EXPECT_EQ(torn.load(), 0U);
+    EXPECT_EQ(published.version(), 200'000U);
+}
+
+// A small ladder window forces re-anchoring and the cold overflow path.
+TEST(TickLadderTest, ReanchorsAndSpillsToOverflow)
+{
+    algocor::TickLadder<true, 8> bids;
+    replayAgainstReference<decltype(bids), true>(bids, 3);
+
+    algocor::TickLadder<false, 8> asks;
+    replayAgainstReference<decltype(asks), false>(asks, 4);
+}
+
+// Most of the random book lives in the overflow, so demotion and promotion run constantly.
+TEST(TopNLevelsTest, HotLevelsAreTheBestLevels)
+{
+    algocor::TopNLevels<true, 4> bids;
+    replayAgainstReference<decltype(bids), true>(bids, 5);
+
+    algocor::TopNLevels<false, 4> asks;
+    for (int32_t price = 110; price > 100; --price) {
+        asks.add(price, 1);
+    }
+    EXPECT_EQ(asks.hotSize(), 4U);
+    EXPECT_EQ(asks.size(), 10U);
+
+    // Draining below N / 2 pulls the next best levels back in.
+    EXPECT_TRUE(asks.remove(101, 1));
+    EXPECT_TRUE(asks.remove(102, 1));
+    EXPECT_TRUE(asks.remove(103, 1));
+    EXPECT_EQ(asks.hotSize(), 4U);
+    EXPECT_EQ(asks.best(), std::make_pair(104, uint64_t { 1 }));
+}
+
+// Pooled level storage follows the depth of the book in both directions and recycles blocks between books.
+TEST(LevelArenaTest, BufferGrowsAndShrinksWithDepth)
+{
+    auto& arena = algocor::LevelArena::local();
+    const auto used_before = arena.usedBytes();
+
+    {
+        L2Orderbook book;
+        EXPECT_EQ(book.MemoryUsage(), sizeof(book));
+
+        for (int32_t price = 1; price <= 1'000; ++price) {
+            book.AddOrder('B', price, 10);
+        }
+        EXPECT_GE(book.Bids().memoryBytes(), 1'000 * algocor::LevelArena::BYTES_PER_LEVEL);
+        EXPECT_LT(book.Bids().memoryBytes(), 2 * 1'024 * algocor::LevelArena::BYTES_PER_LEVEL);
+        EXPECT_EQ(arena.usedBytes() - used_before, book.Bids().memoryBytes());
+
+        for (int32_t price = 1; price <= 995; ++price) {
+            book.DeleteOrder('B', price, 10);
+        }
+        EXPECT_EQ(book.Bids().size(), 5U);
+        EXPECT_EQ(book.Bids().memoryBytes(), algocor::LevelArena::blockBytes(1));  // 5 levels sit above a quarter of 16.
+        EXPECT_EQ(book.Bids().best().first, 1'000);
+    }
+
+    EXPECT_EQ(arena.usedBytes(), used_before);
+
+    // A freed block is the next one its size class hands out.
+    void* block = arena.allocate(0);
+    arena.deallocate(block, 0);
+    EXPECT_EQ(arena.allocate(0), block);
+    arena.deallocate(block, 0);
+
+    // A chunk's worth of freed blocks comes back without a new chunk, carving them again would need one.
+    std::vector<void*> blocks(algocor::LevelArena::CHUNK_BYTES / algocor::LevelArena::blockBytes(0) + 1);
+    for (auto& allocated : blocks) {
+        allocated = arena.allocate(0);
+    }
+    for (auto* allocated : blocks) {
+        arena.deallocate(allocated, 0);
+    }
+    const auto reserved = arena.reservedBytes();
+    for (auto& allocated : blocks) {
+        allocated = arena.allocate(0);
+    }
+    EXPECT_EQ(arena.reservedBytes(), reserved);
+    for (auto* allocated : blocks) {
+        arena.deallocate(allocated, 0);
+    }
+    EXPECT_EQ(arena.usedBytes(), used_before);
+}
+
+// --- Every SIMD kernel the CPU supports must agree with the scalar scan, including tails shorter than a vector ---
+TEST(LevelSearchTest, KernelsAgreeWithScalar)
+{
+    const auto simd = algocor::detectSimdLevel();
+
+    for (std::size_t depth = 0; depth <= 70; ++depth) {
+        std::vector<int32_t> prices(depth);
+        for (std::size_t i = 0; i < depth; ++i) {
+            prices[i] = 1'000 + static_cast<int32_t>(i) * 5;
+        }
+
+        for (int32_t price = 995; price <= 1'000 + static_cast<int32_t>(depth) * 5; ++price) {
+            const auto expected = algocor::findPriceLevelScalar(prices.data(), depth, price);
+            EXPECT_EQ(algocor::findPriceLevel(prices.data(), depth, price), expected);
+            if (simd != algocor::SimdLevel::Scalar) {
+                EXPECT_EQ(algocor::findPriceLevelAvx2(prices.data(), depth, price), expected);
+            }
+            if (simd == algocor::SimdLevel::Avx512) {
+                EXPECT_EQ(algocor::findPriceLevelAvx512(prices.data(), depth, price), expected);
+            }
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#include "../core/order_index.hpp"
+#include "../core/slab_pool.hpp"
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using algocor::FlatOrderIndex;
+using algocor::OrderKey;
+using algocor::SlabPool;
+
+// --- Random adds, overwrites and deletes against std::map, including growth and long clusters ---
+TEST(OrderIndexTest, MatchesReference)
+{
+    FlatOrderIndex<uint64_t> index;
+    std::map<std::tuple<uint32_t, uint64_t, char>, uint64_t> reference;
+
+    std::mt19937_64 rng(3);
+    for (int step = 0; step < 200'000; ++step) {
+        // Few distinct keys, so the table both grows and gets deleted into.
+        const OrderKey key { 1 + rng() % 20'000, static_cast<uint32_t>(1 + rng() % 4), (rng() & 1) != 0 ? 'B' : 'S' };
+        const auto ref_key = std::make_tuple(key.orderbook_id, key.order_id, key.side);
+
+        if (rng() % 3 != 0) {
+            const auto value = rng();
+            index.insert(key, value);
+            reference[ref_key] = value;
+        } else {
+            EXPECT_EQ(index.erase(key), reference.erase(ref_key) == 1);
+        }
+
+        const auto* entry = index.find(key);
+        const auto ref = reference.find(ref_key);
+        ASSERT_EQ(entry != nullptr, ref != reference.end());
+        if (entry != nullptr) {
+            EXPECT_EQ(entry->value, ref->second);
+        }
+    }
+
+    ASSERT_EQ(index.size(), reference.size());
+    for (const auto& [ref_key, value] : reference) {
+        const auto* entry = index.find({ std::get<1>(ref_key), std::get<0>(ref_key), std::get<2>(ref_key) });
+        ASSERT_NE(entry, nullptr);
+        EXPECT_EQ(entry->value, value);
+    }
+
+    std::size_t visited = 0;
+    index.forEach([&](const auto&) { ++visited; });
+    EXPECT_EQ(visited, reference.size());
+}
+
+// --- The same order id on another book or side is another order ---
+TEST(OrderIndexTest, KeyIncludesBookAndSide)
+{
+    FlatOrderIndex<int> index;
+    index.insert({ 42, 1, 'B' }, 1);
+    index.insert({ 42, 1, 'S' }, 2);
+    index.insert({ 42, 2, 'B' }, 3);
+    EXPECT_EQ(index.size(), 3U);
+
+    EXPECT_TRUE(index.erase({ 42, 1, 'S' }));
+    EXPECT_FALSE(index.erase({ 42, 1, 'S' }));
+    EXPECT_EQ(index.find({ 42, 1, 'B' })->value, 1);
+    EXPECT_EQ(index.find({ 42, 2, 'B' })->value, 3);
+
+    index.reserve(1'000);
+    EXPECT_GE(index.capacity() * 3, 1'000U * 4);
+    EXPECT_EQ(index.find({ 42, 1, 'B' })->value, 1);
+}
+
+// --- Handles stay valid across slabs, released records are reused last in, first out ---
+TEST(SlabPoolTest, StableHandlesAndLifoReuse)
+{
+    struct Record {
+        uint64_t a;
+        uint64_t b;
+    };
+
+    SlabPool<Record> pool;
+    std::vector<SlabPool<Record>::Handle> handles;
+    const auto count = SlabPool<Record>::RECORDS_PER_SLAB * 2 + 10;
+    for (uint64_t i = 0; i < count; ++i) {
+        handles.push_back(pool.allocate());
+        pool.get(handles.back()) = { i, ~i };
+    }
+    EXPECT_EQ(pool.size(), count);
+    EXPECT_EQ(pool.reservedBytes(), 3 * SlabPool<Record>::SLAB_BYTES);
+
+    for (uint64_t i = 0; i < count; ++i) {
+        EXPECT_EQ(pool.get(handles[i]).a, i);
+        EXPECT_EQ(pool.get(handles[i]).b, ~i);
+    }
+
+    pool.release(handles[5]);
+    pool.release(handles[count - 1]);
+    EXPECT_EQ(pool.allocate(), handles[count - 1]);
+    EXPECT_EQ(pool.allocate(), handles[5]);
+    EXPECT_EQ(pool.reservedBytes(), 3 * SlabPool<Record>::SLAB_BYTES);
+    EXPECT_EQ(pool.get(handles[6]).a, 6U);
+}
@@ -0,0 +1,72 @@
+#include "../core/orderbook_builder.hpp"
+#include "../core/orderbook_registry.hpp"
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+using algocor::OrderbookRegistry;
+using namespace algocor::protocol::itch;
+
+// --- Sparse ids get dense indexes in the order they are first seen, symbols map back to them ---
+TEST(OrderbookRegistryTest, DenseIndexesAndSymbols)
+{
+    OrderbookRegistry registry;
+    std::unordered_map<uint32_t, OrderbookRegistry::Index> reference;
+
+    std::mt19937 rng(5);
+    for (int step = 0; step < 5'000; ++step) {
+        const auto orderbook_id = static_cast<uint32_t>(rng());
+        const auto index = registry.registerBook(orderbook_id);
+        const auto [it, inserted] = reference.try_emplace(orderbook_id, static_cast<OrderbookRegistry::Index>(reference.size()));
+        EXPECT_EQ(index, it->second);
+    }
+    ASSERT_EQ(registry.size(), reference.size());
+    for (const auto& [orderbook_id, index] : reference) {
+        EXPECT_EQ(registry.find(orderbook_id), index);
+        EXPECT_EQ(registry.orderbookId(index), orderbook_id);
+    }
+
+    const auto garan = registry.registerBook(70'616, "GARAN.E   ");
+    EXPECT_EQ(registry.symbol(garan), "GARAN.E");
+    EXPECT_EQ(registry.findSymbol("GARAN.E"), garan);
+    EXPECT_EQ(registry.findSymbol("THYAO.E"), OrderbookRegistry::NO_BOOK);
+
+    // An id seen before its directory message keeps its index and gets named.
+    const auto first = registry.find(reference.begin()->first);
+    EXPECT_EQ(registry.registerBook(reference.begin()->first, "AKBNK.E"), first);
+    EXPECT_EQ(registry.findSymbol("AKBNK.E"), first);
+}
+
+// --- 'R' messages register books ahead of their orders, orders for unannounced books still create them ---
+TEST(OrderbookRegistryTest, BuilderRegistersBooks)
+{
+    ConcreteOrderbookBuilder builder;
+
+    OrderBookDirectory directory {};
+    directory.orderbook_id = { htobe32(78'436) };
+    std::memset(directory.symbol.data(), ' ', directory.symbol.size());
+    std::memcpy(directory.symbol.data(), "THYAO.E", 7);
+    builder.orderbookDirectory(directory);
+
+    const auto& registry = builder.registry();
+    const auto thyao = registry.findSymbol("THYAO.E");
+    ASSERT_NE(thyao, OrderbookRegistry::NO_BOOK);
+    EXPECT_EQ(registry.orderbookId(thyao), 78'436U);
+    EXPECT_EQ(builder.getOrderbook(78'436).GetBestPrices(), std::make_pair(L2Orderbook::NO_BID, L2Orderbook::NO_ASK));
+
+    AddOrder add {};
+    add.order_id = { htobe64(1) };
+    add.orderbook_id = { htobe32(12) };
+    add.side = algocor::Side::Buy;
+    add.quantity = { htobe64(10) };
+    add.price = { static_cast<int32_t>(htobe32(250)) };
+    builder.addOrder(add);
+    EXPECT_EQ(registry.find(12), thyao + 1);
+    EXPECT_EQ(registry.symbol(thyao + 1), "");
+    EXPECT_EQ(builder.getOrderbook(12).BestLevel('B'), std::make_pair(250, uint64_t { 10 }));
+
+    EXPECT_THROW(static_cast<void>(builder.getOrderbook(13)), std::out_of_range);
+    EXPECT_FALSE(builder.hasOrder(13, 1, 'B'));
+}
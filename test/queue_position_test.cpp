@@ -0,0 +1,134 @@
+#include "../core/orderbook_builder.hpp"
+#include "../core/own_orders.hpp"
+#include "itch_test_messages.hpp"
+#include <gtest/gtest.h>
+
+using namespace algocor::protocol::itch;
+using namespace algocor::test;
+
+namespace
+{
+
+// Own orders 3 and 6 on the bid at 100, between market orders that join ahead of and behind them.
+template<typename Builder>
+void checkQueueAhead()
+{
+    algocor::OwnOrderMap own_orders;
+    Builder builder;
+    builder.setOwnOrders(&own_orders);
+    uint64_t sequence = 0;
+    // The handler without a book index, the builder overloads each of them.
+    const auto apply = [&]<typename Message>(const auto& message, void (Builder::*handler)(Message)) {
+        builder.setSequence(++sequence);
+        (builder.*handler)(message);
+    };
+
+    apply(makeAdd(1, 'B', 100, 10), &Builder::addOrder);
+    apply(makeAdd(2, 'B', 100, 20), &Builder::addOrder);
+    // Accepted by OUCH before its ITCH add: everything at the price is ahead.
+    own_orders.insert(3, 7, 1, 'B');
+    EXPECT_EQ(own_orders.queueAhead(3), algocor::OwnOrderMap::UNKNOWN);
+    apply(makeAdd(3, 'B', 100, 5), &Builder::addOrder);
+    EXPECT_EQ(own_orders.queueAhead(3), 30U);
+
+    // Orders that join behind it do not move it.
+    apply(makeAdd(4, 'B', 100, 40), &Builder::addOrder);
+    apply(makeDelete(4, 'B'), &Builder::deleteOrder);
+    EXPECT_EQ(own_orders.queueAhead(3), 30U);
+
+    apply(makeExecute(1, 'B', 4), &Builder::executeOrder);
+    EXPECT_EQ(own_orders.queueAhead(3), 26U);
+    apply(makeDelete(2, 'B'), &Builder::deleteOrder);
+    EXPECT_EQ(own_orders.queueAhead(3), 6U);
+    // A smaller quantity keeps its place, a new price takes the order out of the queue.
+    apply(makeReplace(1, 'B', 100, 2), &Builder::replaceOrder);
+    EXPECT_EQ(own_orders.queueAhead(3), 2U);
+    apply(makeReplace(1, 'B', 101, 2), &Builder::replaceOrder);
+    EXPECT_EQ(own_orders.queueAhead(3), 0U);
+
+    // Accepted after its add: placed behind everything at the price, the other own order included.
+    apply(makeAdd(5, 'B', 100, 8), &Builder::addOrder);
+    apply(makeAdd(6, 'B', 100, 7), &Builder::addOrder);
+    own_orders.insert(6, 8, 1, 'B');
+    builder.setSequence(++sequence);
+    EXPECT_EQ(own_orders.queueAhead(6), 13U);
+    EXPECT_EQ(own_orders.queueAhead(3), 0U);
+
+    apply(makeDelete(3, 'B'), &Builder::deleteOrder);
+    EXPECT_EQ(own_orders.queueAhead(3), algocor::OwnOrderMap::UNKNOWN);
+    EXPECT_EQ(own_orders.queueAhead(6), 8U);
+
+    // Our own partial fill means nothing is left ahead; a full one ends the tracking.
+    apply(makeExecute(6, 'B', 3), &Builder::executeOrder);
+    EXPECT_EQ(own_orders.queueAhead(6), 0U);
+    apply(makeExecute(6, 'B', 4), &Builder::executeOrder);
+    EXPECT_EQ(own_orders.queueAhead(6), algocor::OwnOrderMap::UNKNOWN);
+    EXPECT_EQ(own_orders.queueAhead(5), algocor::OwnOrderMap::UNKNOWN);
+}
+
+// Own order 2 rests at 100 while more than 255 own orders join and leave another book, then own order 4 joins behind it. The market
+// order between them must not take the epoch of own order 2 for the one of own order 4.
+template<typename Builder>
+void checkEpochsAfterManyJoins()
+{
+    algocor::OwnOrderMap own_orders;
+    Builder builder;
+    builder.setOwnOrders(&own_orders);
+    uint64_t sequence = 0;
+    const auto apply = [&]<typename Message>(const auto& message, void (Builder::*handler)(Message)) {
+        builder.setSequence(++sequence);
+        (builder.*handler)(message);
+    };
+
+    apply(makeAdd(1, 'B', 100, 10), &Builder::addOrder);
+    own_orders.insert(2, 1, 1, 'B');
+    apply(makeAdd(2, 'B', 100, 5), &Builder::addOrder);
+    apply(makeAdd(3, 'B', 100, 20), &Builder::addOrder);
+    for (uint32_t join = 0; join < 254; ++join) {
+        const uint64_t order_id = 1000 + join;
+        own_orders.insert(order_id, 2 + join, 2, 'B');
+        apply(makeAdd(order_id, 'B', 100, 1, 0, 2), &Builder::addOrder);
+        apply(makeDelete(order_id, 'B', 2), &Builder::deleteOrder);
+    }
+    own_orders.insert(4, 300, 1, 'B');
+    apply(makeAdd(4, 'B', 100, 7), &Builder::addOrder);
+    EXPECT_EQ(own_orders.queueAhead(2), 10U);
+    EXPECT_EQ(own_orders.queueAhead(4), 35U);
+
+    apply(makeDelete(3, 'B'), &Builder::deleteOrder);
+    EXPECT_EQ(own_orders.queueAhead(2), 10U);
+    EXPECT_EQ(own_orders.queueAhead(4), 15U);
+}
+
+}  // namespace
+
+TEST(QueuePositionTest, L2BookTracksQueueAhead)
+{
+    checkQueueAhead<ConcreteOrderbookBuilder>();
+}
+
+TEST(QueuePositionTest, L3BookTracksQueueAhead)
+{
+    checkQueueAhead<ConcreteL3OrderbookBuilder>();
+}
+
+TEST(QueuePositionTest, EpochsStayUniqueAfterManyJoins)
+{
+    checkEpochsAfterManyJoins<ConcreteOrderbookBuilder>();
+    checkEpochsAfterManyJoins<ConcreteL3OrderbookBuilder>();
+}
+
+TEST(QueuePositionTest, ErasedOrdersAreUnknown)
+{
+    algocor::OwnOrderMap own_orders;
+    EXPECT_FALSE(own_orders.insert(0, 1, 1, 'B'));
+    EXPECT_TRUE(own_orders.insert(42, 1, 1, 'B'));
+    EXPECT_FALSE(own_orders.insert(42, 2, 1, 'B'));
+    EXPECT_EQ(own_orders.inserted(), 1U);
+    EXPECT_EQ(own_orders.entry(0).token, 1U);
+    EXPECT_TRUE(own_orders.entry(0).live());
+
+    own_orders.erase(42);
+    EXPECT_FALSE(own_orders.entry(0).live());
+    EXPECT_EQ(own_orders.queueAhead(42), algocor::OwnOrderMap::UNKNOWN);
+}
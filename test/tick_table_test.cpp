@@ -0,0 +1,88 @@
+#include "../core/orderbook_builder.hpp"
+#include "../core/tick_table.hpp"
+#include "itch_parser.hpp"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using namespace algocor::protocol::itch;
+
+namespace
+{
+
+// BIST equity bands with prices in kuruş: 0.01 TL below 20 TL, 0.02 TL below 50 TL and so on up to 2.50 TL from 2500 TL.
+const std::vector<std::pair<int32_t, int64_t>> EQUITY_BANDS
+    = { { 0, 1 }, { 2000, 2 }, { 5000, 5 }, { 10000, 10 }, { 25000, 25 }, { 50000, 50 }, { 100000, 100 }, { 250000, 250 } };
+
+}  // namespace
+
+TEST(TickTableTest, ConvertsAcrossBands)
+{
+    algocor::TickTable table;
+    EXPECT_EQ(table.tickIndex(1234), 1234);  // identity until bands are known.
+
+    // Out of order on purpose, bands are kept sorted.
+    for (const auto index : { 3, 0, 7, 1, 5, 2, 6, 4 }) {
+        EXPECT_TRUE(table.addBand(EQUITY_BANDS[index].first, EQUITY_BANDS[index].second));
+    }
+    EXPECT_EQ(table.bands(), EQUITY_BANDS.size());
+
+    EXPECT_EQ(table.tickIndex(1999), 1999);
+    EXPECT_EQ(table.tickIndex(2000), 2000);
+    EXPECT_EQ(table.tickIndex(2002), 2001);
+    EXPECT_EQ(table.tickIndex(2003), 2001);  // between two ticks.
+    EXPECT_EQ(table.tickIndex(5000), 3500);
+    EXPECT_EQ(table.tickSize(9995), 5);
+    EXPECT_EQ(table.tickSize(10000), 10);
+    EXPECT_EQ(table.ticksAway(1999, 1), 2000);
+    EXPECT_EQ(table.ticksAway(2000, 1), 2002);
+    EXPECT_EQ(table.ticksAway(5000, -1), 4998);
+    EXPECT_EQ(table.ticksAway(249900, 2), 250250);
+
+    // Every price on the grid maps to consecutive tick numbers and back.
+    int32_t expected_index = 0;
+    for (std::size_t band = 0; band < EQUITY_BANDS.size(); ++band) {
+        const auto [from, tick_size] = EQUITY_BANDS[band];
+        const auto to = band + 1 < EQUITY_BANDS.size() ? EQUITY_BANDS[band + 1].first : from + 100 * static_cast<int32_t>(tick_size);
+        for (auto price = from; price < to; price += static_cast<int32_t>(tick_size)) {
+            ASSERT_EQ(table.tickIndex(price), expected_index) << price;
+            ASSERT_EQ(table.priceOf(expected_index), price) << price;
+            ++expected_index;
+        }
+    }
+}
+
+TEST(TickTableTest, RejectsBadBands)
+{
+    algocor::TickTable table;
+    EXPECT_FALSE(table.addBand(0, 0));
+    for (int32_t band = 0; band < static_cast<int32_t>(algocor::TickTable::MAX_BANDS); ++band) {
+        EXPECT_TRUE(table.addBand(band * 100, band + 1));
+    }
+    EXPECT_FALSE(table.addBand(1'000'000, 1));
+    EXPECT_TRUE(table.addBand(0, 2));  // changing a band is fine when full.
+    EXPECT_EQ(table.tickSize(50), 2);
+}
+
+TEST(TickTableTest, BuilderCollectsTickSizeMessages)
+{
+    ConcreteOrderbookBuilder builder;
+    ItchParser<ConcreteOrderbookBuilder> parser(builder);
+
+    uint64_t sequence = 1;
+    for (const auto& [from, tick_size] : EQUITY_BANDS) {
+        TickSizeTableEntry entry {};
+        entry.type = algocor::MessageType::TickSizeTableEntry;
+        entry.orderbook_id = { htobe32(7) };
+        entry.tick_size = { htobe64(static_cast<uint64_t>(tick_size)) };
+        entry.price_from = { static_cast<int32_t>(htobe32(static_cast<uint32_t>(from))) };
+        parser.parseMessage(reinterpret_cast<const char*>(&entry), sequence++);
+    }
+
+    const auto& table = builder.tickTable(7);
+    EXPECT_EQ(table.bands(), EQUITY_BANDS.size());
+    EXPECT_EQ(table.ticksAway(4998, 1), 5000);
+    EXPECT_EQ(builder.tickTable(8).bands(), 0U);  // identity.
+    EXPECT_EQ(builder.tickTable(8).ticksAway(4998, 1), 4999);
+}
@@ -0,0 +1,94 @@
+#include "../core/orderbook_builder.hpp"
+#include "../core/trade_tape.hpp"
+#include <gtest/gtest.h>
+
+using namespace algocor::protocol::itch;
+
+// --- Session and window statistics follow the prints, the window forgets what falls out of the ring ---
+TEST(TradeTapeTest, RollingStatistics)
+{
+    algocor::TradeTape<4> tape;
+    EXPECT_EQ(tape.size(), 0U);
+    EXPECT_EQ(tape.vwap(), 0.0);
+
+    const int32_t prices[] = { 100, 104, 98, 101, 103, 99 };
+    for (uint64_t i = 0; i < 6; ++i) {
+        tape.record({ i, i, 10 * (i + 1), prices[i], 'B' });
+    }
+
+    EXPECT_EQ(tape.tradeCount(), 6U);
+    EXPECT_EQ(tape.size(), 4U);
+    EXPECT_EQ(tape.open(), 100);
+    EXPECT_EQ(tape.high(), 104);
+    EXPECT_EQ(tape.low(), 98);
+    EXPECT_EQ(tape.last(), 99);
+    EXPECT_EQ(tape.volume(), 210U);
+    EXPECT_DOUBLE_EQ(tape.vwap(), (100.0 * 10 + 104 * 20 + 98 * 30 + 101 * 40 + 103 * 50 + 99 * 60) / 210);
+
+    // The window holds the last four prints.
+    EXPECT_EQ(tape.windowVolume(), 180U);
+    EXPECT_DOUBLE_EQ(tape.windowVwap(), (98.0 * 30 + 101 * 40 + 103 * 50 + 99 * 60) / 180);
+    EXPECT_EQ(tape.lastPrint().price, 99);
+    EXPECT_EQ(tape[3].price, 98);
+
+    tape.reset();
+    EXPECT_EQ(tape.tradeCount(), 0U);
+    EXPECT_EQ(tape.windowVolume(), 0U);
+}
+
+// --- 'E', printable 'C' and 'P' go on the tape, 'F' rests in the book like 'A' ---
+TEST(TradeTapeTest, BuilderRecordsPrints)
+{
+    ConcreteOrderbookBuilder builder;
+
+    AddOrderWithMPID add {};
+    add.order_id = { htobe64(1) };
+    add.orderbook_id = { htobe32(3) };
+    add.side = algocor::Side::Sell;
+    add.quantity = { htobe64(100) };
+    add.price = { static_cast<int32_t>(htobe32(500)) };
+    add.participant_id = { 'M', 'E', 'M', 'B', 'E', 'R', '1' };
+    builder.addOrderWithMPID(add);
+    ASSERT_TRUE(builder.hasOrder(3, 1, 'S'));
+    EXPECT_EQ(builder.getOrder(3, 1, 'S').price, 500);
+
+    OrderExecuted executed {};
+    executed.order_id = { htobe64(1) };
+    executed.orderbook_id = { htobe32(3) };
+    executed.side = algocor::Side::Sell;
+    executed.quantity = { htobe64(10) };
+    executed.match_id = { htobe64(77) };
+    builder.executeOrder(executed);
+
+    OrderExecutedWithPrice with_price {};
+    with_price.order_id = { htobe64(1) };
+    with_price.orderbook_id = { htobe32(3) };
+    with_price.side = algocor::Side::Sell;
+    with_price.quantity = { htobe64(20) };
+    with_price.trade_price = { static_cast<int32_t>(htobe32(495)) };
+    with_price.printable = algocor::Printable::Yes;
+    builder.executeOrderWithPrice(with_price);
+
+    with_price.printable = algocor::Printable::No;
+    builder.executeOrderWithPrice(with_price);
+
+    Trade trade {};
+    trade.orderbook_id = { htobe32(3) };
+    trade.side = algocor::Side::Buy;
+    trade.quantity = { htobe64(5) };
+    trade.trade_price = { static_cast<int32_t>(htobe32(510)) };
+    trade.printable = algocor::Printable::Yes;
+    builder.trade(trade);
+
+    const auto& tape = builder.tradeTape(3);
+    EXPECT_EQ(tape.tradeCount(), 3U);
+    EXPECT_EQ(tape.volume(), 35U);
+    EXPECT_EQ(tape.open(), 500);
+    EXPECT_EQ(tape.low(), 495);
+    EXPECT_EQ(tape.high(), 510);
+    EXPECT_EQ(tape[2].match_id, 77U);
+
+    // The non printable execution still left the book.
+    EXPECT_EQ(builder.getOrder(3, 1, 'S').left_qty, 50U);
+    EXPECT_EQ(builder.getOrderbook(3).BestLevel('S'), std::make_pair(500, uint64_t { 50 }));
+}
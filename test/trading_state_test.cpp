@@ -0,0 +1,85 @@
+#include "../core/orderbook_builder.hpp"
+#include "../core/trading_state.hpp"
+#include "itch_parser.hpp"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string_view>
+
+using namespace algocor::protocol::itch;
+
+namespace
+{
+
+OrderBookState makeState(uint32_t orderbook_id, std::string_view name)
+{
+    OrderBookState state {};
+    state.type = algocor::MessageType::OrderbookState;
+    state.orderbook_id = { htobe32(orderbook_id) };
+    state.state_name.fill(' ');
+    std::copy_n(name.begin(), std::min(name.size(), state.state_name.size()), state.state_name.begin());
+    return state;
+}
+
+}  // namespace
+
+TEST(TradingStateTest, ClassifiesStateNames)
+{
+    using algocor::TradingPhase;
+    EXPECT_EQ(algocor::tradingPhaseOf("P_SUREKLI_ISLEM"), TradingPhase::Continuous);
+    EXPECT_EQ(algocor::tradingPhaseOf("F_SUREKLI_ISLEM"), TradingPhase::Continuous);
+    EXPECT_EQ(algocor::tradingPhaseOf("P_ACILIS_EMIR_TOPLAM"), TradingPhase::Auction);  // cut to the field.
+    EXPECT_EQ(algocor::tradingPhaseOf("P_KAPANIS_ESLESTIRME"), TradingPhase::Auction);
+    EXPECT_EQ(algocor::tradingPhaseOf("P_DURDURMA"), TradingPhase::Halted);
+    EXPECT_EQ(algocor::tradingPhaseOf("P_ISLEME_KAPALI"), TradingPhase::Closed);
+    EXPECT_EQ(algocor::tradingPhaseOf("P_BILINMEYEN"), TradingPhase::Unknown);
+}
+
+TEST(TradingStateTest, BuilderFollowsStatesAndAuctions)
+{
+    ConcreteOrderbookBuilder builder;
+    ItchParser<ConcreteOrderbookBuilder> parser(builder);
+    uint64_t sequence = 1;
+    const auto parse = [&](const auto& message) { parser.parseMessage(reinterpret_cast<const char*>(&message), sequence++); };
+
+    EXPECT_EQ(builder.tradingPhase(5), algocor::TradingPhase::Unknown);
+    parse(makeState(5, "P_ACILIS_EMIR_TOPLAMA"));  // cut to P_ACILIS_EMIR_TOPLAM.
+    parse(makeState(6, "P_SUREKLI_ISLEM"));
+    const auto index = builder.registry().find(5);
+    const auto& states = builder.tradingStates();
+    EXPECT_EQ(states.phase(index), algocor::TradingPhase::Auction);
+    EXPECT_TRUE(states.isContinuous(builder.registry().find(6)));
+
+    EquilibriumPriceUpdate update {};
+    update.type = algocor::MessageType::EquilibriumPriceUpdate;
+    update.orderbook_id = { htobe32(5) };
+    update.available_bid_quantity = { htobe64(300) };
+    update.available_ask_quantity = { htobe64(250) };
+    update.equilibrium_price = { static_cast<int32_t>(htobe32(1005)) };
+    update.best_bid_price = { static_cast<int32_t>(htobe32(1010)) };
+    update.best_ask_price = { static_cast<int32_t>(htobe32(1000)) };
+    update.best_bid_quantity = { htobe64(40) };
+    update.best_ask_quantity = { htobe64(60) };
+    parse(update);
+
+    auto auction = states.auction(index);
+    EXPECT_EQ(auction.equilibrium_price, 1005);
+    EXPECT_EQ(auction.bid_qty_at_equilibrium, 300U);
+    EXPECT_EQ(auction.ask_qty_at_equilibrium, 250U);
+    EXPECT_EQ(auction.best_bid_price, 1010);
+    EXPECT_EQ(auction.best_ask_qty, 60U);
+
+    // Opening: the auction state goes with the auction.
+    parse(makeState(5, "P_SUREKLI_ISLEM"));
+    EXPECT_TRUE(states.isContinuous(index));
+    auction = states.auction(index);
+    EXPECT_EQ(auction.equilibrium_price, 0);
+    EXPECT_EQ(auction.bid_qty_at_equilibrium, 0U);
+
+    SystemEvent end_of_messages {};
+    end_of_messages.type = algocor::MessageType::SystemEvent;
+    end_of_messages.event_code = algocor::EventCode::EndOfMessages;
+    parse(end_of_messages);
+    EXPECT_EQ(builder.tradingPhase(5), algocor::TradingPhase::Closed);
+    EXPECT_EQ(builder.tradingPhase(6), algocor::TradingPhase::Closed);
+}